@@ -9,8 +9,13 @@
  */
 
 #include <QDataStream>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstring>
+#include <thread>
 #include "deconz/dbg_trace.h"
+#include "deconz/u_bstream.h"
 #include "deconz/aps.h"
 #include "aps_private.h"
 #include "deconz/mem_pool.h"
@@ -85,6 +90,49 @@ public:
     bool confirmed = false;
 };
 
+/*! Fixed size ASDU storage, shared by copies of a ApsDataIndication. */
+class ApsAsduBuffer
+{
+public:
+    static constexpr int PoolSize = 32; // for ApsMemory
+    static constexpr int MaxSize = 128;
+
+    std::atomic<int> ref{0};
+    std::array<uint8_t, MaxSize> data;
+};
+
+class ApsDataIndicationPrivate
+{
+public:
+    static constexpr int PoolSize = 16; // for ApsMemory
+
+    ApsDataIndicationPrivate() = default;
+    ApsDataIndicationPrivate(const ApsDataIndicationPrivate &other);
+    ApsDataIndicationPrivate &operator=(const ApsDataIndicationPrivate &other);
+    ~ApsDataIndicationPrivate();
+    ApsAddressMode dstAddrMode = ApsNoAddress;
+    Address dstAddr{};
+    uint8_t dstEndpoint = 0xFF;
+    ApsAddressMode srcAddrMode = ApsNoAddress;
+    Address srcAddr{};
+    uint8_t srcEndpoint = 0xFF;
+    uint16_t profileId = 0xFFFF;
+    uint16_t clusterId = 0xFFFF;
+    QByteArray asdu; //!< Raw data view into asduBuf, unless modified or set via setAsdu().
+    quint16 previousHop = 0xFFFF;
+    uint8_t status = 0xFF;
+    uint8_t securityStatus = 0xFF;
+    uint8_t linkQuality = 0xFF;
+    uint32_t rxTime = 0;
+    int8_t rssi = 0;
+    int version = 1;
+    ApsAsduBuffer *asduBuf = nullptr;
+    void reset();
+    void copyAsdu(const ApsDataIndicationPrivate &other);
+    void releaseAsdu();
+    uint8_t *writableAsdu();
+};
+
 static ApsMemory *apsMem = nullptr;
 static ApsMemoryPrivate *apsMemPriv = nullptr;
 
@@ -94,16 +142,50 @@ public:
     ~ApsMemoryPrivate();
 
     std::tuple<
-        std::array<ApsDataRequestPrivate*, ApsDataRequestPrivate::PoolSize>
+        MEM_Pool<ApsDataRequestPrivate>,
+        MEM_Pool<ApsDataIndicationPrivate>,
+        MEM_Pool<ApsAsduBuffer>
     > mem{};
+    std::thread::id owner; //!< The pools are only used by the thread which created ApsMemory.
 };
 
-ApsMemoryPrivate::~ApsMemoryPrivate()
+/*! Allocates a private object, from the pool when called on the owning thread. */
+template <typename T>
+static T *apsAllocPrivate()
+{
+    if (apsMemPriv && apsMemPriv->owner == std::this_thread::get_id())
+    {
+        return MEM_AllocItem<T>(&apsMemPriv->mem);
+    }
+
+    return MEM_ThreadPool<T>().alloc(); // e.g. indications destroyed by a queued signal receiver
+}
+
+template <typename T>
+static void apsDeallocPrivate(T *priv)
 {
-    for (auto &i : MEM_GetAllocContainer<ApsDataRequestPrivate>(apsMemPriv->mem))
+    if (apsMemPriv && apsMemPriv->owner == std::this_thread::get_id())
     {
-        if (i) { delete i; }
+        MEM_DeallocItem<T>(priv, &apsMemPriv->mem);
+        return;
     }
+
+    MEM_ThreadPool<T>().release(priv);
+}
+
+template <typename T>
+static void apsPrintPoolStats(const char *name, const MEM_Pool<T> &pool)
+{
+    const MEM_PoolStats &st = pool.stats();
+    DBG_Printf(DBG_INFO_L2, "APS pool %s: %lu hits, %lu misses, %lu drops, capacity %d\n",
+               name, st.hits, st.misses, st.drops, int(pool.capacity()));
+}
+
+ApsMemoryPrivate::~ApsMemoryPrivate()
+{
+    apsPrintPoolStats("ApsDataRequestPrivate", MEM_GetAllocContainer<ApsDataRequestPrivate>(mem));
+    apsPrintPoolStats("ApsDataIndicationPrivate", MEM_GetAllocContainer<ApsDataIndicationPrivate>(mem));
+    apsPrintPoolStats("ApsAsduBuffer", MEM_GetAllocContainer<ApsAsduBuffer>(mem));
 }
 
 ApsMemory::ApsMemory() :
@@ -112,6 +194,7 @@ ApsMemory::ApsMemory() :
     Q_ASSERT_X(apsMem == nullptr, "ApsMemory::ApsMemory()", "Already initialized");
     apsMem = this; // singleton
     apsMemPriv = d; // quick ref
+    d->owner = std::this_thread::get_id();
 }
 
 ApsMemory::~ApsMemory()
@@ -124,14 +207,14 @@ ApsMemory::~ApsMemory()
 
 ApsDataRequest::ApsDataRequest()
 {
-    d_ptr = MEM_AllocItem<ApsDataRequestPrivate>(&apsMemPriv->mem);
+    d_ptr = apsAllocPrivate<ApsDataRequestPrivate>();
     *d_ptr = {};
     d_ptr->id = APS_NextApsRequestId();
 }
 
 ApsDataRequest::ApsDataRequest(const ApsDataRequest &other)
 {
-    d_ptr = MEM_AllocItem<ApsDataRequestPrivate>(&apsMemPriv->mem);
+    d_ptr = apsAllocPrivate<ApsDataRequestPrivate>();
     *d_ptr = *other.d_ptr;
 }
 
@@ -169,7 +252,7 @@ ApsDataRequest& ApsDataRequest::operator=(ApsDataRequest &&other) noexcept
 
     if (d_ptr)
     {
-        MEM_DeallocItem<ApsDataRequestPrivate>(d_ptr, &apsMemPriv->mem);
+        apsDeallocPrivate(d_ptr);
         d_ptr = nullptr;
     }
 
@@ -183,7 +266,7 @@ ApsDataRequest::~ApsDataRequest()
 {
     if (d_ptr)
     {
-        MEM_DeallocItem<ApsDataRequestPrivate>(d_ptr, &apsMemPriv->mem);
+        apsDeallocPrivate(d_ptr);
         d_ptr = nullptr;
     }
 }
@@ -463,6 +546,271 @@ void ApsDataRequest::readFromStream(QDataStream &stream)
     setRadius(u8);
 }
 
+static void apsPutU64(U_BStream *bs, uint64_t v)
+{
+    U_bstream_put_u32_le(bs, static_cast<unsigned long>(v & 0xFFFFFFFF));
+    U_bstream_put_u32_le(bs, static_cast<unsigned long>(v >> 32));
+}
+
+static uint64_t apsGetU64(U_BStream *bs)
+{
+    const uint64_t lo = U_bstream_get_u32_le(bs) & 0xFFFFFFFF;
+    const uint64_t hi = U_bstream_get_u32_le(bs) & 0xFFFFFFFF;
+    return hi << 32 | lo;
+}
+
+static void apsPutBytes(U_BStream *bs, const void *data, unsigned size)
+{
+    if (bs->status != U_BSTREAM_OK || bs->pos + size > bs->size)
+    {
+        bs->status = U_BSTREAM_WRITE_PAST_END;
+        return;
+    }
+
+    if (size > 0)
+    {
+        memcpy(bs->data + bs->pos, data, size);
+        bs->pos += size;
+    }
+}
+
+/*! Returns a pointer to \p size bytes at the current position and skips them, nullptr if not available. */
+static const uint8_t *apsGetBytes(U_BStream *bs, unsigned size)
+{
+    if (bs->status != U_BSTREAM_OK || bs->pos + size > bs->size)
+    {
+        bs->status = U_BSTREAM_READ_PAST_END;
+        return nullptr;
+    }
+
+    const uint8_t *p = bs->data + bs->pos;
+    bs->pos += size;
+    return p;
+}
+
+int ApsDataRequest::writeToBuffer(uint8_t *data, unsigned size) const
+{
+    const ApsDataRequestPrivate *d = d_ptr;
+    const uint8_t relayCount = std::min(d->relayCount, uint8_t(d->sourceRoute.size()));
+    uint8_t flags = 0;
+    unsigned len = 1; // id
+
+    if (d->version > 1)
+    {
+        if (d->nodeId != APS_INVALID_NODE_ID)
+        {
+            flags |= 0x01; // include node id
+        }
+
+        if (relayCount > 0)
+        {
+            flags |= 0x02;
+        }
+
+        len += (flags & 0x01) ? 3 : 1;
+    }
+
+    len += 1; // dst address mode
+
+    switch (d->dstAddrMode)
+    {
+    case ApsGroupAddress:
+        if (!d->dstAddr.hasGroup())
+        {
+            DBG_Printf(DBG_APS, "write APS.req no group address\n");
+            return 0;
+        }
+        len += 2;
+        break;
+
+    case ApsNwkAddress:
+        if (!d->dstAddr.hasNwk())
+        {
+            DBG_Printf(DBG_APS, "write APS.req no nwk address\n");
+            return 0;
+        }
+        len += 2 + 1;
+        break;
+
+    case ApsExtAddress:
+        if (!d->dstAddr.hasExt())
+        {
+            DBG_Printf(DBG_APS, "write APS.req no ext address\n");
+            return 0;
+        }
+        len += 8 + 1;
+        break;
+
+    default:
+        DBG_Printf(DBG_APS, "write APS.req invalid address mode\n");
+        return 0;
+    }
+
+    len += 2 + 2 + 1; // profile id, cluster id, src endpoint
+    len += 2 + unsigned(d->asdu.size());
+    len += 1 + 1; // tx options, radius
+
+    if (flags & 0x02)
+    {
+        len += 1 + 2 * unsigned(relayCount);
+    }
+
+    if (!data)
+    {
+        return int(len);
+    }
+
+    if (len > size)
+    {
+        return 0;
+    }
+
+    U_BStream bs;
+    U_bstream_init(&bs, data, size);
+
+    U_bstream_put_u8(&bs, d->id);
+
+    if (d->version > 1)
+    {
+        U_bstream_put_u8(&bs, flags);
+        if (flags & 0x01)
+        {
+            U_bstream_put_u16_le(&bs, d->nodeId);
+        }
+    }
+
+    U_bstream_put_u8(&bs, uint8_t(d->dstAddrMode));
+
+    switch (d->dstAddrMode)
+    {
+    case ApsGroupAddress:
+        U_bstream_put_u16_le(&bs, d->dstAddr.group());
+        break;
+
+    case ApsNwkAddress:
+        U_bstream_put_u16_le(&bs, d->dstAddr.nwk());
+        U_bstream_put_u8(&bs, d->dstEndpoint);
+        break;
+
+    case ApsExtAddress:
+        apsPutU64(&bs, d->dstAddr.ext());
+        U_bstream_put_u8(&bs, d->dstEndpoint);
+        break;
+
+    default:
+        break;
+    }
+
+    U_bstream_put_u16_le(&bs, d->profileId);
+    U_bstream_put_u16_le(&bs, d->clusterId);
+    U_bstream_put_u8(&bs, d->srcEndpoint);
+    U_bstream_put_u16_le(&bs, uint16_t(d->asdu.size()));
+    apsPutBytes(&bs, d->asdu.constData(), unsigned(d->asdu.size()));
+    U_bstream_put_u8(&bs, uint8_t(static_cast<int>(d->txOptions)));
+    U_bstream_put_u8(&bs, d->radius);
+
+    if (flags & 0x02)
+    {
+        U_bstream_put_u8(&bs, relayCount);
+
+        for (uint8_t i = 0; i < relayCount; i++)
+        {
+            U_bstream_put_u16_le(&bs, d->sourceRoute[i]);
+        }
+    }
+
+    DBG_Assert(bs.status == U_BSTREAM_OK && bs.pos == len);
+    return bs.status == U_BSTREAM_OK ? int(bs.pos) : 0;
+}
+
+int ApsDataRequest::readFromBuffer(const uint8_t *data, unsigned size)
+{
+    ApsDataRequestPrivate *d = d_ptr;
+    U_BStream bs;
+    U_bstream_init(&bs, const_cast<uint8_t*>(data), size);
+
+    d->id = U_bstream_get_u8(&bs);
+
+    uint8_t flags = 0;
+    if (d->version > 1)
+    {
+        flags = U_bstream_get_u8(&bs);
+    }
+
+    d->nodeId = (flags & 0x01) ? U_bstream_get_u16_le(&bs) : uint16_t(APS_INVALID_NODE_ID);
+    d->dstAddrMode = static_cast<ApsAddressMode>(U_bstream_get_u8(&bs));
+
+    switch (d->dstAddrMode)
+    {
+    case ApsNoAddress:
+        break;
+
+    case ApsGroupAddress:
+        d->dstAddr.setGroup(U_bstream_get_u16_le(&bs));
+        break;
+
+    case ApsNwkAddress:
+        d->dstAddr.setNwk(U_bstream_get_u16_le(&bs));
+        d->dstEndpoint = U_bstream_get_u8(&bs);
+        break;
+
+    case ApsExtAddress:
+        d->dstAddr.setExt(apsGetU64(&bs));
+        d->dstEndpoint = U_bstream_get_u8(&bs);
+        break;
+
+    default:
+        return 0;
+    }
+
+    d->profileId = U_bstream_get_u16_le(&bs);
+    d->clusterId = U_bstream_get_u16_le(&bs);
+    d->srcEndpoint = U_bstream_get_u8(&bs);
+
+    const unsigned asduLength = U_bstream_get_u16_le(&bs);
+    const uint8_t *asdu = apsGetBytes(&bs, asduLength);
+    if (!asdu)
+    {
+        return 0;
+    }
+
+    d->asdu.resize(int(asduLength)); // keeps the allocation of a pooled request
+    if (asduLength > 0)
+    {
+        memcpy(d->asdu.data(), asdu, asduLength);
+    }
+
+    const uint8_t txOptions = U_bstream_get_u8(&bs) & 0x0F;
+
+    // fugly but can't cast to QFlags
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        ApsTxOption opt = (ApsTxOption)(1 << i);
+        bool set = (txOptions & (1 << i)) != 0;
+        d->txOptions.setFlag(opt, set);
+    }
+
+    d->radius = U_bstream_get_u8(&bs);
+    d->relayCount = 0;
+
+    if (flags & 0x02)
+    {
+        const uint8_t relayCount = U_bstream_get_u8(&bs);
+        if (relayCount > d->sourceRoute.size())
+        {
+            return 0;
+        }
+
+        for (uint8_t i = 0; i < relayCount; i++)
+        {
+            d->sourceRoute[i] = U_bstream_get_u16_le(&bs);
+        }
+        d->relayCount = relayCount;
+    }
+
+    return bs.status == U_BSTREAM_OK ? int(bs.pos) : 0;
+}
+
 void ApsDataRequest::clear()
 {
     d_ptr->sourceRoute = {};
@@ -695,71 +1043,43 @@ void ApsDataConfirm::readFromStream(QDataStream &stream)
 //    Q_UNUSED(txTime_)
 }
 
-class ApsDataIndicationPrivate
+int ApsDataConfirm::readFromBuffer(const uint8_t *data, unsigned size)
 {
-public:
-    ApsDataIndicationPrivate();
-    ApsDataIndicationPrivate(const ApsDataIndicationPrivate &other);
-    ApsDataIndicationPrivate &operator=(const ApsDataIndicationPrivate &other);
-    ApsAddressMode dstAddrMode = ApsNoAddress;
-    Address dstAddr{};
-    uint8_t dstEndpoint = 0xFF;
-    ApsAddressMode srcAddrMode = ApsNoAddress;
-    Address srcAddr{};
-    uint8_t srcEndpoint = 0xFF;
-    uint16_t profileId = 0xFFFF;
-    uint16_t clusterId = 0xFFFF;
-    QByteArray asdu;
-    quint16 previousHop = 0xFFFF;
-    uint8_t status = 0xFF;
-    uint8_t securityStatus = 0xFF;
-    uint8_t linkQuality = 0xFF;
-    uint32_t rxTime = 0;
-    int8_t rssi = 0;
-    int version = 1;
-    std::array<uint8_t, 118> asduBuf;
-    void reset();
-};
+    U_BStream bs;
+    U_bstream_init(&bs, const_cast<uint8_t*>(data), size);
 
-ApsDataIndicationPrivate::ApsDataIndicationPrivate() :
-    dstEndpoint(0xFF),
-    srcEndpoint(0xFF),
-    profileId(0xFFFF),
-    clusterId(0xFFFF),
-    previousHop(0xFFFF),
-    status(0xFF),
-    securityStatus(0xFF),
-    linkQuality(0xFF),
-    rxTime(0x0000),
-    rssi(0),
-    version(1)
-{
+    m_id = U_bstream_get_u8(&bs);
+    m_dstAddrMode = static_cast<ApsAddressMode>(U_bstream_get_u8(&bs));
 
-}
+    switch (m_dstAddrMode)
+    {
+    case ApsNwkAddress:
+        m_dstAddr.setNwk(U_bstream_get_u16_le(&bs));
+        m_dstEndpoint = U_bstream_get_u8(&bs);
+        break;
 
-ApsDataIndicationPrivate::ApsDataIndicationPrivate(const ApsDataIndicationPrivate &other)
-{
-    dstAddrMode = other.dstAddrMode;
-    dstAddr = other.dstAddr;
-    dstEndpoint = other.dstEndpoint;
+    case ApsGroupAddress:
+        m_dstAddr.setGroup(U_bstream_get_u16_le(&bs));
+        break;
 
-    srcAddrMode = other.srcAddrMode;
-    srcAddr = other.srcAddr;
-    srcEndpoint = other.srcEndpoint;
+    case ApsExtAddress:
+        m_dstAddr.setExt(apsGetU64(&bs));
+        m_dstEndpoint = U_bstream_get_u8(&bs);
+        break;
 
-    profileId = other.profileId;
-    clusterId = other.clusterId;
+    default:
+        break;
+    }
 
-    previousHop = other.previousHop;
-    status = other.status;
-    securityStatus = other.securityStatus;
-    linkQuality = other.linkQuality;
-    rxTime = other.rxTime;
-    rssi = other.rssi;
-    version = other.version;
-    asduBuf = other.asduBuf;
+    m_srcEndpoint = U_bstream_get_u8(&bs);
+    m_status = U_bstream_get_u8(&bs);
+
+    return bs.status == U_BSTREAM_OK ? int(bs.pos) : 0;
+}
 
-    asdu.setRawData(reinterpret_cast<char*>(asduBuf.data()), other.asdu.size());
+ApsDataIndicationPrivate::ApsDataIndicationPrivate(const ApsDataIndicationPrivate &other)
+{
+    *this = other;
 }
 
 ApsDataIndicationPrivate &ApsDataIndicationPrivate::operator=(const ApsDataIndicationPrivate &other)
@@ -787,14 +1107,76 @@ ApsDataIndicationPrivate &ApsDataIndicationPrivate::operator=(const ApsDataIndic
     rxTime = other.rxTime;
     rssi = other.rssi;
     version = other.version;
-    asduBuf = other.asduBuf;
 
-    asdu.setRawData(reinterpret_cast<char*>(asduBuf.data()), other.asdu.size());
+    copyAsdu(other);
     return *this;
 }
 
+ApsDataIndicationPrivate::~ApsDataIndicationPrivate()
+{
+    // pooled objects have no buffer, don't touch the pools which might be destructed already
+    if (asduBuf && --asduBuf->ref == 0)
+    {
+        delete asduBuf;
+    }
+}
+
+/*! Shares the ASDU buffer of \p other, copies are O(1) and don't allocate. */
+void ApsDataIndicationPrivate::copyAsdu(const ApsDataIndicationPrivate &other)
+{
+    const bool otherView = other.asduBuf && other.asdu.constData() == reinterpret_cast<const char*>(other.asduBuf->data.data());
+
+    if (!otherView)
+    {
+        releaseAsdu();
+        asdu = other.asdu; // modified or set via setAsdu(), QByteArray is implicitly shared
+        return;
+    }
+
+    if (asduBuf != other.asduBuf)
+    {
+        releaseAsdu();
+        asduBuf = other.asduBuf;
+        asduBuf->ref++;
+    }
+
+    asdu.setRawData(reinterpret_cast<const char*>(asduBuf->data.data()), uint(other.asdu.size()));
+}
+
+void ApsDataIndicationPrivate::releaseAsdu()
+{
+    if (asduBuf)
+    {
+        asdu.setRawData(nullptr, 0); // keep the QByteArray header for reuse
+        if (--asduBuf->ref == 0)
+        {
+            apsDeallocPrivate(asduBuf);
+        }
+        asduBuf = nullptr;
+    }
+}
+
+/*! Returns a ASDU buffer which isn't shared with other indications. */
+uint8_t *ApsDataIndicationPrivate::writableAsdu()
+{
+    if (asduBuf && asduBuf->ref != 1)
+    {
+        releaseAsdu();
+    }
+
+    if (!asduBuf)
+    {
+        asduBuf = apsAllocPrivate<ApsAsduBuffer>();
+        asduBuf->ref = 1;
+    }
+
+    return asduBuf->data.data();
+}
+
 void ApsDataIndicationPrivate::reset()
 {
+    dstAddrMode = ApsNoAddress;
+    srcAddrMode = ApsNoAddress;
     dstAddr = {};
     srcAddr = {};
     dstEndpoint = 0xFF;
@@ -808,16 +1190,31 @@ void ApsDataIndicationPrivate::reset()
     rxTime = 0x0000;
     rssi = 0;
     version = 1;
+    releaseAsdu();
+    if (!asdu.isEmpty())
+    {
+        asdu.clear();
+    }
 }
 
 ApsDataIndication::ApsDataIndication() :
-    d_ptr(new ApsDataIndicationPrivate)
+    d_ptr(apsAllocPrivate<ApsDataIndicationPrivate>())
 {
+    d_ptr->reset(); // might be reused from the pool
 }
 
 ApsDataIndication::ApsDataIndication(const ApsDataIndication &other) :
-    d_ptr(new ApsDataIndicationPrivate(*other.d_ptr))
+    d_ptr(apsAllocPrivate<ApsDataIndicationPrivate>())
 {
+    *d_ptr = *other.d_ptr;
+}
+
+ApsDataIndication::ApsDataIndication(ApsDataIndication &&other) noexcept :
+    d_ptr(other.d_ptr)
+{
+    Q_ASSERT(&other != this);
+    other.d_ptr = nullptr;
+    Q_ASSERT(d_ptr);
 }
 
 ApsDataIndication &ApsDataIndication::operator=(const ApsDataIndication &other)
@@ -834,11 +1231,27 @@ ApsDataIndication &ApsDataIndication::operator=(const ApsDataIndication &other)
     return *this;
 }
 
+ApsDataIndication &ApsDataIndication::operator=(ApsDataIndication &&other) noexcept
+{
+    // Self assignment?
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    Q_ASSERT(other.d_ptr);
+    std::swap(d_ptr, other.d_ptr);
+    return *this;
+}
+
 ApsDataIndication::~ApsDataIndication()
 {
-    Q_ASSERT(d_ptr);
-    delete d_ptr;
-    d_ptr = nullptr;
+    if (d_ptr)
+    {
+        d_ptr->releaseAsdu();
+        apsDeallocPrivate(d_ptr);
+        d_ptr = nullptr;
+    }
 }
 
 ApsAddressMode ApsDataIndication::dstAddressMode() const
@@ -933,6 +1346,7 @@ QByteArray &ApsDataIndication::asdu()
 
 void ApsDataIndication::setAsdu(const QByteArray &asdu)
 {
+    d_ptr->releaseAsdu();
     d_ptr->asdu = asdu;
 }
 
@@ -1071,11 +1485,18 @@ void ApsDataIndication::readFromStream(QDataStream &stream)
     stream >> d_ptr->clusterId;
     stream >> u16; // asdu length
 
-    for (unsigned i = 0; i < u16 && i < d_ptr->asduBuf.size(); i++)
+    if (u16 > ApsAsduBuffer::MaxSize)
+    {
+        DBG_Printf(DBG_APS, "APSDE-DATA.indication ASDU length %u exceeds buffer\n", u16);
+        u16 = ApsAsduBuffer::MaxSize;
+    }
+
+    uint8_t *buf = d_ptr->writableAsdu();
+    for (unsigned i = 0; i < u16; i++)
     {
-        stream >> d_ptr->asduBuf[i];
+        stream >> buf[i];
     }
-    asdu().setRawData(reinterpret_cast<const char*>(d_ptr->asduBuf.data()), u16);
+    d_ptr->asdu.setRawData(reinterpret_cast<const char*>(buf), u16);
 
     if (version() >= 3)
     {
@@ -1101,6 +1522,114 @@ void ApsDataIndication::readFromStream(QDataStream &stream)
     }
 }
 
+int ApsDataIndication::readFromBuffer(const uint8_t *data, unsigned size)
+{
+    ApsDataIndicationPrivate *d = d_ptr;
+    U_BStream bs;
+    U_bstream_init(&bs, const_cast<uint8_t*>(data), size);
+
+    d->dstAddrMode = static_cast<ApsAddressMode>(U_bstream_get_u8(&bs));
+
+    switch (d->dstAddrMode)
+    {
+    case ApsNoAddress:
+        break;
+
+    case ApsGroupAddress:
+        d->dstAddr.setGroup(U_bstream_get_u16_le(&bs));
+        break;
+
+    case ApsNwkAddress:
+        d->dstAddr.setNwk(U_bstream_get_u16_le(&bs));
+        break;
+
+    case ApsExtAddress:
+        d->dstAddr.setExt(apsGetU64(&bs));
+        break;
+
+    default:
+        DBG_Printf(DBG_APS, "APSDE-DATA.indication invalid dst address mode 0x%02X\n", d->dstAddrMode);
+        return 0;
+    }
+
+    d->dstEndpoint = U_bstream_get_u8(&bs);
+    d->srcAddrMode = static_cast<ApsAddressMode>(U_bstream_get_u8(&bs));
+
+    switch (d->srcAddrMode)
+    {
+    case ApsNoAddress:
+        break;
+
+    case ApsGroupAddress:
+        d->srcAddr.setGroup(U_bstream_get_u16_le(&bs));
+        break;
+
+    case ApsNwkAddress:
+        d->srcAddr.setNwk(U_bstream_get_u16_le(&bs));
+        break;
+
+    case ApsExtAddress:
+        d->srcAddr.setExt(apsGetU64(&bs));
+        break;
+
+    case ApsNwkExtAddress:
+    {
+        d->srcAddrMode = ApsNwkAddress; // keep it simple
+        d->srcAddr.setNwk(U_bstream_get_u16_le(&bs));
+        const uint64_t ext = apsGetU64(&bs);
+        if (0 != ext) // 0 means invalid ieee address
+        {
+            d->srcAddr.setExt(ext);
+        }
+    }
+        break;
+
+    default:
+        DBG_Printf(DBG_APS, "APSDE-DATA.indication invalid src address mode 0x%02X\n", d->srcAddrMode);
+        return 0;
+    }
+
+    d->srcEndpoint = U_bstream_get_u8(&bs);
+    d->profileId = U_bstream_get_u16_le(&bs);
+    d->clusterId = U_bstream_get_u16_le(&bs);
+
+    const unsigned asduLength = U_bstream_get_u16_le(&bs);
+    const uint8_t *asdu = apsGetBytes(&bs, asduLength);
+    if (!asdu || asduLength > ApsAsduBuffer::MaxSize)
+    {
+        DBG_Printf(DBG_APS, "APSDE-DATA.indication invalid ASDU length %u\n", asduLength);
+        return 0;
+    }
+
+    uint8_t *buf = d->writableAsdu();
+    if (asduLength > 0)
+    {
+        memcpy(buf, asdu, asduLength);
+    }
+    d->asdu.setRawData(reinterpret_cast<const char*>(buf), asduLength);
+
+    if (d->version >= 3)
+    {
+        d->previousHop = U_bstream_get_u16_le(&bs);
+        d->status = 0x00; // success
+    }
+    else
+    {
+        d->status = U_bstream_get_u8(&bs);
+        d->securityStatus = U_bstream_get_u8(&bs);
+    }
+
+    d->linkQuality = U_bstream_get_u8(&bs);
+    d->rxTime = U_bstream_get_u32_le(&bs);
+
+    if (d->version >= 2)
+    {
+        d->rssi = int8_t(U_bstream_get_u8(&bs));
+    }
+
+    return bs.status == U_BSTREAM_OK ? int(bs.pos) : 0;
+}
+
 void ApsDataIndication::writeToStream(QDataStream &stream) const
 {
     stream << (quint8)dstAddressMode();
@@ -1165,9 +1694,10 @@ void ApsDataIndication::writeToStream(QDataStream &stream) const
     stream << clusterId();
     stream << (quint16)asdu().size();
 
-    for (int i = 0, end = asdu().size(); i < end; i++)
+    const QByteArray &data = asdu();
+    for (int i = 0, end = data.size(); i < end; i++)
     {
-        stream << d_ptr->asduBuf[i];
+        stream << quint8(data[i]);
     }
 
     stream << status();
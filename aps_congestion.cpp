@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2012-2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <unordered_map>
+#include "deconz/aps_congestion.h"
+#include "deconz/dbg_trace.h"
+#include "aps_private.h"
+
+namespace deCONZ {
+
+struct ApsCcNode
+{
+    float window = ApsCongestionControl::InitialWindow;
+    float failureRate = 0; //!< EWMA 0..1
+    int srttMs = 0;
+    int rttvarMs = 0;
+    int backoffMs = 0;
+    int inFlight = 0;
+    SteadyTimeRef lastSend;
+    SteadyTimeRef lastDecrease;
+    SteadyTimeRef lastActivity;
+};
+
+/*! A sent request, indexed by request id. */
+struct ApsCcSent
+{
+    uint64_t key = 0;
+    SteadyTimeRef time; //!< Invalid if there is no unconfirmed request.
+};
+
+class ApsCongestionControlPrivate
+{
+public:
+    ApsCcNode &node(uint64_t key, SteadyTimeRef now);
+    void decrease(ApsCcNode &node, SteadyTimeRef now);
+    static int pacingMs(const ApsCcNode &node);
+
+    std::unordered_map<uint64_t, ApsCcNode> nodes;
+    std::array<ApsCcSent, 256> sent{};
+};
+
+/*! The nwk address is the key of a node, so that requests via ext and nwk address share one state. */
+uint64_t APS_NodeKey(const Address &addr)
+{
+    if (addr.hasNwk())
+    {
+        return addr.nwk();
+    }
+
+    Address resolved = addr;
+
+    if (APS_ResolveAddress(resolved) == Success && resolved.hasNwk())
+    {
+        return resolved.nwk();
+    }
+
+    return addr.ext(); // unknown node
+}
+
+uint64_t APS_NodeKey(const ApsDataRequest &req)
+{
+    const Address &addr = req.dstAddress();
+
+    switch (req.dstAddressMode())
+    {
+    case ApsGroupAddress: return 0x10000 | addr.group();
+    case ApsNwkAddress:   return addr.nwk();
+    case ApsExtAddress:   return APS_NodeKey(addr);
+    default:
+        break;
+    }
+
+    return 0x20000;
+}
+
+/*! Returns true if the confirm \p status indicates an overloaded destination or route. */
+static bool APS_IsCongestionStatus(uint8_t status)
+{
+    switch (status)
+    {
+    case ApsNoAckStatus:
+    case NwkRouteDiscoveryFailedStatus:
+    case NwkRouteErrorStatus:
+    case NwkBroadcastTableFullStatus:
+    case MacNoChannelAccess:
+    case MacNoAckStatus:
+    case MacTransactionExpiredStatus:
+        return true;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+ApsCcNode &ApsCongestionControlPrivate::node(uint64_t key, SteadyTimeRef now)
+{
+    auto i = nodes.find(key);
+
+    if (i != nodes.end())
+    {
+        i->second.lastActivity = now;
+        return i->second;
+    }
+
+    if (nodes.size() >= ApsCongestionControl::MaxNodes)
+    {
+        // rare, a linear scan for the least recently used idle node is fine
+        auto lru = nodes.end();
+        for (auto n = nodes.begin(); n != nodes.end(); ++n)
+        {
+            if (n->second.inFlight == 0 && (lru == nodes.end() || n->second.lastActivity < lru->second.lastActivity))
+            {
+                lru = n;
+            }
+        }
+
+        if (lru != nodes.end())
+        {
+            nodes.erase(lru);
+        }
+    }
+
+    ApsCcNode &result = nodes[key];
+    result.lastActivity = now;
+    return result;
+}
+
+/*! Multiplicative decrease, at most once per round trip time. */
+void ApsCongestionControlPrivate::decrease(ApsCcNode &node, SteadyTimeRef now)
+{
+    const int64_t holdOff = std::max<int64_t>(node.srttMs, ApsCongestionControl::MinBackoffMs);
+
+    if (isValid(node.lastDecrease) && now.ref - node.lastDecrease.ref < holdOff)
+    {
+        return;
+    }
+
+    node.window = std::max<float>(ApsCongestionControl::MinWindow, node.window / 2);
+    node.lastDecrease = now;
+}
+
+int ApsCongestionControlPrivate::pacingMs(const ApsCcNode &node)
+{
+    const int pacing = std::max(node.backoffMs, int(node.srttMs / node.window));
+    return std::min<int>(pacing, ApsCongestionControl::MaxPacingMs);
+}
+
+ApsCongestionControl::ApsCongestionControl() :
+    d_ptr(new ApsCongestionControlPrivate)
+{
+}
+
+ApsCongestionControl::~ApsCongestionControl()
+{
+    delete d_ptr;
+    d_ptr = nullptr;
+}
+
+void ApsCongestionControl::requestSent(const ApsDataRequest &req, SteadyTimeRef now)
+{
+    requestSentForKey(APS_NodeKey(req), req.id(), now);
+}
+
+void ApsCongestionControl::requestSentForKey(uint64_t key, uint8_t id, SteadyTimeRef now)
+{
+    ApsCongestionControlPrivate *d = d_ptr;
+    ApsCcSent &sent = d->sent[id];
+
+    if (isValid(sent.time))
+    {
+        // id reused, the confirm of the former request got lost
+        auto i = d->nodes.find(sent.key);
+        if (i != d->nodes.end())
+        {
+            i->second.inFlight = std::max(0, i->second.inFlight - 1);
+        }
+    }
+
+    sent.key = key;
+    sent.time = now;
+
+    ApsCcNode &node = d->node(sent.key, now);
+    node.inFlight++;
+    node.lastSend = now;
+}
+
+void ApsCongestionControl::confirmReceived(const ApsDataConfirm &conf, SteadyTimeRef now)
+{
+    ApsCongestionControlPrivate *d = d_ptr;
+    ApsCcSent &sent = d->sent[conf.id()];
+
+    if (!isValid(sent.time))
+    {
+        return;
+    }
+
+    const int latency = int(std::max<int64_t>(0, now.ref - sent.time.ref));
+    sent.time = {};
+
+    ApsCcNode &node = d->node(sent.key, now);
+    node.inFlight = std::max(0, node.inFlight - 1);
+
+    if (conf.status() == ApsSuccessStatus)
+    {
+        // ApsDataConfirm::txTime() isn't provided by the firmware, use the measured latency
+        const bool late = node.srttMs > 0 && latency > std::max(2 * node.srttMs, node.srttMs + 4 * node.rttvarMs);
+
+        if (node.srttMs == 0)
+        {
+            node.srttMs = std::max(1, latency);
+            node.rttvarMs = latency / 2;
+        }
+        else
+        {
+            node.rttvarMs = (3 * node.rttvarMs + std::abs(node.srttMs - latency)) / 4;
+            node.srttMs = std::max(1, (7 * node.srttMs + latency) / 8);
+        }
+
+        node.failureRate *= 7.0f / 8;
+
+        if (late)
+        {
+            d->decrease(node, now);
+        }
+        else
+        {
+            node.window = std::min<float>(MaxWindow, node.window + 1 / node.window);
+            node.backoffMs /= 2;
+        }
+    }
+    else if (APS_IsCongestionStatus(conf.status()))
+    {
+        node.failureRate = node.failureRate * 7 / 8 + 1.0f / 8;
+        node.backoffMs = std::min<int>(MaxPacingMs, std::max<int>(MinBackoffMs, node.backoffMs * 2));
+        d->decrease(node, now);
+
+        DBG_Printf(DBG_APS, "APS congestion 0x%04X, status 0x%02X, window %.1f, backoff %d ms\n",
+                   unsigned(sent.key), conf.status(), double(node.window), node.backoffMs);
+    }
+}
+
+int ApsCongestionControl::window(const ApsDataRequest &req) const
+{
+    return windowForKey(APS_NodeKey(req));
+}
+
+SteadyTimeRef ApsCongestionControl::nextSendTime(const ApsDataRequest &req) const
+{
+    return nextSendTimeForKey(APS_NodeKey(req));
+}
+
+ApsCongestionState ApsCongestionControl::state(const Address &addr) const
+{
+    ApsCongestionState result;
+    const auto i = d_ptr->nodes.find(APS_NodeKey(addr));
+
+    if (i == d_ptr->nodes.end())
+    {
+        result.window = InitialWindow;
+        return result;
+    }
+
+    const ApsCcNode &node = i->second;
+    result.window = int(node.window);
+    result.pacingMs = ApsCongestionControlPrivate::pacingMs(node);
+    result.srttMs = node.srttMs;
+    result.failureRate = int(node.failureRate * 100 + 0.5f);
+    result.inFlight = node.inFlight;
+    return result;
+}
+
+void ApsCongestionControl::clear()
+{
+    d_ptr->nodes.clear();
+    d_ptr->sent.fill(ApsCcSent{});
+}
+
+int ApsCongestionControl::windowForKey(uint64_t key) const
+{
+    const auto i = d_ptr->nodes.find(key);
+    return i != d_ptr->nodes.end() ? int(i->second.window) : InitialWindow;
+}
+
+SteadyTimeRef ApsCongestionControl::nextSendTimeForKey(uint64_t key) const
+{
+    const auto i = d_ptr->nodes.find(key);
+
+    if (i == d_ptr->nodes.end() || !isValid(i->second.lastSend))
+    {
+        return {};
+    }
+
+    const int pacing = ApsCongestionControlPrivate::pacingMs(i->second);
+
+    if (pacing <= 0)
+    {
+        return {};
+    }
+
+    return i->second.lastSend + TimeMs{pacing};
+}
+
+} // namespace deCONZ
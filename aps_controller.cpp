@@ -8,11 +8,14 @@
  *
  */
 
+#include "deconz/aps_congestion.h"
 #include "deconz/aps_controller.h"
 #include "deconz/dbg_trace.h"
 #include "deconz/node_event.h"
+#include "aps_private.h"
 
 static deCONZ::ApsController *_apsCtrl = nullptr;
+static deCONZ::ApsCongestionControl *_apsCongestion = nullptr; // not a member to keep the ApsController layout
 
 namespace deCONZ {
 
@@ -21,12 +24,19 @@ ApsController::ApsController(QObject *parent) :
 {
     _apsCtrl = this;
 
+    if (!_apsCongestion)
+    {
+        _apsCongestion = new ApsCongestionControl;
+    }
+
     qRegisterMetaType<NodeEvent>( "NodeEvent" );
 }
 
 ApsController::~ApsController()
 {
     _apsCtrl = nullptr;
+    delete _apsCongestion;
+    _apsCongestion = nullptr;
 }
 
 ApsController * ApsController::instance()
@@ -35,6 +45,21 @@ ApsController * ApsController::instance()
     return _apsCtrl;
 }
 
+ApsCongestionControl *ApsController::congestionControl()
+{
+    return _apsCongestion;
+}
+
+int APS_ResolveAddress(Address &addr)
+{
+    if (_apsCtrl)
+    {
+        return _apsCtrl->resolveAddress(addr);
+    }
+
+    return ErrorNotFound;
+}
+
 } // namespace deCONZ
 
 uint8_t DECONZ_DLLSPEC APS_NextApsRequestId()
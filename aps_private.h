@@ -11,12 +11,21 @@
  *
  */
 
+#include <cstdint>
 #include "deconz/declspec.h"
 
 #define APS_INVALID_NODE_ID 0xFFFFUL
 
 namespace deCONZ {
+class Address;
+class ApsDataRequest;
+
 DECONZ_DLLSPEC const char * ApsStatusToString(unsigned char status);
+/*! Returns the destination node key used for per node scheduling and congestion state. */
+uint64_t APS_NodeKey(const ApsDataRequest &req);
+uint64_t APS_NodeKey(const Address &addr);
+/*! Fills in missing address parts via ApsController::resolveAddress(), ErrorNotFound if there is no controller. */
+int APS_ResolveAddress(Address &addr);
 }
 
 #endif // DECONZ_APS_PRIVATE_H
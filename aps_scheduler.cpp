@@ -0,0 +1,674 @@
+/*
+ * Copyright (c) 2012-2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+/*
+ * Requests wait in a heap ordered by their send time until they are due,
+ * then they are appended to the FIFO of their destination node. Nodes with
+ * due requests and free in-flight slots form a ring which is served
+ * round-robin, one request per turn. With an attached ApsCongestionControl
+ * the in-flight limit is the node's window, nodes which have to wait for
+ * their pacing interval are parked in a third heap.
+ *
+ * Expired or handed out requests free their slot, the slot generation is
+ * increased so that references left in the heaps and node FIFOs become
+ * stale and are skipped later on.
+ *
+ * Handed out requests are tracked by their 8-bit request id until they are
+ * confirmed, the id is reused or the in-flight timeout passes. Since the
+ * timeout is the same for all, a FIFO in order of dispatch suffices.
+ *
+ * Requests of enqueueBatch() carry their batch id and index through the
+ * slot and the sent array. The batch holds a failure confirm per request
+ * which is replaced by the real one in confirm(), once all requests are
+ * finished the batch is moved to a done list. The callbacks are invoked at
+ * the end of the public functions, so they may call back into the scheduler.
+ */
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include "deconz/aps_congestion.h"
+#include "deconz/aps_scheduler.h"
+#include "aps_private.h"
+
+namespace deCONZ {
+
+/*! A request slot. */
+struct ApsSchedEntry
+{
+    ApsDataRequest req;
+    uint64_t nodeKey = 0;
+    uint32_t gen = 0; //!< Increased when the slot is released.
+    uint32_t batch = 0; //!< Batch id, 0 if not part of a batch.
+    uint32_t batchIndex = 0;
+    bool queued = false;
+};
+
+/*! Reference to a slot, stale if the generation doesn't match anymore. */
+struct ApsSchedRef
+{
+    uint32_t slot;
+    uint32_t gen;
+};
+
+struct ApsSchedHeapItem
+{
+    int64_t time;
+    uint64_t seq; //!< Keeps enqueue order for equal times.
+    ApsSchedRef ref;
+};
+
+struct ApsSchedLater
+{
+    bool operator()(const ApsSchedHeapItem &a, const ApsSchedHeapItem &b) const
+    {
+        return a.time != b.time ? a.time > b.time : a.seq > b.seq;
+    }
+};
+
+typedef std::priority_queue<ApsSchedHeapItem, std::vector<ApsSchedHeapItem>, ApsSchedLater> ApsSchedHeap;
+
+/*! A handed out request, indexed by request id. */
+struct ApsSchedSent
+{
+    uint64_t nodeKey = 0;
+    uint32_t gen = 0; //!< Increased on each dispatch with this id.
+    uint32_t batch = 0;
+    uint32_t batchIndex = 0;
+    bool inFlight = false;
+};
+
+/*! Requests of a enqueueBatch() call which aren't finished yet. */
+struct ApsSchedBatch
+{
+    std::vector<ApsDataConfirm> confirms; //!< Prefilled with failures, in request order.
+    int remaining = 0;
+};
+
+struct ApsSchedFlight
+{
+    int64_t time; //!< Dispatch time.
+    uint32_t gen;
+    uint8_t id;
+};
+
+struct ApsSchedNode
+{
+    std::deque<ApsSchedRef> due; //!< Due requests in order of becoming due.
+    int inFlight = 0;
+    bool inRing = false;
+    bool paced = false; //!< Waiting in the paced heap.
+};
+
+class ApsRequestSchedulerPrivate
+{
+public:
+    bool isValid(ApsSchedRef ref) const;
+    ApsSchedRef allocSlot();
+    void releaseSlot(uint32_t slot);
+    void push(const ApsDataRequest &req, SteadyTimeRef now, uint32_t batch, uint32_t batchIndex);
+    void makeDue(ApsSchedRef ref);
+    void updateRing(uint64_t key, ApsSchedNode &node);
+    void removeNodeIfIdle(uint64_t key);
+    bool isInFlight(const ApsSchedFlight &f) const;
+    void releaseInFlight(uint8_t id, const ApsDataConfirm *conf);
+    void finishBatchItem(uint32_t batch, uint32_t index, const ApsDataConfirm *conf);
+    void notifyBatches();
+    int maxInFlight(uint64_t key) const;
+    SteadyTimeRef nextSendTime(uint64_t key) const;
+
+    std::vector<ApsSchedEntry> entries;
+    std::vector<uint32_t> freeSlots;
+    ApsSchedHeap waiting; //!< Not yet due requests by send time.
+    ApsSchedHeap timeouts; //!< Queued requests by timeout.
+    ApsSchedHeap paced; //!< Nodes by next send time, seq holds the node key.
+    std::unordered_map<uint64_t, ApsSchedNode> nodes;
+    std::deque<uint64_t> ring; //!< Nodes with due requests below the in-flight limit.
+    std::array<ApsSchedSent, 256> sent{};
+    std::deque<ApsSchedFlight> flights; //!< In flight requests by dispatch time.
+    std::unordered_map<uint32_t, ApsSchedBatch> batches;
+    std::vector<std::vector<ApsDataConfirm>> doneBatches; //!< Confirms of finished batches to be reported.
+    uint32_t batchId = 0;
+    ApsBatchConfirmCallback batchCallback = nullptr;
+    void *batchCallbackUser = nullptr;
+    uint64_t seq = 0;
+    int queued = 0;
+    int inFlight = 0;
+    int inFlightTimeoutMs = ApsRequestScheduler::DefaultInFlightTimeoutMs;
+    int maxInFlightPerNode = ApsRequestScheduler::DefaultMaxInFlightPerNode;
+    int maxQueueSize = ApsRequestScheduler::DefaultMaxQueueSize;
+    ApsCongestionControl *congestion = nullptr;
+};
+
+bool ApsRequestSchedulerPrivate::isValid(ApsSchedRef ref) const
+{
+    return ref.slot < entries.size() && entries[ref.slot].gen == ref.gen && entries[ref.slot].queued;
+}
+
+ApsSchedRef ApsRequestSchedulerPrivate::allocSlot()
+{
+    uint32_t slot;
+
+    if (!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        slot = uint32_t(entries.size());
+        entries.emplace_back();
+    }
+
+    entries[slot].queued = true;
+    return ApsSchedRef{slot, entries[slot].gen};
+}
+
+void ApsRequestSchedulerPrivate::releaseSlot(uint32_t slot)
+{
+    ApsSchedEntry &e = entries[slot];
+    e.queued = false;
+    e.gen++;
+    e.req.clear(); // drop ASDU reference
+    e.batch = 0;
+    freeSlots.push_back(slot);
+    queued--;
+}
+
+void ApsRequestSchedulerPrivate::push(const ApsDataRequest &req, SteadyTimeRef now, uint32_t batch, uint32_t batchIndex)
+{
+    const ApsSchedRef ref = allocSlot();
+    ApsSchedEntry &e = entries[ref.slot];
+    e.req = req;
+    e.nodeKey = APS_NodeKey(req);
+    e.batch = batch;
+    e.batchIndex = batchIndex;
+    queued++;
+
+    const uint64_t order = seq++;
+    int64_t sendAt = deCONZ::isValid(req.sendAfter()) ? req.sendAfter().ref : 0;
+
+    if (req.sendDelay() > 0)
+    {
+        sendAt = std::max(sendAt, now.ref + req.sendDelay());
+    }
+
+    if (deCONZ::isValid(req.timeout()))
+    {
+        timeouts.push(ApsSchedHeapItem{req.timeout().ref, order, ref});
+    }
+
+    if (sendAt > now.ref)
+    {
+        waiting.push(ApsSchedHeapItem{sendAt, order, ref});
+    }
+    else
+    {
+        makeDue(ref);
+    }
+}
+
+void ApsRequestSchedulerPrivate::makeDue(ApsSchedRef ref)
+{
+    const uint64_t key = entries[ref.slot].nodeKey;
+    ApsSchedNode &node = nodes[key];
+    node.due.push_back(ref);
+    updateRing(key, node);
+}
+
+void ApsRequestSchedulerPrivate::updateRing(uint64_t key, ApsSchedNode &node)
+{
+    if (!node.inRing && !node.paced && !node.due.empty() && node.inFlight < maxInFlight(key))
+    {
+        node.inRing = true;
+        ring.push_back(key);
+    }
+}
+
+void ApsRequestSchedulerPrivate::removeNodeIfIdle(uint64_t key)
+{
+    auto i = nodes.find(key);
+
+    if (i != nodes.end() && !i->second.inRing && !i->second.paced && i->second.inFlight == 0 && i->second.due.empty())
+    {
+        nodes.erase(i);
+    }
+}
+
+bool ApsRequestSchedulerPrivate::isInFlight(const ApsSchedFlight &f) const
+{
+    return sent[f.id].inFlight && sent[f.id].gen == f.gen;
+}
+
+/*! Frees the in-flight slot of request \p id in its node.
+    \param conf the confirm of the request, nullptr if it got lost
+ */
+void ApsRequestSchedulerPrivate::releaseInFlight(uint8_t id, const ApsDataConfirm *conf)
+{
+    ApsSchedSent &s = sent[id];
+
+    if (!s.inFlight)
+    {
+        return;
+    }
+
+    s.inFlight = false;
+    inFlight--;
+
+    if (s.batch != 0)
+    {
+        finishBatchItem(s.batch, s.batchIndex, conf);
+        s.batch = 0;
+    }
+
+    auto n = nodes.find(s.nodeKey);
+    if (n != nodes.end())
+    {
+        n->second.inFlight = std::max(0, n->second.inFlight - 1);
+        updateRing(s.nodeKey, n->second);
+        removeNodeIfIdle(s.nodeKey);
+    }
+}
+
+/*! Counts a request of \p batch as finished, without \p conf the prefilled failure is kept. */
+void ApsRequestSchedulerPrivate::finishBatchItem(uint32_t batch, uint32_t index, const ApsDataConfirm *conf)
+{
+    auto i = batches.find(batch);
+
+    if (i == batches.end())
+    {
+        return;
+    }
+
+    if (conf)
+    {
+        i->second.confirms[index] = *conf;
+    }
+
+    i->second.remaining--;
+
+    if (i->second.remaining <= 0)
+    {
+        doneBatches.push_back(std::move(i->second.confirms));
+        batches.erase(i);
+    }
+}
+
+/*! Invokes the batch callback for each finished batch. */
+void ApsRequestSchedulerPrivate::notifyBatches()
+{
+    while (!doneBatches.empty())
+    {
+        const std::vector<ApsDataConfirm> confirms = std::move(doneBatches.front());
+        doneBatches.erase(doneBatches.begin());
+
+        if (batchCallback)
+        {
+            batchCallback(batchCallbackUser, confirms); // might call into the scheduler
+        }
+    }
+}
+
+int ApsRequestSchedulerPrivate::maxInFlight(uint64_t key) const
+{
+    return congestion ? congestion->windowForKey(key) : maxInFlightPerNode;
+}
+
+SteadyTimeRef ApsRequestSchedulerPrivate::nextSendTime(uint64_t key) const
+{
+    return congestion ? congestion->nextSendTimeForKey(key) : SteadyTimeRef();
+}
+
+ApsRequestScheduler::ApsRequestScheduler() :
+    d_ptr(new ApsRequestSchedulerPrivate)
+{
+}
+
+ApsRequestScheduler::~ApsRequestScheduler()
+{
+    delete d_ptr;
+    d_ptr = nullptr;
+}
+
+int ApsRequestScheduler::maxInFlightPerNode() const
+{
+    return d_ptr->maxInFlightPerNode;
+}
+
+void ApsRequestScheduler::setMaxInFlightPerNode(int max)
+{
+    d_ptr->maxInFlightPerNode = std::max(1, max);
+}
+
+int ApsRequestScheduler::maxQueueSize() const
+{
+    return d_ptr->maxQueueSize;
+}
+
+void ApsRequestScheduler::setMaxQueueSize(int max)
+{
+    d_ptr->maxQueueSize = max;
+}
+
+int ApsRequestScheduler::inFlightTimeout() const
+{
+    return d_ptr->inFlightTimeoutMs;
+}
+
+void ApsRequestScheduler::setInFlightTimeout(int ms)
+{
+    d_ptr->inFlightTimeoutMs = std::max(1, ms);
+}
+
+ApsCongestionControl *ApsRequestScheduler::congestionControl() const
+{
+    return d_ptr->congestion;
+}
+
+void ApsRequestScheduler::setCongestionControl(ApsCongestionControl *cc)
+{
+    d_ptr->congestion = cc;
+}
+
+void ApsRequestScheduler::setBatchConfirmCallback(ApsBatchConfirmCallback callback, void *user)
+{
+    d_ptr->batchCallback = callback;
+    d_ptr->batchCallbackUser = user;
+}
+
+int ApsRequestScheduler::enqueue(const ApsDataRequest &req, SteadyTimeRef now)
+{
+    ApsRequestSchedulerPrivate *d = d_ptr;
+
+    if (d->queued >= d->maxQueueSize)
+    {
+        return ErrorQueueIsFull;
+    }
+
+    d->push(req, now, 0, 0);
+    return Success;
+}
+
+int ApsRequestScheduler::enqueueBatch(const ApsDataRequest *requests, int count, int *results, SteadyTimeRef now)
+{
+    ApsRequestSchedulerPrivate *d = d_ptr;
+
+    if (!requests || count <= 0)
+    {
+        return 0;
+    }
+
+    const int n = std::max(0, std::min(count, d->maxQueueSize - d->queued));
+
+    for (int i = n; results && i < count; i++)
+    {
+        results[i] = ErrorQueueIsFull;
+    }
+
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    d->batchId++;
+    if (d->batchId == 0)
+    {
+        d->batchId++;
+    }
+
+    ApsSchedBatch &batch = d->batches[d->batchId];
+    batch.confirms.reserve(size_t(n));
+    batch.remaining = n;
+
+    for (int i = 0; i < n; i++)
+    {
+        batch.confirms.push_back(ApsDataConfirm(requests[i], MacTransactionExpiredStatus));
+        d->push(requests[i], now, d->batchId, uint32_t(i));
+
+        if (results)
+        {
+            results[i] = Success;
+        }
+    }
+
+    return n;
+}
+
+bool ApsRequestScheduler::dequeue(SteadyTimeRef now, ApsDataRequest &req)
+{
+    ApsRequestSchedulerPrivate *d = d_ptr;
+
+    while (!d->waiting.empty() && d->waiting.top().time <= now.ref)
+    {
+        const ApsSchedRef ref = d->waiting.top().ref;
+        d->waiting.pop();
+
+        if (d->isValid(ref))
+        {
+            d->makeDue(ref);
+        }
+    }
+
+    while (!d->paced.empty() && d->paced.top().time <= now.ref)
+    {
+        const uint64_t key = d->paced.top().seq;
+        d->paced.pop();
+
+        auto i = d->nodes.find(key);
+        if (i != d->nodes.end())
+        {
+            i->second.paced = false;
+            d->updateRing(key, i->second);
+            d->removeNodeIfIdle(key);
+        }
+    }
+
+    while (!d->ring.empty())
+    {
+        const uint64_t key = d->ring.front();
+        d->ring.pop_front();
+
+        auto i = d->nodes.find(key);
+        if (i == d->nodes.end())
+        {
+            continue;
+        }
+
+        ApsSchedNode &node = i->second;
+        node.inRing = false;
+
+        while (!node.due.empty() && !d->isValid(node.due.front()))
+        {
+            node.due.pop_front(); // expired
+        }
+
+        if (node.due.empty() || node.inFlight >= d->maxInFlight(key))
+        {
+            d->removeNodeIfIdle(key);
+            continue;
+        }
+
+        const SteadyTimeRef sendTime = d->nextSendTime(key);
+        if (isValid(sendTime) && now < sendTime)
+        {
+            node.paced = true;
+            d->paced.push(ApsSchedHeapItem{sendTime.ref, key, ApsSchedRef{0, 0}});
+            continue;
+        }
+
+        const ApsSchedRef ref = node.due.front();
+        req = d->entries[ref.slot].req;
+        const uint32_t batch = d->entries[ref.slot].batch;
+        const uint32_t batchIndex = d->entries[ref.slot].batchIndex;
+
+        // id reused, the confirm of the former request got lost,
+        // released while node.due isn't empty so that the node isn't removed
+        d->releaseInFlight(req.id(), nullptr);
+
+        node.due.pop_front();
+        d->releaseSlot(ref.slot);
+
+        while (!d->flights.empty() && !d->isInFlight(d->flights.front()))
+        {
+            d->flights.pop_front(); // confirmed, keeps the FIFO short when expire() isn't called often
+        }
+
+        ApsSchedSent &s = d->sent[req.id()];
+        s.nodeKey = key;
+        s.gen++;
+        s.batch = batch;
+        s.batchIndex = batchIndex;
+        s.inFlight = true;
+        d->flights.push_back(ApsSchedFlight{now.ref, s.gen, req.id()});
+        d->inFlight++;
+        node.inFlight++;
+
+        if (d->congestion)
+        {
+            d->congestion->requestSentForKey(key, req.id(), now); // key resolved once in enqueue
+        }
+
+        d->updateRing(key, node); // back of the ring, next node's turn
+        d->notifyBatches();
+
+        return true;
+    }
+
+    return false;
+}
+
+void ApsRequestScheduler::confirm(uint8_t id)
+{
+    d_ptr->releaseInFlight(id, nullptr);
+    d_ptr->notifyBatches();
+}
+
+void ApsRequestScheduler::confirm(const ApsDataConfirm &conf, SteadyTimeRef now)
+{
+    ApsRequestSchedulerPrivate *d = d_ptr;
+
+    if (d->congestion)
+    {
+        d->congestion->confirmReceived(conf, now);
+    }
+
+    d->releaseInFlight(conf.id(), &conf);
+    d->notifyBatches();
+}
+
+int ApsRequestScheduler::expire(SteadyTimeRef now, std::vector<ApsDataRequest> *expired)
+{
+    ApsRequestSchedulerPrivate *d = d_ptr;
+    int count = 0;
+
+    while (!d->timeouts.empty() && d->timeouts.top().time <= now.ref)
+    {
+        const ApsSchedRef ref = d->timeouts.top().ref;
+        d->timeouts.pop();
+
+        if (!d->isValid(ref))
+        {
+            continue; // already handed out
+        }
+
+        if (expired)
+        {
+            expired->push_back(d->entries[ref.slot].req);
+        }
+
+        if (d->entries[ref.slot].batch != 0)
+        {
+            d->finishBatchItem(d->entries[ref.slot].batch, d->entries[ref.slot].batchIndex, nullptr);
+        }
+
+        d->releaseSlot(ref.slot);
+        count++;
+    }
+
+    while (!d->flights.empty() && d->flights.front().time + d->inFlightTimeoutMs <= now.ref)
+    {
+        const ApsSchedFlight f = d->flights.front();
+        d->flights.pop_front();
+
+        if (d->isInFlight(f))
+        {
+            d->releaseInFlight(f.id, nullptr); // confirm lost
+        }
+    }
+
+    d->notifyBatches();
+
+    return count;
+}
+
+SteadyTimeRef ApsRequestScheduler::nextDeadline() const
+{
+    const ApsRequestSchedulerPrivate *d = d_ptr;
+    SteadyTimeRef result;
+
+    if (!d->waiting.empty())
+    {
+        result.ref = d->waiting.top().time;
+    }
+
+    if (!d->timeouts.empty() && (!isValid(result) || d->timeouts.top().time < result.ref))
+    {
+        result.ref = d->timeouts.top().time;
+    }
+
+    if (!d->paced.empty() && (!isValid(result) || d->paced.top().time < result.ref))
+    {
+        result.ref = d->paced.top().time;
+    }
+
+    if (!d->flights.empty())
+    {
+        const int64_t t = d->flights.front().time + d->inFlightTimeoutMs;
+        if (!isValid(result) || t < result.ref)
+        {
+            result.ref = t;
+        }
+    }
+
+    return result;
+}
+
+int ApsRequestScheduler::size() const
+{
+    return d_ptr->queued;
+}
+
+int ApsRequestScheduler::inFlight() const
+{
+    return d_ptr->inFlight;
+}
+
+void ApsRequestScheduler::clear()
+{
+    ApsRequestSchedulerPrivate *d = d_ptr;
+
+    d->entries.clear();
+    d->freeSlots.clear();
+    d->waiting = ApsSchedHeap();
+    d->timeouts = ApsSchedHeap();
+    d->paced = ApsSchedHeap();
+    d->nodes.clear();
+    d->ring.clear();
+    d->sent.fill(ApsSchedSent{});
+    d->flights.clear();
+    d->batches.clear();
+    d->doneBatches.clear();
+    d->inFlight = 0;
+    d->queued = 0;
+}
+
+} // namespace deCONZ
@@ -19,7 +19,9 @@
 #include <deconz/declspec.h>
 #include <deconz/types.h>
 #include <deconz/aps.h>
+#include <deconz/aps_congestion.h>
 #include <deconz/aps_controller.h>
+#include <deconz/aps_scheduler.h>
 #include <deconz/binding_table.h>
 #include <deconz/dbg_trace.h>
 #include <deconz/device_enumerator.h>
@@ -36,6 +38,7 @@
 #include <deconz/u_rand32.h>
 #include <deconz/u_library.h>
 #include <deconz/zcl.h>
+#include <deconz/zcl_clusters.h>
 #include <deconz/zdp_profile.h>
 #include <deconz/zdp_descriptors.h>
 #include <deconz/qhttprequest_compat.h>
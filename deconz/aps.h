@@ -66,6 +66,7 @@
 */
 
 #include <array>
+#include <vector>
 #include <QByteArray>
 #include <QFlags>
 #include <QString>
@@ -316,6 +317,19 @@ public:
         \endcode
      */
     void readFromStream(QDataStream &stream);
+    /*! Writes the request in the same format as writeToStream() to a caller provided buffer.
+        The node id and source route flags are written for version() > 1.
+        If \p data is nullptr only the required size is calculated.
+        \param data buffer to write to
+        \param size size of \p data in bytes
+        \returns number of bytes written or required, 0 if the request is invalid or \p size is too small
+     */
+    int writeToBuffer(uint8_t *data, unsigned size) const;
+    /*! Reads a request in the same format as writeToBuffer() from \p data of \p size bytes.
+        The node id and source route flags are read for version() > 1.
+        \returns number of bytes read, 0 if the data is malformed
+     */
+    int readFromBuffer(const uint8_t *data, unsigned size);
     /*! Resets the request parameters. */
     void clear();
 
@@ -387,6 +401,10 @@ public:
     uint32_t txTime() const;
     /*!  Reads a confirm from the \p stream which must be in a ZigBee standard conform format. */
     void readFromStream(QDataStream &stream);
+    /*! Reads a confirm in the same format as readFromStream() from \p data of \p size bytes.
+        \returns number of bytes read, 0 if the data is malformed
+     */
+    int readFromBuffer(const uint8_t *data, unsigned size);
 
 private:
     Address m_dstAddr{};
@@ -409,10 +427,14 @@ class DECONZ_DLLSPEC ApsDataIndication
 public:
     /*! Constructor. */
     ApsDataIndication();
-    /*! Copy constructor. */
+    /*! Copy constructor, the ASDU buffer is shared and not copied. */
     ApsDataIndication(const ApsDataIndication &other);
-    /*! Copy constructor. */
+    /*! Move constructor. */
+    ApsDataIndication(ApsDataIndication &&other) noexcept;
+    /*! Copy assignment operator, the ASDU buffer is shared and not copied. */
     ApsDataIndication &operator=(const ApsDataIndication &other);
+    /*! Move assignment operator. */
+    ApsDataIndication &operator=(ApsDataIndication &&other) noexcept;
     /*! Deconstructor. */
     ~ApsDataIndication();
     /*! Returns the destination address mode. */
@@ -477,6 +499,11 @@ public:
     quint16 previousHop() const;
     /*! Reads a ZigBee standard conform indication from stream. */
     void readFromStream(QDataStream &stream);
+    /*! Reads a indication in the same format as readFromStream() from \p data of \p size bytes.
+        The ASDU is copied once into the shared ASDU buffer.
+        \returns number of bytes read, 0 if the data is malformed
+     */
+    int readFromBuffer(const uint8_t *data, unsigned size);
     /*! Writes a ZigBee standard conform indication to stream. */
     void writeToStream(QDataStream &stream) const;
     /* \cond INTERNAL_SYMBOLS */
@@ -510,6 +537,7 @@ uint8_t DECONZ_DLLSPEC APS_NextApsRequestId();
 
 Q_DECLARE_METATYPE(deCONZ::ApsDataRequest)
 Q_DECLARE_METATYPE(deCONZ::ApsDataConfirm)
+Q_DECLARE_METATYPE(std::vector<deCONZ::ApsDataConfirm>)
 Q_DECLARE_METATYPE(deCONZ::ApsDataIndication)
 
 #endif // DECONZ_APS_H
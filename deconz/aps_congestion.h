@@ -0,0 +1,119 @@
+#ifndef DECONZ_APS_CONGESTION_H
+#define DECONZ_APS_CONGESTION_H
+
+/*
+ * Copyright (c) 2012-2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include <cstdint>
+#include "deconz/aps.h"
+#include "deconz/timeref.h"
+#include "deconz/declspec.h"
+
+namespace deCONZ {
+
+class ApsCongestionControlPrivate;
+class ApsRequestSchedulerPrivate;
+
+/*! Congestion state of a destination node.
+    \sa ApsCongestionControl::state()
+ */
+struct ApsCongestionState
+{
+    int window = 0; //!< Allowed number of unconfirmed requests.
+    int pacingMs = 0; //!< Minimum interval between two requests.
+    int srttMs = 0; //!< Smoothed confirm latency, 0 if unknown.
+    int failureRate = 0; //!< Smoothed rate of congestion failures in percent.
+    int inFlight = 0; //!< Number of unconfirmed requests.
+};
+
+/*!
+    \ingroup aps
+    \class ApsCongestionControl
+    \brief Adapts the APS request rate per destination node to confirm latency and failures.
+
+    For each destination the latency between sending a request and receiving its
+    APSDE-DATA.confirm is tracked as smoothed round trip time. The allowed number of
+    unconfirmed requests (window) grows by one per window of successful confirms and is
+    halved on failures which indicate congestion, like missing APS or MAC ACKs and route
+    errors, or when a confirm arrives much later than usual (AIMD). The window is reduced
+    at most once per round trip time, so a burst of failures counts as one event.
+
+    Requests to a node are paced by the round trip time divided by the window, after
+    failures an exponential backoff is applied on top. Other failures, like invalid
+    parameters, don't affect the state.
+
+    The ApsController provides an instance which is updated by the ApsRequestScheduler when
+    attached via ApsRequestScheduler::setCongestionControl(). Plugins can query the state
+    to defer optional traffic like periodic attribute reads.
+
+\code {cpp}
+
+    deCONZ::ApsController *ctrl = deCONZ::ApsController::instance();
+    const deCONZ::ApsCongestionState cs = ctrl->congestionControl()->state(node->address());
+
+    if (cs.inFlight >= cs.window)
+    {
+        // node is busy, try later
+    }
+
+\endcode
+ */
+class DECONZ_DLLSPEC ApsCongestionControl
+{
+public:
+    enum Constants
+    {
+        InitialWindow = 2,
+        MinWindow = 1,
+        MaxWindow = 8,
+        MinBackoffMs = 100,
+        MaxPacingMs = 5000,
+        MaxNodes = 1024
+    };
+
+    /*! Constructor. */
+    ApsCongestionControl();
+    /*! Deconstructor. */
+    ~ApsCongestionControl();
+    ApsCongestionControl(const ApsCongestionControl &) = delete;
+    ApsCongestionControl &operator=(const ApsCongestionControl &) = delete;
+
+    /*! Records that \p req was passed to the firmware at time \p now. */
+    void requestSent(const ApsDataRequest &req, SteadyTimeRef now);
+    /*! Updates the state of the destination of the related request.
+        Confirms without a preceding requestSent() are ignored.
+     */
+    void confirmReceived(const ApsDataConfirm &conf, SteadyTimeRef now);
+    /*! Returns the allowed number of unconfirmed requests to the destination of \p req. */
+    int window(const ApsDataRequest &req) const;
+    /*! Returns the earliest time the next request to the destination of \p req should be sent,
+        invalid if it can be sent right away.
+     */
+    SteadyTimeRef nextSendTime(const ApsDataRequest &req) const;
+    /*! Returns the state of the node with address \p addr.
+        Nodes are keyed by nwk address, a ext address is resolved via ApsController::resolveAddress().
+        For unknown nodes the initial state is returned.
+     */
+    ApsCongestionState state(const Address &addr) const;
+    /*! Resets the state of all nodes. */
+    void clear();
+
+private:
+    friend class ApsRequestSchedulerPrivate;
+    int windowForKey(uint64_t key) const;
+    SteadyTimeRef nextSendTimeForKey(uint64_t key) const;
+    void requestSentForKey(uint64_t key, uint8_t id, SteadyTimeRef now);
+
+    ApsCongestionControlPrivate *d_ptr = nullptr;
+};
+
+} // namespace deCONZ
+
+#endif // DECONZ_APS_CONGESTION_H
@@ -107,6 +107,7 @@ enum VariantMapParameter
     ParamLinkKey
 };
 
+class ApsCongestionControl;
 class Node;
 class NodeEvent;
 class SourceRoute;
@@ -300,6 +301,14 @@ public:
      */
     virtual uint8_t nextRequestId() = 0;
 
+    /*! Returns the congestion state of all destination nodes.
+
+        The state is updated by a ApsRequestScheduler with this congestion control attached,
+        when requests are handed out and their confirms are passed to ApsRequestScheduler::confirm().
+        Plugins can query it to defer optional traffic to busy nodes.
+     */
+    ApsCongestionControl *congestionControl();
+
 Q_SIGNALS:
     /*! Is emitted on the reception of a APSDE-DATA.confirm primitive.
 
@@ -0,0 +1,185 @@
+#ifndef DECONZ_APS_SCHEDULER_H
+#define DECONZ_APS_SCHEDULER_H
+
+/*
+ * Copyright (c) 2012-2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include <vector>
+#include "deconz/aps.h"
+#include "deconz/timeref.h"
+#include "deconz/declspec.h"
+
+namespace deCONZ {
+
+class ApsCongestionControl;
+class ApsRequestSchedulerPrivate;
+
+/*! Callback which receives the confirms of a ApsRequestScheduler::enqueueBatch() call.
+    \param user the pointer given to ApsRequestScheduler::setBatchConfirmCallback()
+    \param confirms one confirm per enqueued request in request order
+ */
+typedef void (*ApsBatchConfirmCallback)(void *user, const std::vector<ApsDataConfirm> &confirms);
+
+/*!
+    \ingroup aps
+    \class ApsRequestScheduler
+    \brief Time ordered queue of APSDE-DATA.request primitives for ApsController implementations.
+
+    Requests are held back until ApsDataRequest::sendAfter() and ApsDataRequest::sendDelay()
+    have passed. Requests which are due are handed out round-robin across destination nodes,
+    so a single chatty device can't starve the others. Per node only maxInFlightPerNode()
+    requests are handed out until they are confirmed, requests to the same node are handed
+    out in the order they become due.
+
+    Requests whose ApsDataRequest::timeout() passes before they are handed out are removed
+    by expire(). Enqueue and dequeue are O(log n).
+
+    A handed out request stays in flight until confirm() is called with its id, another
+    request with the same id is handed out or inFlightTimeout() passes, so a lost confirm
+    doesn't block the node.
+
+    With an attached ApsCongestionControl the per node limit and pacing adapt to the
+    confirm latency and failures of each node.
+
+    Bursts like a scene recall to many lights can be added with enqueueBatch() in one pass.
+    The confirms of a batch are collected and reported once via the callback set by
+    setBatchConfirmCallback() when all its requests are finished. Requests whose confirm
+    got lost or which expired are reported with MacTransactionExpiredStatus.
+
+\code {cpp}
+
+    deCONZ::ApsRequestScheduler scheduler;
+
+    // ApsController::apsdeDataRequest()
+    scheduler.enqueue(req, deCONZ::steadyTimeRef());
+
+    // or a group of requests, reported once via the batch callback
+    scheduler.setBatchConfirmCallback(batchConfirmed, this);
+    scheduler.enqueueBatch(reqs.data(), int(reqs.size()), nullptr, deCONZ::steadyTimeRef());
+
+    // send loop
+    deCONZ::ApsDataRequest req;
+    std::vector<deCONZ::ApsDataRequest> expired;
+    const deCONZ::SteadyTimeRef now = deCONZ::steadyTimeRef();
+
+    scheduler.expire(now, &expired); // emit failure confirms for these
+    while (scheduler.dequeue(now, req))
+    {
+        // send req to firmware
+    }
+
+    // on APSDE-DATA.confirm
+    scheduler.confirm(conf, deCONZ::steadyTimeRef());
+
+\endcode
+ */
+class DECONZ_DLLSPEC ApsRequestScheduler
+{
+public:
+    enum Constants
+    {
+        DefaultMaxInFlightPerNode = 2,
+        DefaultMaxQueueSize = 512,
+        DefaultInFlightTimeoutMs = 20000
+    };
+
+    /*! Constructor. */
+    ApsRequestScheduler();
+    /*! Deconstructor. */
+    ~ApsRequestScheduler();
+    ApsRequestScheduler(const ApsRequestScheduler &) = delete;
+    ApsRequestScheduler &operator=(const ApsRequestScheduler &) = delete;
+
+    /*! Returns the maximum number of unconfirmed requests per destination node. */
+    int maxInFlightPerNode() const;
+    /*! Sets the maximum number of unconfirmed requests per destination node, at least 1.
+        Not used while a congestion control is attached.
+     */
+    void setMaxInFlightPerNode(int max);
+    /*! Returns the maximum number of queued requests. */
+    int maxQueueSize() const;
+    /*! Sets the maximum number of queued requests. */
+    void setMaxQueueSize(int max);
+    /*! Returns the time in milliseconds after which an unconfirmed request is no longer in flight. */
+    int inFlightTimeout() const;
+    /*! Sets the in-flight timeout in milliseconds, at least 1. */
+    void setInFlightTimeout(int ms);
+
+    /*! Returns the attached congestion control, or nullptr. */
+    ApsCongestionControl *congestionControl() const;
+    /*! Attaches a congestion control which provides the per node in-flight window and pacing.
+        Handed out requests are reported via ApsCongestionControl::requestSent(), confirms
+        passed to confirm(const ApsDataConfirm&, SteadyTimeRef) via
+        ApsCongestionControl::confirmReceived().
+        \param cc the congestion control, nullptr to detach, it must outlive the scheduler
+     */
+    void setCongestionControl(ApsCongestionControl *cc);
+
+    /*! Adds a request to the queue.
+        \param req the request, ApsDataRequest::sendDelay() is relative to \p now
+        \param now the current time
+        \retval Success the request is enqueued
+        \retval ErrorQueueIsFull maxQueueSize() is reached
+     */
+    int enqueue(const ApsDataRequest &req, SteadyTimeRef now);
+    /*! Adds \p count requests to the queue in one pass.
+        Requests beyond maxQueueSize() aren't enqueued. Once all enqueued requests are
+        confirmed, lost or expired the batch callback is invoked once.
+        \param requests array of \p count requests
+        \param count number of requests
+        \param results optional array of \p count elements which receives the enqueue() result of each request
+        \param now the current time
+        \return number of enqueued requests
+     */
+    int enqueueBatch(const ApsDataRequest *requests, int count, int *results, SteadyTimeRef now);
+    /*! Sets the callback which receives the confirms of enqueueBatch() calls.
+        The callback may call into the scheduler.
+        \param callback the callback, nullptr to disable
+        \param user pointer passed to the callback
+     */
+    void setBatchConfirmCallback(ApsBatchConfirmCallback callback, void *user);
+    /*! Takes the next request which is due and whose node is below the in-flight limit.
+        The request counts as in flight until confirm() is called with its id,
+        the id is handed out again or inFlightTimeout() passes.
+        \returns true if \p req was set
+     */
+    bool dequeue(SteadyTimeRef now, ApsDataRequest &req);
+    /*! Marks the in-flight request \p id as finished, its node may receive the next request.
+        For requests of a batch the confirm is reported as failure, use the overload below.
+     */
+    void confirm(uint8_t id);
+    /*! Marks the in-flight request of \p conf as finished and passes it to the attached
+        congestion control and the batch of the request.
+     */
+    void confirm(const ApsDataConfirm &conf, SteadyTimeRef now);
+    /*! Removes queued requests whose timeout passed.
+        In flight requests whose inFlightTimeout() passed are released silently.
+        \param expired if not nullptr the removed requests are appended
+        \returns number of removed requests
+     */
+    int expire(SteadyTimeRef now, std::vector<ApsDataRequest> *expired);
+    /*! Returns the earliest sendAfter, timeout, pacing or in-flight timeout time, invalid if there is none.
+        Can be used to arm a timer, requests which are due already aren't considered.
+     */
+    SteadyTimeRef nextDeadline() const;
+    /*! Returns the number of queued requests, in flight requests not included. */
+    int size() const;
+    /*! Returns the number of in flight requests. */
+    int inFlight() const;
+    /*! Removes all queued and in flight requests, pending batches are dropped without callback. */
+    void clear();
+
+private:
+    ApsRequestSchedulerPrivate *d_ptr = nullptr;
+};
+
+} // namespace deCONZ
+
+#endif // DECONZ_APS_SCHEDULER_H
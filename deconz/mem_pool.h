@@ -2,7 +2,7 @@
 #define MEM_POOL_H
 
 /*
- * Copyright (c) 2012-2023 dresden elektronik ingenieurtechnik gmbh.
+ * Copyright (c) 2012-2025 dresden elektronik ingenieurtechnik gmbh.
  * All rights reserved.
  *
  * The software in this package is published under the terms of the BSD
@@ -11,49 +11,143 @@
  *
  */
 
-#include <algorithm>
-#include <array>
 #include <cassert>
+#include <cstddef>
 #include <tuple>
+#include <vector>
 
-template <typename T, typename Tuple>
-auto &MEM_GetAllocContainer(Tuple &t)
+/*! Counters of a MEM_Pool. */
+struct MEM_PoolStats
 {
-    return std::get<std::array<T*, T::PoolSize>>(t);
-}
+    unsigned long hits = 0; //!< Allocations served from the free list.
+    unsigned long misses = 0; //!< Allocations which found the free list empty.
+    unsigned long drops = 0; //!< Releases which deleted the object since the free list was full.
+};
 
-template <typename T, typename MemTuple>
-T *MEM_AllocItem(MemTuple *m)
+/*! Typed pool of constructed objects with O(1) alloc and release.
+
+    Released objects are kept in a free list and handed out again, they
+    aren't destructed in between. When the free list is empty it grows by
+    a slab of T::PoolSize objects, up to MaxSlabs slabs. Above this limit
+    allocations fall back to new and releases to delete.
+
+    Each object is allocated on its own, so any object may still be released
+    with delete, for example on threads which don't own the pool.
+ */
+template <typename T>
+class MEM_Pool
 {
-    assert(m);
-    auto &cont = MEM_GetAllocContainer<T>(*m);
+public:
+    enum Constants { SlabSize = T::PoolSize, MaxSlabs = 8 };
 
-    auto i = std::find_if(std::begin(cont), std::end(cont), [](const auto &i) { return i != nullptr; });
+    MEM_Pool() = default;
+    MEM_Pool(const MEM_Pool&) = delete;
+    MEM_Pool &operator=(const MEM_Pool&) = delete;
+
+    ~MEM_Pool()
+    {
+        for (T *p : m_free)
+        {
+            delete p;
+        }
+    }
 
-    if (i != cont.end())
+    T *alloc()
     {
-        auto *p = *i;
-        *i = nullptr;
+        if (m_free.empty())
+        {
+            m_stats.misses++;
+            grow();
+
+            if (m_free.empty())
+            {
+                return new T;
+            }
+        }
+        else
+        {
+            m_stats.hits++;
+        }
+
+        T *p = m_free.back();
+        m_free.pop_back();
         return p;
     }
 
-    return new T;
+    void release(T *p)
+    {
+        if (!p)
+        {
+            return;
+        }
+
+        if (m_free.size() < capacity())
+        {
+            m_free.push_back(p); // no reallocation, reserved in grow()
+            return;
+        }
+
+        m_stats.drops++;
+        delete p;
+    }
+
+    /*! Returns the maximum number of objects in the free list. */
+    size_t capacity() const { return size_t(m_slabs) * SlabSize; }
+    /*! Returns the number of objects in the free list. */
+    size_t available() const { return m_free.size(); }
+    const MEM_PoolStats &stats() const { return m_stats; }
+
+private:
+    void grow()
+    {
+        if (m_slabs == MaxSlabs)
+        {
+            return;
+        }
+
+        m_slabs++;
+        m_free.reserve(capacity());
+
+        for (int i = 0; i < SlabSize; i++)
+        {
+            m_free.push_back(new T);
+        }
+    }
+
+    std::vector<T*> m_free;
+    MEM_PoolStats m_stats;
+    int m_slabs = 0;
+};
+
+/*! Returns the pool of the calling thread, it is destroyed when the thread exits.
+
+    Can be used as per thread cache by threads which don't own a MEM_Pool.
+ */
+template <typename T>
+MEM_Pool<T> &MEM_ThreadPool()
+{
+    static thread_local MEM_Pool<T> pool;
+    return pool;
+}
+
+template <typename T, typename Tuple>
+auto &MEM_GetAllocContainer(Tuple &t)
+{
+    return std::get<MEM_Pool<T>>(t);
+}
+
+template <typename T, typename MemTuple>
+T *MEM_AllocItem(MemTuple *m)
+{
+    assert(m);
+    return MEM_GetAllocContainer<T>(*m).alloc();
 }
 
 template <typename T, typename MemTuple>
 void MEM_DeallocItem(T *priv, MemTuple *m)
 {
     assert(m);
-    auto &cont = MEM_GetAllocContainer<T>(*m);
-    auto i = std::find(std::begin(cont), std::end(cont), nullptr);
-
-    if (i != cont.end())
-    {
-        *i = priv;
-        return;
-    }
-
-    delete priv;
+    MEM_GetAllocContainer<T>(*m).release(priv);
 }
 
 #endif // MEM_POOL_H
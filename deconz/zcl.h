@@ -259,6 +259,103 @@ namespace deCONZ
     /*! Reads ZclDataTypeId_t as quint8 from the QDataStream. */
     DECONZ_DLLSPEC QDataStream & operator>>(QDataStream &ds, ZclDataTypeId_t &id);
 
+    /*! Flags of ZclDataTypeTraits. */
+    enum ZclDataTypeFlags : uint16_t
+    {
+        ZclTypeValid      = 0x0001, //!< Data type is defined in the ZCL specification.
+        ZclTypeKnown      = 0x0002, //!< Data type is supported by ZclAttribute, see ZclDataBase::knownDataType().
+        ZclTypeSigned     = 0x0004, //!< Signed integer or floating point data type.
+        ZclTypeAnalog     = 0x0008, //!< Analog data type.
+        ZclTypeDiscrete   = 0x0010, //!< Discrete data type.
+        ZclTypeString     = 0x0020, //!< Octet or character string.
+        ZclTypeCollection = 0x0040, //!< Array, set or bag.
+        ZclTypeStruct     = 0x0080, //!< Structure.
+        ZclTypeLongLength = 0x0100, //!< Length prefix has two bytes (long strings, collections and structures).
+        ZclTypeHasInvalid = 0x0200  //!< ZclDataTypeTraits::invalidValue holds the invalid (non-value).
+    };
+
+    /*! \struct ZclDataTypeTraits
+
+        Compile-time properties of a ZCL data type, see ZCL_DataTypeTraits().
+        Unlike ZclDataType no ZCLDB lookup is needed, ZclDataType is only required for names.
+     */
+    struct ZclDataTypeTraits
+    {
+        uint8_t width; //!< Byte width of fixed size data types, 0 for variable size data types.
+        uint16_t flags; //!< ZclDataTypeFlags
+        uint64_t invalidValue; //!< Raw value which means invalid, for variable size data types the length or count.
+    };
+
+    /* \cond INTERNAL_SYMBOLS */
+    constexpr uint64_t ZCL_UintMax(unsigned width)
+    {
+        return width >= 8 ? ~uint64_t(0) : (uint64_t(1) << (8 * width)) - 1;
+    }
+
+    constexpr ZclDataTypeTraits ZCL_MakeDataTypeTraits(unsigned id)
+    {
+        constexpr uint16_t V = ZclTypeValid;
+        constexpr uint16_t K = ZclTypeValid | ZclTypeKnown;
+        constexpr uint16_t A = ZclTypeAnalog;
+        constexpr uint16_t D = ZclTypeDiscrete;
+        constexpr uint16_t S = ZclTypeSigned;
+        constexpr uint16_t I = ZclTypeHasInvalid;
+        constexpr uint16_t L = ZclTypeLongLength;
+
+        if (id >= Zcl8BitData && id <= Zcl64BitData)     { return { uint8_t(id - Zcl8BitData + 1), K | D, 0 }; }
+        if (id >= Zcl8BitBitMap && id <= Zcl64BitBitMap) { return { uint8_t(id - Zcl8BitBitMap + 1), K | D, 0 }; }
+        if (id >= Zcl8BitUint && id <= Zcl64BitUint)     { return { uint8_t(id - Zcl8BitUint + 1), K | A | I, ZCL_UintMax(id - Zcl8BitUint + 1) }; }
+        if (id >= Zcl8BitInt && id <= Zcl64BitInt)       { return { uint8_t(id - Zcl8BitInt + 1), K | A | S | I, uint64_t(1) << (8 * (id - Zcl8BitInt + 1) - 1) }; }
+
+        switch (id)
+        {
+        case ZclBoolean:             return { 1, K | D | I, 0xFF };
+        case Zcl8BitEnum:            return { 1, K | D | I, 0xFF };
+        case Zcl16BitEnum:           return { 2, K | D | I, 0xFFFF };
+        case ZclSemiFloat:           return { 2, V | A | S, 0 };
+        case ZclSingleFloat:         return { 4, K | A | S, 0 };
+        case ZclDoubleFloat:         return { 8, V | A | S, 0 };
+        case ZclOctedString:         return { 0, K | D | I | ZclTypeString, 0xFF };
+        case ZclCharacterString:     return { 0, K | D | I | ZclTypeString, 0xFF };
+        case ZclLongOctedString:     return { 0, V | D | I | L | ZclTypeString, 0xFFFF };
+        case ZclLongCharacterString: return { 0, V | D | I | L | ZclTypeString, 0xFFFF };
+        case ZclArray:               return { 0, K | D | I | L | ZclTypeCollection, 0xFFFF };
+        case 0x50: /* set */         return { 0, V | D | I | L | ZclTypeCollection, 0xFFFF };
+        case 0x51: /* bag */         return { 0, V | D | I | L | ZclTypeCollection, 0xFFFF };
+        case ZclStruct:              return { 0, V | D | I | L | ZclTypeStruct, 0xFFFF };
+        case ZclTimeOfDay:           return { 4, V | A | I, 0xFFFFFFFF };
+        case ZclDate:                return { 4, V | A | I, 0xFFFFFFFF };
+        case ZclUtcTime:             return { 4, K | A | I, 0xFFFFFFFF };
+        case ZclClusterId:           return { 2, K | D | I, 0xFFFF };
+        case ZclAttributeId:         return { 2, K | D | I, 0xFFFF };
+        case ZclBACNetOId:           return { 4, V | D | I, 0xFFFFFFFF };
+        case ZclIeeeAddress:         return { 8, K | D | I, ~uint64_t(0) };
+        case Zcl128BitSecurityKey:   return { 16, K | D, 0 };
+        default:
+            break;
+        }
+
+        return { 0, 0, 0 };
+    }
+    /* \endcond */
+
+    /* \cond INTERNAL_SYMBOLS */
+    extern DECONZ_DLLSPEC const ZclDataTypeTraits ZCL_DataTypeTraitsTable[256];
+    /* \endcond */
+
+    /*! Returns the traits of the data type \p id (ZclDataTypeId).
+        Unknown data types have no flags set.
+        The lookup table is built at compile time, use ZCL_MakeDataTypeTraits() in constant expressions.
+     */
+    inline ZclDataTypeTraits ZCL_DataTypeTraits(uint8_t id)
+    {
+        return ZCL_DataTypeTraitsTable[id];
+    }
+
+    static_assert(ZCL_MakeDataTypeTraits(Zcl24BitUint).width == 3, "unexpected uint24 width");
+    static_assert(ZCL_MakeDataTypeTraits(Zcl16BitInt).invalidValue == 0x8000, "unexpected int16 invalid value");
+    static_assert(ZCL_MakeDataTypeTraits(Zcl128BitSecurityKey).width == 16, "unexpected key width");
+
 /*! \ingroup cpp_literals
     \brief Literal to create ZclDataTypeId_t.
     \since v2.6.1
@@ -676,6 +773,12 @@ Shorthand for creating type safe manufacturer codes from numbers but without cas
         \ingroup zcl
         \class ZclAttribute
         \brief Represents a ZigBee cluster attribute.
+
+        Attributes of clusters from a ZclDataBaseSnapshot can be read from any thread:
+        the const getters, toString() and toVariant() only use the attribute itself and
+        the published snapshot, see zclSnapshot(). The same applies to decoding into a
+        copy via readFromStream() and readFromBuffer(). The setters modify the attribute
+        and must not be used concurrently on the same object.
      */
     class DECONZ_DLLSPEC ZclAttribute
     {
@@ -804,6 +907,15 @@ Shorthand for creating type safe manufacturer codes from numbers but without cas
         bool writeToStream(QDataStream &stream) const;
         /*! Reads the attribute from \p stream. */
         bool readFromStream(QDataStream &stream);
+        /*! Reads the attribute from the raw buffer \p data with \p size bytes.
+            \returns number of bytes consumed, or 0 on error
+         */
+        int readFromBuffer(const uint8_t *data, unsigned size);
+        /*! Writes the attribute value to the caller provided buffer \p data with \p size bytes.
+            If \p data is nullptr only the required size is calculated.
+            \returns number of bytes written or required, 0 if not supported or \p size is too small
+         */
+        int writeToBuffer(uint8_t *data, unsigned size) const;
         /*! Returns the attribute as string representation. */
         QString toString(FormatHint formatHint = DefaultFormat) const;
         /*! Returns the attribute as string representation for given data type. */
@@ -830,6 +942,11 @@ Shorthand for creating type safe manufacturer codes from numbers but without cas
         bool writeReportableChangeToStream(QDataStream &stream) const;
         /*! Reads the reportable change from \p stream TODO: describe. */
         bool readReportableChangeFromStream(QDataStream &stream);
+        /*! Writes the reportable change to the caller provided buffer \p data with \p size bytes.
+            If \p data is nullptr only the required size is calculated.
+            \returns number of bytes written or required, 0 if not supported or \p size is too small
+         */
+        int writeReportableChangeToBuffer(uint8_t *data, unsigned size) const;
         /*! Sets the format hint for GUI display. */
         void setFormatHint(FormatHint formatHint);
         /*! Returns the format hint for GUI display. */
@@ -985,6 +1102,13 @@ Shorthand for creating type safe manufacturer codes from numbers but without cas
             \param stream shall write to a ApsDatarequest::asdu() buffer
          */
         void writeToStream(QDataStream &stream);
+        /*! Writes the ZCL frame in ZigBee standard conform format to the caller provided buffer.
+            If \p data is nullptr only the required size is calculated.
+            \param data shall point to a ApsDatarequest::asdu() buffer
+            \param size size of \p data in bytes
+            \returns number of bytes written or required, 0 if \p size is too small
+         */
+        int writeToBuffer(uint8_t *data, unsigned size) const;
         /*! Reads a ZCL frame in ZigBee standard conform format from the \p stream.
             \param stream shall read from a ApsDatarequest::asdu() buffer
          */
@@ -1013,10 +1137,78 @@ Shorthand for creating type safe manufacturer codes from numbers but without cas
         void reset();
 
     private:
+        friend class ZclFrameView;
         ZclFramePrivate *d_ptr = nullptr;
         Q_DECLARE_PRIVATE(ZclFrame)
     };
 
+    /*!
+        \ingroup zcl
+        \class ZclFrameView
+        \brief Read-only view of a received ZCL frame.
+
+        In contrast to ZclFrame::readFromStream() the header is parsed in place and the
+        payload isn't copied, payload() points into the source buffer. The view is only
+        valid as long as the buffer, e.g. the ApsDataIndication::asdu(), isn't modified
+        or destroyed.
+
+\code {cpp}
+
+    deCONZ::ZclFrameView zclFrame(ind);
+
+    if (zclFrame.isValid() && zclFrame.isProfileWideCommand())
+    {
+        deCONZ::ZclAttributeRecord records[8];
+        unsigned n = deCONZ::ZCL_ParseAttributeRecords(zclFrame, records, 8);
+    }
+
+\endcode
+     */
+    class DECONZ_DLLSPEC ZclFrameView
+    {
+    public:
+        /*! Constructs a invalid view. */
+        ZclFrameView() = default;
+        /*! Parses the ZCL header from \p data of \p size bytes. */
+        ZclFrameView(const uint8_t *data, unsigned size);
+        /*! Parses the ZCL header from the ApsDataIndication::asdu() of \p ind. */
+        explicit ZclFrameView(const ApsDataIndication &ind);
+        /*! Returns true if the ZCL header could be parsed. */
+        bool isValid() const { return m_payload != nullptr; }
+        /*! Returns ZCL header frame control field. */
+        uint8_t frameControl() const { return m_frameControl; }
+        /*! Returns the vendor specific manufacturer code, 0x0000 if not manufacturer specific. */
+        uint16_t manufacturerCode() const { return m_manufacturerCode; }
+        /*! Returns the sequence number. */
+        uint8_t sequenceNumber() const { return m_seqNumber; }
+        /*! Returns the ZCL command identifier. */
+        uint8_t commandId() const { return m_commandId; }
+        /*! Returns true if the command is related to a cluster. */
+        bool isClusterCommand() const { return (m_frameControl & ZclFCClusterCommand) != 0; }
+        /*! Returns true if the command is profile wide (any ZclGeneralCommandId). */
+        bool isProfileWideCommand() const { return !isClusterCommand(); }
+        /*! Returns true if the ZCL frame is a default response. */
+        bool isDefaultResponse() const { return isProfileWideCommand() && m_commandId == ZclDefaultResponseId; }
+        /*! Returns the ZCL payload after the header, nullptr if the view isn't valid. */
+        const uint8_t *payload() const { return m_payload; }
+        /*! Returns the size of payload() in bytes. */
+        unsigned payloadSize() const { return m_payloadSize; }
+        /*! Returns the ZCL payload byte at given \p index.
+            If the index is out of bounds 0 is returned.
+         */
+        unsigned char payloadAt(unsigned index) const { return index < m_payloadSize ? m_payload[index] : 0; }
+        /*! Returns a ZclFrame copy of the view, for code which still requires a ZclFrame. */
+        ZclFrame toFrame() const;
+
+    private:
+        const uint8_t *m_payload = nullptr;
+        unsigned m_payloadSize = 0;
+        uint16_t m_manufacturerCode = 0;
+        uint8_t m_frameControl = 0;
+        uint8_t m_seqNumber = 0;
+        uint8_t m_commandId = 0;
+    };
+
     class ZclCommandPrivate;
 
     /*!
@@ -1089,6 +1281,7 @@ Shorthand for creating type safe manufacturer codes from numbers but without cas
         bool writeToStream(QDataStream &stream) const;
 
     private:
+        friend class ZclDataBase;
         ZclCommandPrivate *d_ptr = nullptr;
         Q_DECLARE_PRIVATE(ZclCommand)
     };
@@ -1164,6 +1357,7 @@ Shorthand for creating type safe cluster identifiers from numbers but without ca
     }
 
     class ZclClusterPrivate;
+    struct ZclCommandParameters;
 
     /*!
         \ingroup zcl
@@ -1236,6 +1430,29 @@ Shorthand for creating type safe cluster identifiers from numbers but without ca
         const std::vector<ZclAttributeSet> &attributeSets() const;
         /*! Reads a ZCL based command from a ZCL frame. */
         bool readCommand(const ZclFrame &zclFrame);
+        /*! Decodes the parameters of a ZCL based command into a caller owned block.
+
+            In contrast to readCommand(const ZclFrame&) the cluster isn't modified and
+            no memory is allocated, the parameter records point into the frame payload.
+
+            \returns true if all parameters of the command were decoded
+         */
+        bool readCommand(const ZclFrame &zclFrame, ZclCommandParameters &params) const;
+        /*! Overload which decodes the parameters from the payload of \p zclFrame without copying it. */
+        bool readCommand(const ZclFrameView &zclFrame, ZclCommandParameters &params) const;
+        /*! Returns the index in commands() of the command matching \p zclFrame or -1 if not found.
+
+            The frame direction and manufacturer code are considered, commands of the
+            manufacturer are preferred over others with the same id.
+         */
+        int commandIndex(const ZclFrame &zclFrame) const;
+        /*! Overload of commandIndex(const ZclFrame&) for a ZclFrameView. */
+        int commandIndex(const ZclFrameView &zclFrame) const;
+        /*! Returns the index in commands() of the command \p commandId or -1 if not found.
+            \param serverToClient direction of the received frame
+            \param mfcode manufacturer code of the frame, 0 if not manufacturer specific
+         */
+        int commandIndex(uint8_t commandId, bool serverToClient, uint16_t mfcode) const;
         /*! Reads a non-ZCL based single command (like ZDP) from APSDE-DATA.indication. */
         bool readCommand(const ApsDataIndication &ind);
         /*! Returns the modifiable list of commands. */
@@ -1244,6 +1461,7 @@ Shorthand for creating type safe cluster identifiers from numbers but without ca
         const std::vector<ZclCommand> &commands() const;
 
     private:
+        void detach();
         ZclClusterPrivate *d_ptr = nullptr;
         Q_DECLARE_PRIVATE(ZclCluster)
     };
@@ -1262,6 +1480,76 @@ Shorthand for creating type safe cluster identifiers from numbers but without ca
         /* \endcond */
     };
 
+    /*! \struct ZclAttributeRecord
+
+        A attribute record of a Read Attributes Response or Report Attributes payload
+        as decoded by ZCL_ParseAttributeRecords().
+
+        The record doesn't own any memory, \p data points into the parsed payload.
+     */
+    struct ZclAttributeRecord
+    {
+        NumericUnion numericValue; //!< Value of fixed size data types, signed integers of all widths are sign extended to 64-bit.
+        const uint8_t *data; //!< Raw value bytes in the payload, for strings without the length prefix,
+                             //!< arrays start with the element type and count.
+        uint16_t size; //!< Number of bytes in \p data.
+        uint16_t id; //!< Attribute identifier.
+        uint8_t dataType; //!< ZclDataTypeId.
+        uint8_t status; //!< ZCL status, always 0x00 for Report Attributes records.
+    };
+
+    /*! \struct ZclCommandParameters
+
+        Decoded parameters of a cluster specific command, see ZclCluster::readCommand().
+        One ZclAttributeRecord per parameter, \c status is unused.
+     */
+    struct ZclCommandParameters
+    {
+        enum Constants { MaxParameters = 16 };
+
+        const ZclCommand *command; //!< The command template in the cluster, valid as long as the cluster.
+        unsigned count; //!< Number of decoded entries in \p parameters.
+        ZclAttributeRecord parameters[MaxParameters];
+    };
+
+    /*! Decodes all attribute records of a Read Attributes Response or Report Attributes payload in one pass.
+
+        Parsing stops at the first malformed or unsupported record, the records before are returned.
+        Records with non success status have no data.
+
+        \param commandId ZclReadAttributesResponseId or ZclReportAttributesId
+        \param payload the ZCL payload after the ZCL header
+        \param size size of \p payload in bytes
+        \param records caller provided array to store the decoded records
+        \param maxRecords number of elements in \p records
+        \returns number of decoded records
+     */
+    DECONZ_DLLSPEC unsigned ZCL_ParseAttributeRecords(uint8_t commandId, const uint8_t *payload, unsigned size, ZclAttributeRecord *records, unsigned maxRecords);
+    /*! Overload which takes the payload and command from \p zclFrame. */
+    DECONZ_DLLSPEC unsigned ZCL_ParseAttributeRecords(const ZclFrame &zclFrame, ZclAttributeRecord *records, unsigned maxRecords);
+    /*! Overload which takes the payload and command from \p zclFrame without copying. */
+    DECONZ_DLLSPEC unsigned ZCL_ParseAttributeRecords(const ZclFrameView &zclFrame, ZclAttributeRecord *records, unsigned maxRecords);
+
+    /*! Writes the ZCL header of \p zclFrame followed by one record per attribute to a caller provided buffer.
+
+        The record format is selected by ZclFrame::commandId() of the profile wide command:
+
+        - ZclReadAttributesId: attribute id
+        - ZclWriteAttributesId, ZclWriteAttributesUndividedId, ZclWriteAttributesNoResponseId
+          and ZclReportAttributesId: attribute id, data type, value
+        - ZclReadAttributesResponseId: attribute id, status success, data type, value
+        - ZclConfigureReportingId: direction 0x00, attribute id, data type, min and max report interval
+          and the reportable change for analog data types
+
+        The ZclFrame::payload() of \p zclFrame isn't written. Call with \p data set to nullptr
+        to get the required size, so that ApsDataRequest::asdu() can be sized once.
+
+        \returns number of bytes written or required, 0 if a record isn't supported or \p size is too small
+     */
+    DECONZ_DLLSPEC unsigned ZCL_WriteAttributeRecords(const ZclFrame &zclFrame, const ZclAttribute *attributes, unsigned count, uint8_t *data, unsigned size);
+    /*! The lookups use the published ZCLDB snapshot and are safe to call from any thread.
+        Before the database is loaded unknown clusters and data types are returned.
+     */
     DECONZ_DLLSPEC ZclCluster ZCL_InCluster(uint16_t profileId, uint16_t clusterId, uint16_t mfcode);
     DECONZ_DLLSPEC ZclCluster ZCL_OutCluster(uint16_t profileId, uint16_t clusterId, uint16_t mfcode);
     DECONZ_DLLSPEC ZclDataType ZCL_DataType(uint8_t id);
@@ -0,0 +1,343 @@
+#ifndef DECONZ_ZCL_CLUSTERS_H
+#define DECONZ_ZCL_CLUSTERS_H
+
+/*
+ * Copyright (c) 2012-2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include <deconz/zcl.h>
+
+/*!
+    \defgroup zcl_clusters Specialized cluster decoders
+    \ingroup zcl
+    \brief Typed attribute decoding of the most common clusters.
+
+    Attribute reports and read responses of well known clusters can be decoded
+    directly into plain structs without looking up the cluster in the ZCL database.
+    The records are obtained by ZCL_ParseAttributeRecords().
+
+    Each struct has a \c present bitmap with one bit per field, it is set when
+    the field was decoded. Records with unknown attribute identifiers or
+    unexpected data types aren't decoded and need to be handled by the generic
+    ZclAttribute based code.
+
+    Records carry neither the cluster id nor the manufacturer code. The caller
+    must check that the frame belongs to the cluster of the struct, records of
+    manufacturer specific frames are passed to the fallback when the frame is
+    given to ZCL_DecodeAttributes().
+
+\code {cpp}
+
+    deCONZ::ZclAttributeRecord records[8];
+    const deCONZ::ZclAttributeRecord *fallback[8];
+    deCONZ::ZclOnOffAttributes onOff{};
+
+    if (deCONZ::ZclClusterId_t(ind.clusterId()) != deCONZ::ZclOnOffAttributes::clusterId)
+    {
+        return;
+    }
+
+    unsigned n = deCONZ::ZCL_ParseAttributeRecords(zclFrame, records, 8);
+    unsigned nFallback = deCONZ::ZCL_DecodeAttributes(zclFrame, records, n, onOff, fallback);
+
+    if (onOff.present & deCONZ::ZclOnOffAttributes::HasOnOff)
+    {
+        // use onOff.onOff
+    }
+
+\endcode
+ */
+
+namespace deCONZ {
+
+/*! \ingroup zcl_clusters
+    On/Off cluster 0x0006 server attributes.
+ */
+struct ZclOnOffAttributes
+{
+    static constexpr ZclClusterId_t clusterId = 0x0006_clid;
+    enum Present : uint32_t
+    {
+        HasOnOff               = 1 << 0,
+        HasGlobalSceneControl  = 1 << 1,
+        HasOnTime              = 1 << 2,
+        HasOffWaitTime         = 1 << 3,
+        HasStartUpOnOff        = 1 << 4
+    };
+
+    uint32_t present;
+    uint8_t onOff;              //!< 0x0000 boolean
+    uint8_t globalSceneControl; //!< 0x4000 boolean
+    uint16_t onTime;            //!< 0x4001 uint16, 1/10 seconds
+    uint16_t offWaitTime;       //!< 0x4002 uint16, 1/10 seconds
+    uint8_t startUpOnOff;       //!< 0x4003 enum8
+};
+
+/*! \ingroup zcl_clusters
+    Level Control cluster 0x0008 server attributes.
+ */
+struct ZclLevelControlAttributes
+{
+    static constexpr ZclClusterId_t clusterId = 0x0008_clid;
+    enum Present : uint32_t
+    {
+        HasCurrentLevel         = 1 << 0,
+        HasRemainingTime        = 1 << 1,
+        HasOptions              = 1 << 2,
+        HasOnOffTransitionTime  = 1 << 3,
+        HasOnLevel              = 1 << 4,
+        HasStartUpCurrentLevel  = 1 << 5
+    };
+
+    uint32_t present;
+    uint8_t currentLevel;           //!< 0x0000 uint8
+    uint16_t remainingTime;         //!< 0x0001 uint16, 1/10 seconds
+    uint8_t options;                //!< 0x000F bitmap8
+    uint16_t onOffTransitionTime;   //!< 0x0010 uint16, 1/10 seconds
+    uint8_t onLevel;                //!< 0x0011 uint8
+    uint8_t startUpCurrentLevel;    //!< 0x4000 uint8
+};
+
+/*! \ingroup zcl_clusters
+    Color Control cluster 0x0300 server attributes.
+ */
+struct ZclColorControlAttributes
+{
+    static constexpr ZclClusterId_t clusterId = 0x0300_clid;
+    enum Present : uint32_t
+    {
+        HasCurrentHue           = 1 << 0,
+        HasCurrentSaturation    = 1 << 1,
+        HasRemainingTime        = 1 << 2,
+        HasCurrentX             = 1 << 3,
+        HasCurrentY             = 1 << 4,
+        HasColorTemperature     = 1 << 5,
+        HasColorMode            = 1 << 6,
+        HasEnhancedCurrentHue   = 1 << 7,
+        HasEnhancedColorMode    = 1 << 8,
+        HasColorCapabilities    = 1 << 9,
+        HasColorTempPhysicalMin = 1 << 10,
+        HasColorTempPhysicalMax = 1 << 11
+    };
+
+    uint32_t present;
+    uint8_t currentHue;             //!< 0x0000 uint8
+    uint8_t currentSaturation;      //!< 0x0001 uint8
+    uint16_t remainingTime;         //!< 0x0002 uint16, 1/10 seconds
+    uint16_t currentX;              //!< 0x0003 uint16
+    uint16_t currentY;              //!< 0x0004 uint16
+    uint16_t colorTemperature;      //!< 0x0007 uint16, mireds
+    uint8_t colorMode;              //!< 0x0008 enum8
+    uint16_t enhancedCurrentHue;    //!< 0x4000 uint16
+    uint8_t enhancedColorMode;      //!< 0x4001 enum8
+    uint16_t colorCapabilities;     //!< 0x400A bitmap16
+    uint16_t colorTempPhysicalMin;  //!< 0x400B uint16, mireds
+    uint16_t colorTempPhysicalMax;  //!< 0x400C uint16, mireds
+};
+
+/*! \ingroup zcl_clusters
+    Temperature Measurement cluster 0x0402 server attributes.
+ */
+struct ZclTemperatureAttributes
+{
+    static constexpr ZclClusterId_t clusterId = 0x0402_clid;
+    enum Present : uint32_t
+    {
+        HasMeasuredValue    = 1 << 0,
+        HasMinMeasuredValue = 1 << 1,
+        HasMaxMeasuredValue = 1 << 2,
+        HasTolerance        = 1 << 3
+    };
+
+    uint32_t present;
+    int16_t measuredValue;      //!< 0x0000 int16, 1/100 °C
+    int16_t minMeasuredValue;   //!< 0x0001 int16
+    int16_t maxMeasuredValue;   //!< 0x0002 int16
+    uint16_t tolerance;         //!< 0x0003 uint16
+};
+
+/*! \ingroup zcl_clusters
+    Relative Humidity Measurement cluster 0x0405 server attributes.
+ */
+struct ZclHumidityAttributes
+{
+    static constexpr ZclClusterId_t clusterId = 0x0405_clid;
+    enum Present : uint32_t
+    {
+        HasMeasuredValue    = 1 << 0,
+        HasMinMeasuredValue = 1 << 1,
+        HasMaxMeasuredValue = 1 << 2,
+        HasTolerance        = 1 << 3
+    };
+
+    uint32_t present;
+    uint16_t measuredValue;     //!< 0x0000 uint16, 1/100 %
+    uint16_t minMeasuredValue;  //!< 0x0001 uint16
+    uint16_t maxMeasuredValue;  //!< 0x0002 uint16
+    uint16_t tolerance;         //!< 0x0003 uint16
+};
+
+/*! \ingroup zcl_clusters
+    IAS Zone cluster 0x0500 server attributes.
+ */
+struct ZclIasZoneAttributes
+{
+    static constexpr ZclClusterId_t clusterId = 0x0500_clid;
+    enum Present : uint32_t
+    {
+        HasZoneState        = 1 << 0,
+        HasZoneType         = 1 << 1,
+        HasZoneStatus       = 1 << 2,
+        HasIasCieAddress    = 1 << 3,
+        HasZoneId           = 1 << 4
+    };
+
+    uint32_t present;
+    uint8_t zoneState;          //!< 0x0000 enum8
+    uint16_t zoneType;          //!< 0x0001 enum16
+    uint16_t zoneStatus;        //!< 0x0002 bitmap16
+    uint64_t iasCieAddress;     //!< 0x0010 IEEE address
+    uint8_t zoneId;             //!< 0x0011 uint8
+};
+
+/*! \ingroup zcl_clusters
+    Simple Metering cluster 0x0702 server attributes.
+ */
+struct ZclMeteringAttributes
+{
+    static constexpr ZclClusterId_t clusterId = 0x0702_clid;
+    enum Present : uint32_t
+    {
+        HasCurrentSummationDelivered    = 1 << 0,
+        HasCurrentSummationReceived     = 1 << 1,
+        HasStatus                       = 1 << 2,
+        HasUnitOfMeasure                = 1 << 3,
+        HasMultiplier                   = 1 << 4,
+        HasDivisor                      = 1 << 5,
+        HasMeteringDeviceType           = 1 << 6,
+        HasInstantaneousDemand          = 1 << 7
+    };
+
+    uint32_t present;
+    uint64_t currentSummationDelivered; //!< 0x0000 uint48
+    uint64_t currentSummationReceived;  //!< 0x0001 uint48
+    uint8_t status;                     //!< 0x0200 bitmap8
+    uint8_t unitOfMeasure;              //!< 0x0300 enum8
+    uint32_t multiplier;                //!< 0x0301 uint24
+    uint32_t divisor;                   //!< 0x0302 uint24
+    uint8_t meteringDeviceType;         //!< 0x0306 bitmap8
+    int32_t instantaneousDemand;        //!< 0x0400 int24, sign extended
+};
+
+/*! \ingroup zcl_clusters
+    Decodes a single attribute record into the matching field of \p out.
+
+    \returns true if the attribute is known and has the expected data type,
+             false if it needs to be handled by the generic decoder
+ */
+DECONZ_DLLSPEC bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclOnOffAttributes &out);
+DECONZ_DLLSPEC bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclLevelControlAttributes &out);
+DECONZ_DLLSPEC bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclColorControlAttributes &out);
+DECONZ_DLLSPEC bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclTemperatureAttributes &out);
+DECONZ_DLLSPEC bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclHumidityAttributes &out);
+DECONZ_DLLSPEC bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclIasZoneAttributes &out);
+DECONZ_DLLSPEC bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclMeteringAttributes &out);
+
+/*! \ingroup zcl_clusters
+    Decodes \p count attribute records into \p out.
+
+    Records with non success status are skipped. Records which can't be decoded
+    by the specialized decoder are stored in \p fallback, if not nullptr it
+    must have space for \p count pointers.
+
+    The records must be of cluster T::clusterId from a frame which isn't manufacturer
+    specific, since vendor attributes may reuse standard attribute ids. Prefer the
+    overloads which take the frame.
+
+    \returns number of records which need the generic decoder
+ */
+template <typename T>
+unsigned ZCL_DecodeAttributes(const ZclAttributeRecord *records, unsigned count, T &out, const ZclAttributeRecord **fallback = nullptr)
+{
+    unsigned n = 0;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (records[i].status != 0x00 || ZCL_DecodeAttribute(records[i], out))
+        {
+            continue;
+        }
+
+        if (fallback)
+        {
+            fallback[n] = &records[i];
+        }
+        n++;
+    }
+
+    return n;
+}
+
+/*! \ingroup zcl_clusters
+    Stores all \p count records with success status in \p fallback.
+    \returns number of stored records
+ */
+inline unsigned ZCL_FallbackAttributes(const ZclAttributeRecord *records, unsigned count, const ZclAttributeRecord **fallback)
+{
+    unsigned n = 0;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (records[i].status == 0x00)
+        {
+            if (fallback)
+            {
+                fallback[n] = &records[i];
+            }
+            n++;
+        }
+    }
+
+    return n;
+}
+
+/*! \ingroup zcl_clusters
+    Decodes \p count attribute records of \p zclFrame into \p out.
+
+    Like ZCL_DecodeAttributes() above, but all records of manufacturer specific
+    frames are stored in \p fallback. The cluster id must still be checked by the caller.
+ */
+template <typename T>
+unsigned ZCL_DecodeAttributes(const ZclFrame &zclFrame, const ZclAttributeRecord *records, unsigned count, T &out, const ZclAttributeRecord **fallback = nullptr)
+{
+    if (zclFrame.frameControl() & ZclFCManufacturerSpecific)
+    {
+        return ZCL_FallbackAttributes(records, count, fallback);
+    }
+
+    return ZCL_DecodeAttributes(records, count, out, fallback);
+}
+
+/*! \ingroup zcl_clusters
+    Decodes \p count attribute records of \p zclFrame into \p out, see ZCL_DecodeAttributes(const ZclFrame&, ...).
+ */
+template <typename T>
+unsigned ZCL_DecodeAttributes(const ZclFrameView &zclFrame, const ZclAttributeRecord *records, unsigned count, T &out, const ZclAttributeRecord **fallback = nullptr)
+{
+    if (zclFrame.frameControl() & ZclFCManufacturerSpecific)
+    {
+        return ZCL_FallbackAttributes(records, count, fallback);
+    }
+
+    return ZCL_DecodeAttributes(records, count, out, fallback);
+}
+
+} // namespace deCONZ
+
+#endif // DECONZ_ZCL_CLUSTERS_H
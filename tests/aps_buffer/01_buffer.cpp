@@ -0,0 +1,223 @@
+#include <catch2/catch_test_macros.hpp>
+#include <QDataStream>
+#include "deconz/aps.h"
+
+static QByteArray streamBytes(const deCONZ::ApsDataRequest &req)
+{
+    QByteArray arr;
+    QDataStream stream(&arr, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    REQUIRE(req.writeToStream(stream) == 1);
+    return arr;
+}
+
+static QByteArray bufferBytes(const deCONZ::ApsDataRequest &req)
+{
+    const int len = req.writeToBuffer(nullptr, 0);
+    REQUIRE(len > 0);
+
+    QByteArray arr(len, '\0');
+    REQUIRE(req.writeToBuffer(reinterpret_cast<uint8_t*>(arr.data()), unsigned(arr.size())) == len);
+    REQUIRE(req.writeToBuffer(reinterpret_cast<uint8_t*>(arr.data()), unsigned(arr.size() - 1)) == 0);
+    return arr;
+}
+
+static deCONZ::ApsDataRequest makeRequest(int asduSize)
+{
+    deCONZ::ApsDataRequest req;
+    req.setDstAddressMode(deCONZ::ApsExtAddress);
+    req.dstAddress().setExt(0x00212EFFFF001122ULL);
+    req.setDstEndpoint(0x01);
+    req.setSrcEndpoint(0x02);
+    req.setProfileId(0x0104);
+    req.setClusterId(0x0006);
+    req.setRadius(10);
+    req.setTxOptions(deCONZ::ApsTxAcknowledgedTransmission);
+
+    QByteArray asdu(asduSize, '\0');
+    for (int i = 0; i < asduSize; i++)
+    {
+        asdu[i] = char(i);
+    }
+    req.setAsdu(asdu);
+    return req;
+}
+
+TEST_CASE( "Request buffer equals stream format", "[aps_buffer]" )
+{
+    deCONZ::ApsDataRequest req = makeRequest(3);
+    const std::array<quint16, 9> relays = { 0x1111, 0x2222 };
+
+    SECTION( "version 1" )
+    {
+        req.setNodeId(0x1234); // not written before version 2
+        req.setSourceRoute(relays, 2, 1);
+        REQUIRE(bufferBytes(req) == streamBytes(req));
+    }
+
+    SECTION( "version 2 without flags" )
+    {
+        req.setVersion(2);
+        REQUIRE(bufferBytes(req) == streamBytes(req));
+    }
+
+    SECTION( "version 2 with node id" )
+    {
+        req.setVersion(2);
+        req.setNodeId(0x1234);
+        REQUIRE(bufferBytes(req) == streamBytes(req));
+    }
+
+    SECTION( "version 2 with source route" )
+    {
+        req.setVersion(2);
+        req.setSourceRoute(relays, 2, 1);
+        REQUIRE(bufferBytes(req) == streamBytes(req));
+    }
+
+    SECTION( "version 2 with node id and source route" )
+    {
+        req.setVersion(2);
+        req.setNodeId(0x1234);
+        req.setSourceRoute(relays, 2, 1);
+        REQUIRE(bufferBytes(req) == streamBytes(req));
+    }
+
+    SECTION( "ASDU larger than the indication buffer" )
+    {
+        req = makeRequest(200);
+        REQUIRE(bufferBytes(req) == streamBytes(req));
+    }
+}
+
+TEST_CASE( "Request buffer round trip", "[aps_buffer]" )
+{
+    deCONZ::ApsDataRequest req = makeRequest(5);
+    req.setVersion(2);
+    req.setNodeId(0x1234);
+    const std::array<quint16, 9> relays = { 0x1111, 0x2222, 0x3333 };
+    req.setSourceRoute(relays, 3, 1);
+
+    const QByteArray bytes = bufferBytes(req);
+    const uint8_t *data = reinterpret_cast<const uint8_t*>(bytes.constData());
+
+    deCONZ::ApsDataRequest out;
+    out.setVersion(2);
+    REQUIRE(out.readFromBuffer(data, unsigned(bytes.size())) == bytes.size());
+    REQUIRE(out.nodeId() == 0x1234);
+    REQUIRE(out.dstAddress().ext() == req.dstAddress().ext());
+    REQUIRE(out.asdu() == req.asdu());
+    REQUIRE(bufferBytes(out) == bytes);
+
+    for (int len = 0; len < bytes.size(); len++)
+    {
+        deCONZ::ApsDataRequest truncated;
+        truncated.setVersion(2);
+        REQUIRE(truncated.readFromBuffer(data, unsigned(len)) == 0);
+    }
+}
+
+TEST_CASE( "Indication buffer equals stream format", "[aps_buffer]" )
+{
+    for (int version = 1; version <= 2; version++)
+    {
+        deCONZ::ApsDataIndication ind;
+        ind.setVersion(version);
+        ind.setDstAddressMode(deCONZ::ApsNwkAddress);
+        ind.dstAddress().setNwk(0x0000);
+        ind.setDstEndpoint(0x01);
+        ind.setSrcAddressMode(deCONZ::ApsExtAddress);
+        ind.srcAddress().setExt(0x00212EFFFF001122ULL);
+        ind.setSrcEndpoint(0x0B);
+        ind.setProfileId(0x0104);
+        ind.setClusterId(0x0402);
+        ind.setAsdu(QByteArray::fromHex("18010a0000290a0b"));
+        ind.setLinkQuality(200);
+        ind.setRxTime(12345);
+        ind.setRssi(-60);
+
+        QByteArray bytes;
+        {
+            QDataStream stream(&bytes, QIODevice::WriteOnly);
+            stream.setByteOrder(QDataStream::LittleEndian);
+            ind.writeToStream(stream);
+        }
+
+        const uint8_t *data = reinterpret_cast<const uint8_t*>(bytes.constData());
+
+        deCONZ::ApsDataIndication fromStream;
+        fromStream.setVersion(version);
+        {
+            QDataStream stream(bytes);
+            stream.setByteOrder(QDataStream::LittleEndian);
+            fromStream.readFromStream(stream);
+        }
+
+        deCONZ::ApsDataIndication fromBuffer;
+        fromBuffer.setVersion(version);
+        REQUIRE(fromBuffer.readFromBuffer(data, unsigned(bytes.size())) == bytes.size());
+
+        REQUIRE(fromBuffer.dstAddress().nwk() == fromStream.dstAddress().nwk());
+        REQUIRE(fromBuffer.srcAddress().ext() == fromStream.srcAddress().ext());
+        REQUIRE(fromBuffer.clusterId() == fromStream.clusterId());
+        REQUIRE(fromBuffer.asdu() == fromStream.asdu());
+        REQUIRE(fromBuffer.asdu() == ind.asdu());
+        REQUIRE(fromBuffer.linkQuality() == fromStream.linkQuality());
+        REQUIRE(fromBuffer.rxTime() == fromStream.rxTime());
+        REQUIRE(fromBuffer.rssi() == fromStream.rssi());
+
+        for (int len = 0; len < bytes.size(); len++)
+        {
+            deCONZ::ApsDataIndication truncated;
+            truncated.setVersion(version);
+            REQUIRE(truncated.readFromBuffer(data, unsigned(len)) == 0);
+        }
+    }
+}
+
+TEST_CASE( "Indication ASDU larger than buffer is rejected", "[aps_buffer]" )
+{
+    deCONZ::ApsDataIndication ind;
+    ind.setDstAddressMode(deCONZ::ApsNwkAddress);
+    ind.dstAddress().setNwk(0x0000);
+    ind.setSrcAddressMode(deCONZ::ApsNwkAddress);
+    ind.srcAddress().setNwk(0x1234);
+    ind.setAsdu(QByteArray(129, 'x')); // ApsAsduBuffer::MaxSize + 1
+
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    ind.writeToStream(stream);
+
+    deCONZ::ApsDataIndication out;
+    REQUIRE(out.readFromBuffer(reinterpret_cast<const uint8_t*>(bytes.constData()), unsigned(bytes.size())) == 0);
+}
+
+TEST_CASE( "Confirm buffer equals stream format", "[aps_buffer]" )
+{
+    // id, dst nwk address mode, nwk 0x1234, dst endpoint, src endpoint, status
+    const QByteArray bytes = QByteArray::fromHex("2a02341201020000");
+    const uint8_t *data = reinterpret_cast<const uint8_t*>(bytes.constData());
+
+    deCONZ::ApsDataConfirm fromStream;
+    {
+        QDataStream stream(bytes);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        fromStream.readFromStream(stream);
+    }
+
+    deCONZ::ApsDataConfirm fromBuffer;
+    REQUIRE(fromBuffer.readFromBuffer(data, unsigned(bytes.size())) == 7);
+    REQUIRE(fromBuffer.id() == 0x2a);
+    REQUIRE(fromBuffer.id() == fromStream.id());
+    REQUIRE(fromBuffer.dstAddress().nwk() == fromStream.dstAddress().nwk());
+    REQUIRE(fromBuffer.dstEndpoint() == fromStream.dstEndpoint());
+    REQUIRE(fromBuffer.srcEndpoint() == fromStream.srcEndpoint());
+    REQUIRE(fromBuffer.status() == fromStream.status());
+
+    for (int len = 0; len < 7; len++)
+    {
+        deCONZ::ApsDataConfirm truncated;
+        REQUIRE(truncated.readFromBuffer(data, unsigned(len)) == 0);
+    }
+}
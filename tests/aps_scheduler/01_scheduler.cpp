@@ -0,0 +1,239 @@
+#include <catch2/catch_test_macros.hpp>
+#include "deconz/aps_scheduler.h"
+
+// without ApsController all requests get id 0, set it via the buffer format
+static deCONZ::ApsDataRequest makeRequest(uint8_t id, uint16_t nwk, uint16_t clusterId)
+{
+    deCONZ::ApsDataRequest req;
+    req.setDstAddressMode(deCONZ::ApsNwkAddress);
+    req.dstAddress().setNwk(nwk);
+    req.setClusterId(clusterId);
+
+    uint8_t buf[64];
+    const int len = req.writeToBuffer(buf, sizeof(buf));
+    REQUIRE(len > 0);
+    buf[0] = id;
+    REQUIRE(req.readFromBuffer(buf, unsigned(len)) == len);
+    REQUIRE(req.id() == id);
+    return req;
+}
+
+static const deCONZ::SteadyTimeRef t0{1000};
+
+TEST_CASE( "Hand out requests by send time", "[aps_scheduler]" )
+{
+    deCONZ::ApsRequestScheduler sched;
+    sched.setMaxInFlightPerNode(4);
+
+    deCONZ::ApsDataRequest a = makeRequest(1, 0x1111, 1);
+    a.setSendDelay(200);
+    deCONZ::ApsDataRequest b = makeRequest(2, 0x1111, 2);
+    b.setSendDelay(100);
+    deCONZ::ApsDataRequest c = makeRequest(3, 0x1111, 3);
+
+    REQUIRE(sched.enqueue(a, t0) == deCONZ::Success);
+    REQUIRE(sched.enqueue(b, t0) == deCONZ::Success);
+    REQUIRE(sched.enqueue(c, t0) == deCONZ::Success);
+    REQUIRE(sched.size() == 3);
+    REQUIRE(sched.nextDeadline() == t0 + deCONZ::TimeMs{100});
+
+    deCONZ::ApsDataRequest req;
+    REQUIRE(sched.dequeue(t0, req));
+    REQUIRE(req.clusterId() == 3);
+    REQUIRE_FALSE(sched.dequeue(t0, req));
+
+    REQUIRE(sched.dequeue(t0 + deCONZ::TimeMs{200}, req));
+    REQUIRE(req.clusterId() == 2);
+    REQUIRE(sched.dequeue(t0 + deCONZ::TimeMs{200}, req));
+    REQUIRE(req.clusterId() == 1);
+    REQUIRE(sched.size() == 0);
+    REQUIRE(sched.inFlight() == 3);
+}
+
+TEST_CASE( "Serve nodes round-robin", "[aps_scheduler]" )
+{
+    deCONZ::ApsRequestScheduler sched;
+    sched.setMaxInFlightPerNode(8);
+
+    for (uint8_t i = 1; i <= 4; i++)
+    {
+        REQUIRE(sched.enqueue(makeRequest(i, 0x1111, 0x100 + i), t0) == deCONZ::Success);
+    }
+
+    for (uint8_t i = 5; i <= 6; i++)
+    {
+        REQUIRE(sched.enqueue(makeRequest(i, 0x2222, 0x200 + i), t0) == deCONZ::Success);
+    }
+
+    const uint16_t expected[] = { 0x101, 0x205, 0x102, 0x206, 0x103, 0x104 };
+    deCONZ::ApsDataRequest req;
+
+    for (uint16_t clusterId : expected)
+    {
+        REQUIRE(sched.dequeue(t0, req));
+        REQUIRE(req.clusterId() == clusterId);
+    }
+
+    REQUIRE_FALSE(sched.dequeue(t0, req));
+}
+
+TEST_CASE( "Expire queued requests", "[aps_scheduler]" )
+{
+    deCONZ::ApsRequestScheduler sched;
+
+    deCONZ::ApsDataRequest a = makeRequest(1, 0x1111, 1);
+    a.setSendDelay(500);
+    a.setTimeout(t0 + deCONZ::TimeMs{300});
+    REQUIRE(sched.enqueue(a, t0) == deCONZ::Success);
+    REQUIRE(sched.enqueue(makeRequest(2, 0x1111, 2), t0) == deCONZ::Success);
+
+    std::vector<deCONZ::ApsDataRequest> expired;
+    REQUIRE(sched.expire(t0 + deCONZ::TimeMs{299}, &expired) == 0);
+    REQUIRE(sched.expire(t0 + deCONZ::TimeMs{300}, &expired) == 1);
+    REQUIRE(expired.size() == 1);
+    REQUIRE(expired[0].id() == 1);
+    REQUIRE(sched.size() == 1);
+
+    deCONZ::ApsDataRequest req;
+    REQUIRE(sched.dequeue(t0 + deCONZ::TimeMs{600}, req));
+    REQUIRE(req.id() == 2);
+    REQUIRE_FALSE(sched.dequeue(t0 + deCONZ::TimeMs{600}, req));
+}
+
+TEST_CASE( "Limit in flight requests per node", "[aps_scheduler]" )
+{
+    deCONZ::ApsRequestScheduler sched;
+    sched.setMaxInFlightPerNode(1);
+    sched.setInFlightTimeout(1000);
+
+    for (uint8_t i = 1; i <= 3; i++)
+    {
+        REQUIRE(sched.enqueue(makeRequest(i, 0x1111, i), t0) == deCONZ::Success);
+    }
+
+    deCONZ::ApsDataRequest req;
+    REQUIRE(sched.dequeue(t0, req));
+    REQUIRE(req.id() == 1);
+    REQUIRE_FALSE(sched.dequeue(t0, req));
+    REQUIRE(sched.inFlight() == 1);
+
+    sched.confirm(1);
+    REQUIRE(sched.inFlight() == 0);
+    REQUIRE(sched.dequeue(t0, req));
+    REQUIRE(req.id() == 2);
+
+    // confirm of id 2 is lost, the node is released after the in-flight timeout
+    REQUIRE_FALSE(sched.dequeue(t0 + deCONZ::TimeMs{999}, req));
+    REQUIRE(sched.nextDeadline() == t0 + deCONZ::TimeMs{1000});
+    REQUIRE(sched.expire(t0 + deCONZ::TimeMs{1000}, nullptr) == 0);
+    REQUIRE(sched.inFlight() == 0);
+    REQUIRE(sched.dequeue(t0 + deCONZ::TimeMs{1000}, req));
+    REQUIRE(req.id() == 3);
+}
+
+TEST_CASE( "Release in flight request on id reuse", "[aps_scheduler]" )
+{
+    deCONZ::ApsRequestScheduler sched;
+    sched.setMaxInFlightPerNode(1);
+
+    REQUIRE(sched.enqueue(makeRequest(7, 0x1111, 1), t0) == deCONZ::Success);
+    REQUIRE(sched.enqueue(makeRequest(8, 0x1111, 2), t0) == deCONZ::Success);
+    REQUIRE(sched.enqueue(makeRequest(7, 0x2222, 3), t0) == deCONZ::Success);
+
+    deCONZ::ApsDataRequest req;
+    REQUIRE(sched.dequeue(t0, req));
+    REQUIRE(req.clusterId() == 1);
+
+    // id 7 handed out again to the other node, the former request is no longer in flight
+    REQUIRE(sched.dequeue(t0, req));
+    REQUIRE(req.clusterId() == 3);
+    REQUIRE(sched.inFlight() == 1);
+
+    REQUIRE(sched.dequeue(t0, req));
+    REQUIRE(req.clusterId() == 2);
+
+    // credits node 0x2222 only
+    sched.confirm(7);
+    REQUIRE(sched.inFlight() == 1);
+    sched.confirm(8);
+    REQUIRE(sched.inFlight() == 0);
+}
+
+static void batchConfirmed(void *user, const std::vector<deCONZ::ApsDataConfirm> &confirms)
+{
+    static_cast<std::vector<std::vector<deCONZ::ApsDataConfirm>>*>(user)->push_back(confirms);
+}
+
+TEST_CASE( "Report batch confirms once", "[aps_scheduler]" )
+{
+    deCONZ::ApsRequestScheduler sched;
+    sched.setMaxInFlightPerNode(4);
+    sched.setMaxQueueSize(3);
+    sched.setInFlightTimeout(1000);
+
+    std::vector<std::vector<deCONZ::ApsDataConfirm>> reported;
+    sched.setBatchConfirmCallback(batchConfirmed, &reported);
+
+    const deCONZ::ApsDataRequest reqs[4] = {
+        makeRequest(1, 0x1111, 1),
+        makeRequest(2, 0x2222, 2),
+        makeRequest(3, 0x3333, 3),
+        makeRequest(4, 0x4444, 4)
+    };
+
+    int results[4];
+    REQUIRE(sched.enqueueBatch(reqs, 4, results, t0) == 3);
+    REQUIRE(results[0] == deCONZ::Success);
+    REQUIRE(results[2] == deCONZ::Success);
+    REQUIRE(results[3] == deCONZ::ErrorQueueIsFull);
+    REQUIRE(sched.size() == 3);
+
+    deCONZ::ApsDataRequest req;
+    REQUIRE(sched.dequeue(t0, req));
+    REQUIRE(sched.dequeue(t0, req));
+    REQUIRE(sched.dequeue(t0, req));
+    REQUIRE_FALSE(sched.dequeue(t0, req));
+
+    sched.confirm(deCONZ::ApsDataConfirm(reqs[2], deCONZ::ApsSuccessStatus), t0 + deCONZ::TimeMs{50});
+    sched.confirm(deCONZ::ApsDataConfirm(reqs[0], deCONZ::ApsSuccessStatus), t0 + deCONZ::TimeMs{60});
+    REQUIRE(reported.empty());
+
+    // confirm of request 2 got lost
+    sched.expire(t0 + deCONZ::TimeMs{1000}, nullptr);
+    REQUIRE(reported.size() == 1);
+    REQUIRE(reported[0].size() == 3);
+    REQUIRE(reported[0][0].id() == 1);
+    REQUIRE(reported[0][0].status() == deCONZ::ApsSuccessStatus);
+    REQUIRE(reported[0][1].id() == 2);
+    REQUIRE(reported[0][1].status() == deCONZ::MacTransactionExpiredStatus);
+    REQUIRE(reported[0][2].id() == 3);
+    REQUIRE(reported[0][2].status() == deCONZ::ApsSuccessStatus);
+
+    // late confirm isn't reported again
+    sched.confirm(deCONZ::ApsDataConfirm(reqs[1], deCONZ::ApsSuccessStatus), t0 + deCONZ::TimeMs{1100});
+    REQUIRE(reported.size() == 1);
+}
+
+TEST_CASE( "Report expired batch requests", "[aps_scheduler]" )
+{
+    deCONZ::ApsRequestScheduler sched;
+
+    std::vector<std::vector<deCONZ::ApsDataConfirm>> reported;
+    sched.setBatchConfirmCallback(batchConfirmed, &reported);
+
+    deCONZ::ApsDataRequest reqs[2] = { makeRequest(1, 0x1111, 1), makeRequest(2, 0x1111, 2) };
+    reqs[1].setSendDelay(500);
+    reqs[1].setTimeout(t0 + deCONZ::TimeMs{300});
+
+    REQUIRE(sched.enqueueBatch(reqs, 2, nullptr, t0) == 2);
+
+    deCONZ::ApsDataRequest req;
+    REQUIRE(sched.dequeue(t0, req));
+    sched.confirm(deCONZ::ApsDataConfirm(req, deCONZ::ApsSuccessStatus), t0);
+    REQUIRE(reported.empty());
+
+    REQUIRE(sched.expire(t0 + deCONZ::TimeMs{300}, nullptr) == 1);
+    REQUIRE(reported.size() == 1);
+    REQUIRE(reported[0][0].status() == deCONZ::ApsSuccessStatus);
+    REQUIRE(reported[0][1].status() == deCONZ::MacTransactionExpiredStatus);
+}
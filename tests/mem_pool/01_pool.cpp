@@ -0,0 +1,68 @@
+#include <catch2/catch_test_macros.hpp>
+#include "deconz/mem_pool.h"
+
+struct Item
+{
+    static constexpr int PoolSize = 4;
+    int value = 0;
+};
+
+TEST_CASE( "Reuse released items", "[mem_pool]" )
+{
+    MEM_Pool<Item> pool;
+
+    Item *a = pool.alloc();
+    REQUIRE(a != nullptr);
+    REQUIRE(pool.stats().misses == 1);
+    REQUIRE(pool.capacity() == Item::PoolSize);
+    REQUIRE(pool.available() == Item::PoolSize - 1);
+
+    a->value = 42;
+    pool.release(a);
+    REQUIRE(pool.available() == Item::PoolSize);
+
+    Item *b = pool.alloc();
+    REQUIRE(b == a); // last released item first
+    REQUIRE(b->value == 42);
+    REQUIRE(pool.stats().hits == 1);
+
+    pool.release(b);
+}
+
+TEST_CASE( "Grow in slabs up to limit", "[mem_pool]" )
+{
+    MEM_Pool<Item> pool;
+    std::vector<Item*> items;
+    const size_t maxItems = size_t(MEM_Pool<Item>::MaxSlabs) * Item::PoolSize;
+
+    for (size_t i = 0; i < maxItems + 2; i++)
+    {
+        items.push_back(pool.alloc());
+    }
+
+    REQUIRE(pool.capacity() == maxItems);
+    REQUIRE(pool.available() == 0);
+    REQUIRE(pool.stats().misses == MEM_Pool<Item>::MaxSlabs + 2);
+
+    for (Item *p : items)
+    {
+        pool.release(p);
+    }
+
+    REQUIRE(pool.available() == maxItems);
+    REQUIRE(pool.stats().drops == 2);
+}
+
+TEST_CASE( "Alloc by tuple", "[mem_pool]" )
+{
+    std::tuple<MEM_Pool<Item>> mem;
+
+    Item *p = MEM_AllocItem<Item>(&mem);
+    REQUIRE(p != nullptr);
+    MEM_DeallocItem<Item>(p, &mem);
+    REQUIRE(MEM_GetAllocContainer<Item>(mem).available() == Item::PoolSize);
+
+    Item *q = MEM_ThreadPool<Item>().alloc();
+    REQUIRE(q != nullptr);
+    MEM_ThreadPool<Item>().release(q);
+}
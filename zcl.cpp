@@ -17,16 +17,21 @@
 #include <QTextStream>
 #include <QXmlStreamReader>
 #include <array>
+#include <atomic>
+#include <thread>
 #include <tuple>
 #include "deconz/u_platform.h"
 #ifdef PL_UNIX
 #include <unistd.h>
 #endif
 #include "deconz/aps.h"
+#include "deconz/buffer_helper.h"
 #include "deconz/zcl.h"
 #include "deconz/dbg_trace.h"
 #include "deconz/util.h"
+#include "deconz/u_sha256.h"
 #include "deconz/u_sstream_ex.h"
+#include "deconz/u_threads.h"
 #include "deconz/mem_pool.h"
 #include "zcl_private.h"
 
@@ -47,7 +52,7 @@ namespace {
     };
 }
 
-static deCONZ::ZclDataBase *_zclDB = nullptr;
+static std::atomic<deCONZ::ZclDataBase*> _zclDB{nullptr}; // read by zclSnapshot() on any thread
 
 namespace deCONZ {
 
@@ -149,22 +154,48 @@ public:
     ~ZclMemoryPrivate();
 
     std::tuple<
-        std::array<ZclAttributePrivate*, ZclAttributePrivate::PoolSize>,
-        std::array<ZclFramePrivate*, ZclFramePrivate::PoolSize>
+        MEM_Pool<ZclAttributePrivate>,
+        MEM_Pool<ZclFramePrivate>
     > mem{};
+    std::thread::id owner; //!< The pools are only used by the thread which created ZclMemory.
 };
 
-ZclMemoryPrivate::~ZclMemoryPrivate()
+/*! Allocates a private object, from the pool when called on the owning thread. */
+template <typename T>
+static T *zclAllocPrivate()
 {
-    for (auto &i : MEM_GetAllocContainer<ZclAttributePrivate>(zclMemPriv->mem))
+    if (zclMemPriv && zclMemPriv->owner == std::this_thread::get_id())
     {
-        if (i) { delete i; }
+        return MEM_AllocItem<T>(&zclMemPriv->mem);
     }
 
-    for (auto &i : MEM_GetAllocContainer<ZclFramePrivate>(zclMemPriv->mem))
+    return MEM_ThreadPool<T>().alloc(); // worker threads, e.g. decoding with a ZclDataBaseSnapshot
+}
+
+template <typename T>
+static void zclDeallocPrivate(T *priv)
+{
+    if (zclMemPriv && zclMemPriv->owner == std::this_thread::get_id())
     {
-        if (i) { delete i; }
+        MEM_DeallocItem<T>(priv, &zclMemPriv->mem);
+        return;
     }
+
+    MEM_ThreadPool<T>().release(priv);
+}
+
+template <typename T>
+static void zclPrintPoolStats(const char *name, const MEM_Pool<T> &pool)
+{
+    const MEM_PoolStats &st = pool.stats();
+    DBG_Printf(DBG_INFO_L2, "ZCL pool %s: %lu hits, %lu misses, %lu drops, capacity %d\n",
+               name, st.hits, st.misses, st.drops, int(pool.capacity()));
+}
+
+ZclMemoryPrivate::~ZclMemoryPrivate()
+{
+    zclPrintPoolStats("ZclAttributePrivate", MEM_GetAllocContainer<ZclAttributePrivate>(mem));
+    zclPrintPoolStats("ZclFramePrivate", MEM_GetAllocContainer<ZclFramePrivate>(mem));
 }
 
 ZclMemory::ZclMemory() :
@@ -173,6 +204,7 @@ ZclMemory::ZclMemory() :
     Q_ASSERT_X(zclMem == nullptr, "ZclMemory::ZclMemory()", "Already initialized");
     zclMem = this; // singleton
     zclMemPriv = d; // quick ref
+    d->owner = std::this_thread::get_id();
 }
 
 ZclMemory::~ZclMemory()
@@ -183,29 +215,130 @@ ZclMemory::~ZclMemory()
     zclMemPriv = nullptr;
 }
 
+/*! Returns the shared schema with default values, it is never released. */
+static ZclAttributeSchema *defaultAttributeSchema()
+{
+    static ZclAttributeSchema *schema = []() {
+        auto *s = new ZclAttributeSchema;
+        s->ref = 1; // keep alive
+        return s;
+    }();
+
+    return schema;
+}
+
+ZclAttributeSchemaRef::ZclAttributeSchemaRef() :
+    m_schema(defaultAttributeSchema())
+{
+    m_schema->ref++;
+}
+
+ZclAttributeSchemaRef::ZclAttributeSchemaRef(const ZclAttributeSchemaRef &other) :
+    m_schema(other.m_schema)
+{
+    m_schema->ref++;
+}
+
+ZclAttributeSchemaRef &ZclAttributeSchemaRef::operator=(const ZclAttributeSchemaRef &other)
+{
+    if (m_schema != other.m_schema)
+    {
+        other.m_schema->ref++;
+        if (--m_schema->ref == 0)
+        {
+            delete m_schema;
+        }
+        m_schema = other.m_schema;
+    }
+    return *this;
+}
+
+ZclAttributeSchemaRef::~ZclAttributeSchemaRef()
+{
+    if (--m_schema->ref == 0)
+    {
+        delete m_schema;
+    }
+    m_schema = nullptr;
+}
+
+/*! Makes the schema unique to this handle before it gets modified.
+    The default schema is always copied since its reference never drops.
+ */
+ZclAttributeSchema *ZclAttributeSchemaRef::detach()
+{
+    if (m_schema->ref > 1)
+    {
+        ZclAttributeSchema *schema = new ZclAttributeSchema;
+        schema->ref = 1;
+        schema->m_name = m_schema->m_name;
+        schema->m_description = m_schema->m_description;
+        schema->m_valuePos = m_schema->m_valuePos;
+        schema->m_valueNames = m_schema->m_valueNames;
+        schema->m_access = m_schema->m_access;
+        schema->m_enumerationId = m_schema->m_enumerationId;
+        schema->m_numericBase = m_schema->m_numericBase;
+        schema->m_required = m_schema->m_required;
+        schema->m_listSizeAttr = m_schema->m_listSizeAttr;
+        schema->m_manufacturerCode = m_schema->m_manufacturerCode;
+        schema->m_attrSetId = m_schema->m_attrSetId;
+        schema->m_attrSetManufacturerCode = m_schema->m_attrSetManufacturerCode;
+        schema->m_formatHint = m_schema->m_formatHint;
+        schema->m_rangeMin = m_schema->m_rangeMin;
+        schema->m_rangeMax = m_schema->m_rangeMax;
+
+        if (--m_schema->ref == 0)
+        {
+            delete m_schema;
+        }
+        m_schema = schema;
+    }
+
+    return m_schema;
+}
+
 ZclAttributePrivate::ZclAttributePrivate() :
     m_id(0xFFFF),
     m_dataType(0xFF),
     m_subType(0xFF),
-    m_access(ZclRead),
-    m_enumerationId(0xFF),
-    m_numericBase(10),
-    m_required(false),
     m_avail(true),
     m_lastRead((time_t)-1),
-    m_listSizeAttr(0xFFFF),
     m_listSize(0),
     m_minReportInterval(0),
     m_maxReportInterval(0xFFFF),
-    m_reportTimeout(0),
-    m_formatHint(ZclAttribute::DefaultFormat),
-    m_manufacturerCode(0)
+    m_reportTimeout(0)
 {
     m_valueState.idx = 0;
     m_valueState.bitmap = 0;
     m_numericValue.u64 = 0;
 }
 
+/*! Returns the value as QVariant, for numeric values it is built here on first access. */
+const QVariant &ZclAttributePrivate::value() const
+{
+    switch (m_valueKind)
+    {
+    case ValueVariant: return m_value;
+    case ValueBool:        m_value = m_numericValue.u8 == 1; break;
+    case ValueUInt8:       m_value = uint(m_numericValue.u8); break;
+    case ValueUInt16:      m_value = uint(m_numericValue.u16); break;
+    case ValueUInt16AsInt: m_value = int(m_numericValue.u16); break;
+    case ValueUInt32:      m_value = uint(m_numericValue.u32); break;
+    case ValueUInt64:      m_value = quint64(m_numericValue.u64); break;
+    case ValueInt8:        m_value = int(m_numericValue.s8); break;
+    case ValueInt16:       m_value = int(m_numericValue.s16); break;
+    case ValueInt32:       m_value = int(m_numericValue.s32); break;
+    case ValueInt64:       m_value = qint64(m_numericValue.s64); break;
+    case ValueReal:        m_value = qreal(m_numericValue.real); break;
+    case ValueBitmap:      m_value = quint64(m_valueState.bitmap); break;
+    default:
+        break;
+    }
+
+    m_valueKind = ValueVariant;
+    return m_value;
+}
+
 ZclAttribute::ZclAttribute() :
     // delegate constructor
     ZclAttribute(0xFFFF, ZclNoData, QLatin1String(""), ZclRead, false)
@@ -214,39 +347,27 @@ ZclAttribute::ZclAttribute() :
 
 ZclAttribute::ZclAttribute(uint16_t id, uint8_t type, const QString &name, ZclAccess access, bool required)
 {
-    d_ptr = MEM_AllocItem<ZclAttributePrivate>(&zclMemPriv->mem);
+    d_ptr = zclAllocPrivate<ZclAttributePrivate>();
 
     Q_D(ZclAttribute);
 
     d->m_id = id;
     d->m_dataType = type;
     d->m_subType = 0xFF;
-    d->m_name = name;
-    d->m_access = access;
-    d->m_enumerationId = 0xFF;
-    d->m_numericBase = 10;
-    d->m_required = required;
     d->m_avail = true;
     d->m_lastRead = (time_t)-1;
-    d->m_listSizeAttr = 0xFFFF;
     d->m_listSize = 0;
-    d->m_attrSetId = 0xFFFF;
-    d->m_attrSetManufacturerCode = 0;
-    d->m_manufacturerCode = 0;
     d->m_minReportInterval = 0;
     d->m_maxReportInterval = 0xFFFF;
     d->m_reportTimeout = 0;
     d->m_reportableChange.u64 = 0;
-    d->m_formatHint = DefaultFormat;
-    d->m_rangeMin = 0;
-    d->m_rangeMax = 0;
     d->m_valueState.idx = 0;
     d->m_valueState.bitmap = 0;
     d->m_numericValue.u64 = 0;
-    d->m_description.clear();
-    d->m_valueNames.clear();
-    d->m_valuePos.clear();
-    d->m_value = QVariant();
+    d->setVariant(QVariant());
+    d->m_schema = ZclAttributeSchemaRef(); // shared default schema
+
+    uint8_t numericBase = 10;
 
     switch (type)
     {
@@ -259,12 +380,21 @@ ZclAttribute::ZclAttribute(uint16_t id, uint8_t type, const QString &name, ZclAc
     case Zcl48BitBitMap:
     case Zcl56BitBitMap:
     case Zcl64BitBitMap:
-        d->m_numericBase = 16;
+        numericBase = 16;
         break;
 
     default:
         break;
     }
+
+    if (!name.isEmpty() || access != ZclRead || required || numericBase != 10)
+    {
+        ZclAttributeSchema *schema = d->m_schema.detach();
+        schema->m_name = name;
+        schema->m_access = access;
+        schema->m_required = required;
+        schema->m_numericBase = numericBase;
+    }
 }
 
 ZclAttribute::ZclAttribute(ZclAttributeId_t id, ZclDataTypeId_t type, const QString &name, ZclAccess access, bool required) :
@@ -278,7 +408,7 @@ ZclAttribute::ZclAttribute(ZclAttributeId_t id, ZclDataTypeId_t type, const QStr
 ZclAttribute::ZclAttribute(const ZclAttribute &other)
 {
     Q_ASSERT(this != &other);
-    d_ptr = MEM_AllocItem<ZclAttributePrivate>(&zclMemPriv->mem);
+    d_ptr = zclAllocPrivate<ZclAttributePrivate>();
     *d_ptr = *other.d_ptr;
 }
 
@@ -316,7 +446,7 @@ ZclAttribute &ZclAttribute::operator=(ZclAttribute &&other) noexcept
 
     if (d_ptr)
     {
-        MEM_DeallocItem<ZclAttributePrivate>(d_ptr, &zclMemPriv->mem);
+        zclDeallocPrivate(d_ptr);
     }
 
     d_ptr = other.d_ptr;
@@ -330,7 +460,7 @@ ZclAttribute::~ZclAttribute()
 {
     if (d_ptr)
     {
-        MEM_DeallocItem<ZclAttributePrivate>(d_ptr, &zclMemPriv->mem);
+        zclDeallocPrivate(d_ptr);
         d_ptr = nullptr;
     }
 }
@@ -350,13 +480,13 @@ ZclAttributeId_t ZclAttribute::id_t() const
 const QString &ZclAttribute::description() const
 {
     Q_D(const ZclAttribute);
-    return d->m_description;
+    return d->m_schema->m_description;
 }
 
 void ZclAttribute::setDescription(const QString &description)
 {
     Q_D(ZclAttribute);
-    d->m_description = description;
+    d->m_schema.detach()->m_description = description;
 }
 
 uint8_t ZclAttribute::dataType() const
@@ -387,7 +517,10 @@ void ZclAttribute::setDataType(uint8_t type)
     case Zcl48BitBitMap:
     case Zcl56BitBitMap:
     case Zcl64BitBitMap:
-        d->m_numericBase = 16;
+        if (d->m_schema->m_numericBase != 16)
+        {
+            d->m_schema.detach()->m_numericBase = 16;
+        }
         break;
 
     default:
@@ -398,7 +531,7 @@ void ZclAttribute::setDataType(uint8_t type)
 const QString &ZclAttribute::name() const
 {
     Q_D(const ZclAttribute);
-    return d->m_name;
+    return d->m_schema->m_name;
 }
 
 uint8_t ZclAttribute::subType() const
@@ -428,13 +561,13 @@ void ZclAttribute::setNumericValue(const NumericUnion &value)
 QString ZclAttribute::valueNameAt(int bitOrEnum) const
 {
     Q_D(const ZclAttribute);
-    for (size_t i = 0; i < d->m_valuePos.size(); i++)
+    for (size_t i = 0; i < d->m_schema->m_valuePos.size(); i++)
     {
-        if (d->m_valuePos[i] == bitOrEnum)
+        if (d->m_schema->m_valuePos[i] == bitOrEnum)
         {
-            if (d->m_valueNames.size() > static_cast<int>(i))
+            if (d->m_schema->m_valueNames.size() > static_cast<int>(i))
             {
-                return d->m_valueNames.at(static_cast<int>(i));
+                return d->m_schema->m_valueNames.at(static_cast<int>(i));
             }
         }
     }
@@ -445,13 +578,13 @@ QString ZclAttribute::valueNameAt(int bitOrEnum) const
 QStringList ZclAttribute::valuesNames() const
 {
     Q_D(const ZclAttribute);
-    return d->m_valueNames;
+    return d->m_schema->m_valueNames;
 }
 
 const std::vector<int> &ZclAttribute::valueNamePositions() const
 {
     Q_D(const ZclAttribute);
-    return d->m_valuePos;
+    return d->m_schema->m_valuePos;
 }
 
 /*!
@@ -477,14 +610,14 @@ bool ZclAttribute::writeToStream(QDataStream &stream) const
     case Zcl64BitBitMap:
     {
         quint64 tmp = bitmap();
-        const ZclDataType &type = zclDataBase()->dataType(dataType());
+        const int typeLength = ZCL_DataTypeTraits(dataType()).width;
 
-        if ((type.length() <= 0) || (type.length() > 64))
+        if ((typeLength <= 0) || (typeLength > 64))
         {
             return false;
         }
 
-        for (int i = 0; i < type.length(); i++)
+        for (int i = 0; i < typeLength; i++)
         {
             stream << (quint8)(tmp & 0xff);
             tmp >>= 8;
@@ -499,14 +632,14 @@ bool ZclAttribute::writeToStream(QDataStream &stream) const
     case Zcl56BitUint:
     {
         quint64 tmp = d->m_numericValue.u64;
-        const ZclDataType &type = zclDataBase()->dataType(dataType());
+        const int typeLength = ZCL_DataTypeTraits(dataType()).width;
 
-        if ((type.length() <= 0) || (type.length() > 64))
+        if ((typeLength <= 0) || (typeLength > 64))
         {
             return false;
         }
 
-        for (int i = 0; i < type.length(); i++)
+        for (int i = 0; i < typeLength; i++)
         {
             stream << static_cast<quint8>(tmp & 0xff);
             tmp >>= 8;
@@ -556,17 +689,17 @@ bool ZclAttribute::writeToStream(QDataStream &stream) const
     case Zcl56BitInt:
     {
         quint64 tmp = d->m_numericValue.s64 >= 0 ? d->m_numericValue.s64 : -d->m_numericValue.s64;
-        const ZclDataType &type = zclDataBase()->dataType(dataType());
+        const int typeLength = ZCL_DataTypeTraits(dataType()).width;
 
-        if ((type.length() <= 0) || (type.length() > 64))
+        if ((typeLength <= 0) || (typeLength > 64))
         {
             return false;
         }
 
-        for (int i = 0; i < type.length(); i++)
+        for (int i = 0; i < typeLength; i++)
         {
             quint8 b = static_cast<quint8>(tmp & 0xff);
-            if (i == (type.length() - 1) && d->m_numericValue.s64 < 0)
+            if (i == (typeLength - 1) && d->m_numericValue.s64 < 0)
             {
                 b |= 0x80; // signed
             }
@@ -585,9 +718,9 @@ bool ZclAttribute::writeToStream(QDataStream &stream) const
 
     case ZclOctedString:
     {
-        if (d->m_value.isValid() && d->m_value.userType() == QVariant::ByteArray)
+        if (d->value().isValid() && d->value().userType() == QVariant::ByteArray)
         {
-            const QByteArray data = d->m_value.toByteArray();
+            const QByteArray data = d->value().toByteArray();
 
             if (data.size() > UINT8_MAX)
             {
@@ -611,7 +744,7 @@ bool ZclAttribute::writeToStream(QDataStream &stream) const
 
     case ZclCharacterString:
     {
-        const QString text = d->m_value.toString();
+        const QString text = d->value().toString();
 
         if (text.size() > UINT8_MAX)
         {
@@ -632,7 +765,7 @@ bool ZclAttribute::writeToStream(QDataStream &stream) const
 
     case Zcl128BitSecurityKey:
     {
-        QByteArray key = d->m_value.toByteArray();
+        QByteArray key = d->value().toByteArray();
         if (key.size() == 16)
         {
             for (int i  = 0; i < 16; i++)
@@ -713,6 +846,87 @@ static int latin1ToUtf8Opinionated(const char *lat, unsigned len, unsigned char
     return 1;
 }
 
+#define ZCL_MAX_CHARACTER_STRING 120
+
+/*! Sets the value of a ZclCharacterString attribute from \p len raw bytes.
+
+    Valid UTF-8 is stored as QString, Latin1 encoded strings are converted to UTF-8
+    and everything else is stored as QByteArray.
+ */
+static void setCharacterStringValue(ZclAttributePrivate *d, const char *str, unsigned len)
+{
+    Q_ASSERT(len > 0 && len <= ZCL_MAX_CHARACTER_STRING);
+    char buf[ZCL_MAX_CHARACTER_STRING + 8] = {0}; // 7 bytes safe zone for utf8 parsing + '\0'
+
+    memcpy(buf, str, len);
+    buf[len] = '\0';
+
+    // strip trailing zero terminators
+    for (; len > 0;)
+    {
+        if (buf[len - 1] != '\0')
+            break;
+
+        len--;
+    }
+
+    if (len == 0)
+    {
+        d->setVariant(QString());
+        return;
+    }
+
+    unsigned codepoint = U_INVALID_UNICODE_CODEPOINT;
+    const char *p = &buf[0];
+    const char *pnonprint = nullptr;
+
+    while (p < &buf[len])
+    {
+        p = U_utf8_codepoint(p, &codepoint);
+
+        if (codepoint == U_INVALID_UNICODE_CODEPOINT)
+            break;
+
+        if (!pnonprint && codepoint == 0)
+            pnonprint = p - 1;
+    }
+
+    // in rare cases latin1 encoding has been seen, check this
+    if (codepoint == U_INVALID_UNICODE_CODEPOINT && isLikelyLatin1String(buf, len))
+    {
+        unsigned char utf8buf[256];
+
+        if (latin1ToUtf8Opinionated(buf, len, utf8buf, sizeof(utf8buf)))
+        {
+            d->setVariant(QString::fromUtf8((const char*)&utf8buf[0]));
+            return;
+        }
+    }
+
+    if (codepoint == U_INVALID_UNICODE_CODEPOINT)
+    {
+        // contains non utf8 characters
+        d->setVariant(QByteArray(&buf[0], len));
+        if (d->m_schema->m_formatHint != deCONZ::ZclAttribute::Prefix)
+        {
+            d->m_schema.detach()->m_formatHint = deCONZ::ZclAttribute::Prefix;
+        }
+        d->m_numericValue.u64 = unsigned(len);
+    }
+    else if (pnonprint && pnonprint < &buf[len - 1])
+    {
+        d->setVariant(QByteArray(&buf[0], len));
+        d->m_numericValue.u64 = unsigned(len);
+    }
+    else if (p == &buf[len]) // note we also reach here if last codepoint is '\0'
+    {
+        for (;len > 0 && buf[len - 1] == '\0';)
+            len--;
+
+        d->setVariant(QString::fromUtf8((const char*)&buf[0], len));
+    }
+}
+
 bool ZclAttribute::readFromStream(QDataStream &stream)
 {
     if (stream.atEnd())
@@ -723,13 +937,13 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
     Q_D(ZclAttribute);
     quint8 u8;
     d->m_numericValue.u64 = 0;
-    ZclDataType type = zclDataBase()->dataType(dataType());
+    const int typeLength = ZCL_DataTypeTraits(dataType()).width;
 
-    if (!zclDataBase()->knownDataType(dataType()))
+    if ((ZCL_DataTypeTraits(dataType()).flags & ZclTypeKnown) == 0)
     {
         DBG_Printf(DBG_ZCLDB, "ZCL Read Attributes Datatype 0x%02X %s"
                " not supported yet, abort\n",
-               type.id(), qPrintable(type.name()));
+               dataType(), qPrintable(zclSnapshot()->dataType(dataType()).name()));
         return false;
     }
 
@@ -757,7 +971,7 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
                 return false;
         }
 
-        d->m_value = data;
+        d->setVariant(data);
         d->m_numericValue.u64 = unsigned(len);
 
         return true;
@@ -774,86 +988,23 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
 
         if (len == 0)
         {
-            d->m_value = QString();
+            d->setVariant(QString());
             return true;
         }
 
-        int ret;
-        char buf[120 + 8] = {0}; // 7 bytes safe zone for utf8 parsing + '\0'
+        char buf[ZCL_MAX_CHARACTER_STRING];
 
-        if (unsigned(len) > sizeof(buf) - 8)
+        if (unsigned(len) > sizeof(buf))
             return false;
 
-        ret = stream.readRawData(buf, len);
+        const int ret = stream.readRawData(buf, len);
 
         if (ret != len || stream.status() == QDataStream::ReadPastEnd)
         {
             return false;
         }
 
-        buf[len] = '\0';
-
-        // strip trailing zero terminators
-        for (; len > 0;)
-        {
-            if (buf[len - 1] != '\0')
-                break;
-
-            len--;
-        }
-
-        if (len == 0)
-        {
-            d->m_value = QString();
-            return true;
-        }
-
-        unsigned codepoint = U_INVALID_UNICODE_CODEPOINT;
-        const char *p = &buf[0];
-        const char *pnonprint = nullptr;
-
-        while (p < &buf[len])
-        {
-            p = U_utf8_codepoint(p, &codepoint);
-
-            if (codepoint == U_INVALID_UNICODE_CODEPOINT)
-                break;
-
-            if (!pnonprint && codepoint == 0)
-                pnonprint = p - 1;
-        }
-
-        // in rare cases latin1 encoding has been seen, check this
-        if (codepoint == U_INVALID_UNICODE_CODEPOINT && isLikelyLatin1String(buf, len))
-        {
-            unsigned char utf8buf[256];
-
-            if (latin1ToUtf8Opinionated(buf, len, utf8buf, sizeof(utf8buf)))
-            {
-                d->m_value = QString::fromUtf8((const char*)&utf8buf[0]);
-                return true;
-            }
-        }
-
-        if (codepoint == U_INVALID_UNICODE_CODEPOINT)
-        {
-            // contains non utf8 characters
-            d->m_value = QByteArray(&buf[0], len);
-            d->m_formatHint = deCONZ::ZclAttribute::Prefix;
-            d->m_numericValue.u64 = unsigned(len);
-        }
-        else if (pnonprint && pnonprint < &buf[len - 1])
-        {
-            d->m_value = QByteArray(&buf[0], len);
-            d->m_numericValue.u64 = unsigned(len);
-        }
-        else if (p == &buf[len]) // note we also reach here if last codepoint is '\0'
-        {
-            for (;len > 0 && buf[len - 1] == '\0';)
-                len--;
-
-            d->m_value = QString::fromUtf8((const char*)&buf[0], len);
-        }
+        setCharacterStringValue(d, buf, len);
     }
         break;
 
@@ -862,7 +1013,7 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
     case Zcl8BitEnum:
     {
         stream >> d->m_numericValue.u8;
-        d->m_value = quint64(d->m_numericValue.u8);
+        d->m_valueKind = ZclAttributePrivate::ValueUInt64;
     }
         break;
 
@@ -886,12 +1037,12 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
             }
 
             d->m_numericValue.u16 = (quint16)ls.first().toUInt();
-            d->m_value = ls;
+            d->setVariant(ls);
         }
         else
         {
             stream >> d->m_numericValue.u16;
-            d->m_value = d->m_numericValue.u16;
+            d->m_valueKind = ZclAttributePrivate::ValueUInt16AsInt;
         }
         break;
 
@@ -899,28 +1050,28 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
     case Zcl32BitUint:
     {
         stream >> d->m_numericValue.u32;
-        d->m_value = d->m_numericValue.u32;
+        d->m_valueKind = ZclAttributePrivate::ValueUInt32;
     }
         break;
 
     case Zcl8BitInt:
     {
         stream >> d->m_numericValue.s8;
-        d->m_value = qint32(d->m_numericValue.s8);
+        d->m_valueKind = ZclAttributePrivate::ValueInt8;
     }
         break;
 
     case Zcl16BitInt:
     {
         stream >> d->m_numericValue.s16;
-        d->m_value = qint32(d->m_numericValue.s16);
+        d->m_valueKind = ZclAttributePrivate::ValueInt16;
     }
         break;
 
     case Zcl32BitInt:
     {
         stream >> d->m_numericValue.s32;
-        d->m_value = qint32(d->m_numericValue.s32);
+        d->m_valueKind = ZclAttributePrivate::ValueInt32;
     }
         break;
 
@@ -931,16 +1082,16 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
     {
         d->m_numericValue.s64 = 0;
 
-        if (type.length() > 8)
+        if (typeLength > 8)
         {
             return false;
         }
 
         // TODO the signed bit 0x80 needs to be extracted and processes.
         char bytes[8];
-        stream.readRawData(bytes, type.length());
-        memcpy(&d->m_numericValue.s64, bytes, type.length());
-        d->m_value = qint64(d->m_numericValue.s64);
+        stream.readRawData(bytes, typeLength);
+        memcpy(&d->m_numericValue.s64, bytes, typeLength);
+        d->m_valueKind = ZclAttributePrivate::ValueInt64;
     }
         break;
 
@@ -949,21 +1100,21 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
         qint64 s64;
         stream >> s64;
         d->m_numericValue.s64 = s64;
-        d->m_value = s64;
+        d->m_valueKind = ZclAttributePrivate::ValueInt64;
     }
         break;
 
     case ZclSingleFloat:
     {
         stream >> d->m_numericValue.u32;
-        d->m_value = qreal(d->m_numericValue.real);
+        d->m_valueKind = ZclAttributePrivate::ValueReal;
     }
         break;
 
     case ZclUtcTime:
     {
         stream >> d->m_numericValue.u32;
-        d->m_value = d->m_numericValue.u32;
+        d->m_valueKind = ZclAttributePrivate::ValueUInt32;
     }
         break;
 
@@ -990,14 +1141,14 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
     {
         d->m_numericValue.u64 = 0;
 
-        if (type.length() > 8)
+        if (typeLength > 8)
         {
             return false;
         }
 
         char bytes[8];
-        stream.readRawData(bytes, type.length());
-        memcpy(&d->m_numericValue.u64, bytes, type.length());
+        stream.readRawData(bytes, typeLength);
+        memcpy(&d->m_numericValue.u64, bytes, typeLength);
         setBitmap(d->m_numericValue.u64);
     }
     break;
@@ -1014,15 +1165,15 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
     {
         d->m_numericValue.u64 = 0;
 
-        if (type.length() > 8)
+        if (typeLength > 8)
         {
             return false;
         }
 
         char bytes[8];
-        stream.readRawData(bytes, type.length());
-        memcpy(&d->m_numericValue.u64, bytes, type.length());
-        d->m_value = quint64(d->m_numericValue.u64);
+        stream.readRawData(bytes, typeLength);
+        memcpy(&d->m_numericValue.u64, bytes, typeLength);
+        d->m_valueKind = ZclAttributePrivate::ValueUInt64;
     }
     break;
 
@@ -1033,7 +1184,7 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
         quint64 u64;
         stream >> u64;
         d->m_numericValue.u64 = u64;
-        d->m_value = u64;
+        d->m_valueKind = ZclAttributePrivate::ValueUInt64;
     }
     break;
 
@@ -1041,7 +1192,7 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
     {
         stream >> d->m_numericValue.u8;
         d->m_numericValue.u8 = (d->m_numericValue.u8 == 1) ? 1 : 0;
-        d->m_value = d->m_numericValue.u8 == 1;
+        d->m_valueKind = ZclAttributePrivate::ValueBool;
     }
         break;
 
@@ -1052,8 +1203,7 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
         stream >> m;
         d->m_numericValue.u64 = m;
 
-        const ZclDataType &dt = deCONZ::zclDataBase()->dataType(d->m_subType);
-        if (!dt.isValid())
+        if ((ZCL_DataTypeTraits(d->m_subType).flags & ZclTypeValid) == 0)
         {
             return false;
         }
@@ -1073,7 +1223,7 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
 
         if (len != -1)
         {
-            d->m_value.setValue(QByteArray(buf, len + 3));
+            d->setVariant(QByteArray(buf, len + 3));
             return true;
         }
     }
@@ -1093,351 +1243,339 @@ bool ZclAttribute::readFromStream(QDataStream &stream)
 }
 
 /*!
-    Writes the reportable change in the specifications format to the stream.
+    Reads the attribute value from the raw buffer \p data.
 
-    \return true if the data was written
-            false if the type is not supported or the data is not valid.
+    This gives the same results as readFromStream() but doesn't need a QDataStream
+    and ZCLDB lookups. The data type properties are taken from a compile-time table,
+    numeric values are decoded without heap allocations.
+
+    \param data pointer to the first byte of the value
+    \param size number of bytes available in \p data
+    \returns the number of bytes consumed, or 0 on error
  */
-bool ZclAttribute::writeReportableChangeToStream(QDataStream &stream) const
+int ZclAttribute::readFromBuffer(const uint8_t *data, unsigned size)
 {
-    bool ok = false;
+    if (!data || size == 0)
+    {
+        return 0;
+    }
 
-    switch (dataType())
+    Q_D(ZclAttribute);
+    const ZclDataTypeTraits ti = ZCL_DataTypeTraits(d->m_dataType);
+    d->m_numericValue.u64 = 0;
+
+    if ((ti.flags & ZclTypeKnown) == 0)
     {
-    case ZclBoolean:
-    case Zcl8BitUint:  stream << reportableChange().u8; return true;
-    case Zcl16BitUint: stream << reportableChange().u16; return true;
-    case Zcl32BitUint: stream << reportableChange().u32; return true;
-    case Zcl64BitUint: stream << (quint64)reportableChange().u64; return true;
+        DBG_Printf(DBG_ZCLDB, "ZCL Read Attributes Datatype 0x%02X not supported yet, abort\n", d->m_dataType);
+        return 0;
+    }
 
-    case Zcl8BitInt:  stream << reportableChange().s8; return true;
-    case Zcl16BitInt: stream << reportableChange().s16; return true;
-    case Zcl32BitInt: stream << reportableChange().s32; return true;
-    case Zcl64BitInt: stream << (qint64)reportableChange().s64; return true;
+    switch (d->m_dataType)
+    {
+    case ZclOctedString:
+    {
+        const unsigned len = data[0];
+        if (1 + len > size)
+        {
+            return 0;
+        }
 
-    case Zcl24BitUint:
-    case Zcl40BitUint:
-    case Zcl48BitUint:
-    case Zcl56BitUint:
+        d->setVariant(QByteArray(reinterpret_cast<const char*>(data + 1), int(len)));
+        d->m_numericValue.u64 = len;
+        return int(1 + len);
+    }
+
+    case ZclCharacterString:
     {
-        quint64 tmp = reportableChange().u64;
-        const ZclDataType &type = zclDataBase()->dataType(dataType());
+        const unsigned len = data[0];
+        if (len == 0)
+        {
+            d->setVariant(QString());
+            return 1;
+        }
 
-        if ((type.length() <= 0) || (type.length() > 64))
+        if (len > ZCL_MAX_CHARACTER_STRING || 1 + len > size)
         {
-            return false;
+            return 0;
         }
 
-        for (int i = 0; i < type.length(); i++)
+        setCharacterStringValue(d, reinterpret_cast<const char*>(data + 1), len);
+        return int(1 + len);
+    }
+
+    case ZclArray:
+    {
+        if (size < 3)
         {
-            stream << static_cast<quint8>(tmp & 0xff);
-            tmp >>= 8;
+            return 0;
+        }
+
+        d->m_subType = data[0];
+        const quint16 m = quint16(data[1] | data[2] << 8);
+        d->m_numericValue.u64 = m;
+
+        if ((ZCL_DataTypeTraits(d->m_subType).flags & ZclTypeValid) == 0)
+        {
+            return 0;
+        }
+
+        if (m == 0 || m == 0xffff || m > 32)
+        {
+            return 3;
         }
+
+        // assume array is only read as single attribute
+        const unsigned len = std::min(size, 256U);
+        d->setVariant(QByteArray(reinterpret_cast<const char*>(data), int(len)));
+        return int(len);
     }
-        return true;
 
     default:
-        ok = false;
         break;
     }
 
-    return ok;
-}
-
-bool ZclAttribute::readReportableChangeFromStream(QDataStream &stream)
-{
-    if (stream.atEnd())
+    if (ti.width == 0 || ti.width > size)
     {
-        return false;
+        return 0;
     }
 
-    Q_D(ZclAttribute);
-    ZclDataType type = zclDataBase()->dataType(dataType());
-
-    if (!zclDataBase()->knownDataType(dataType()))
+    if (d->m_dataType == Zcl16BitData || d->m_dataType == Zcl16BitUint || d->m_dataType == Zcl16BitEnum ||
+        d->m_dataType == ZclAttributeId || d->m_dataType == ZclClusterId)
     {
-        DBG_Printf(DBG_ZCLDB, "ZCL Read Attributes Datatype %02X %s"
-               " not supported yet, abort\n",
-               type.id(), qPrintable(type.name()));
-        return false;
-    }
+        if (isList() && (listSize() > 0))
+        {
+            QVariantList ls;
+            int i = listSize() - 1;
+            unsigned pos = 0;
 
-    d->m_reportableChange.u64 = 0;
-    qint64 s64;
-    quint64 u64;
+            while (i && pos < size)
+            {
+                if (pos + 2 > size)
+                {
+                    return 0;
+                }
+                ls.append(quint16(data[pos] | data[pos + 1] << 8));
+                pos += 2;
+                i--;
+            }
 
-    switch (dataType())
-    {
-    case Zcl8BitUint:  stream >> d->m_reportableChange.u8; break;
-    case Zcl16BitUint:  stream >> d->m_reportableChange.u16; break;
-    case Zcl32BitUint:  stream >> d->m_reportableChange.u32; break;
-    case Zcl64BitUint:  stream >> u64; d->m_reportableChange.u64 = u64; break;
+            d->m_numericValue.u16 = ls.isEmpty() ? 0 : quint16(ls.first().toUInt());
+            d->setVariant(ls);
+            return int(pos);
+        }
+    }
 
-    case Zcl24BitUint:
-    case Zcl40BitUint:
-    case Zcl48BitUint:
-    case Zcl56BitUint:
+    switch (ti.width)
     {
-        d->m_reportableChange.u64 = 0;
-
-        quint8 byte;
-        for (int i = 0; i < type.length(); i++)
+    case 1: d->m_numericValue.u8 = data[0]; break;
+    case 2: get_u16_le(data, &d->m_numericValue.u16); break;
+    case 4: get_u32_le(data, &d->m_numericValue.u32); break;
+    case 8: get_u64_le(data, &d->m_numericValue.u64); break;
+    default:
+        if (ti.width < 8)
         {
-            stream >> byte;
-            d->m_reportableChange.u64 |= byte << 8 * i;
+            memcpy(&d->m_numericValue.u64, data, ti.width);
         }
+        break;
     }
-    break;
-
-    case Zcl8BitInt:  stream >> d->m_reportableChange.s8; break;
-    case Zcl16BitInt:  stream >> d->m_reportableChange.s16; break;
-    case Zcl32BitInt:  stream >> d->m_reportableChange.s32; break;
-    case Zcl64BitInt:  stream >> s64; d->m_reportableChange.s64 = s64; break;
 
-    case ZclBoolean:   stream >> d->m_reportableChange.u8; break;
+    switch (d->m_dataType)
+    {
+    case Zcl8BitData:
+    case Zcl8BitUint:
+    case Zcl8BitEnum:
+        d->m_valueKind = ZclAttributePrivate::ValueUInt64;
+        break;
 
-    default:
-        return false;
-    }
+    case Zcl16BitData:
+    case Zcl16BitUint:
+    case Zcl16BitEnum:
+    case ZclAttributeId:
+    case ZclClusterId:
+        d->m_valueKind = ZclAttributePrivate::ValueUInt16AsInt;
+        break;
 
-    return true;
-}
+    case Zcl32BitData:
+    case Zcl32BitUint:
+    case ZclUtcTime:
+        d->m_valueKind = ZclAttributePrivate::ValueUInt32;
+        break;
 
-void ZclAttribute::setFormatHint(ZclAttribute::FormatHint formatHint)
-{
-    Q_D(ZclAttribute);
-    d->m_formatHint = formatHint;
-}
+    case Zcl8BitInt:  d->m_valueKind = ZclAttributePrivate::ValueInt8; break;
+    case Zcl16BitInt: d->m_valueKind = ZclAttributePrivate::ValueInt16; break;
+    case Zcl32BitInt: d->m_valueKind = ZclAttributePrivate::ValueInt32; break;
 
-ZclAttribute::FormatHint ZclAttribute::formatHint() const
-{
-    Q_D(const ZclAttribute);
-    return d->m_formatHint;
-}
+    case Zcl24BitInt:
+    case Zcl40BitInt:
+    case Zcl48BitInt:
+    case Zcl56BitInt:
+    case Zcl64BitInt:
+        d->m_valueKind = ZclAttributePrivate::ValueInt64;
+        break;
 
-int ZclAttribute::rangeMin() const
-{
-    Q_D(const ZclAttribute);
-    return d->m_rangeMin;
-}
+    case ZclSingleFloat:
+        d->m_valueKind = ZclAttributePrivate::ValueReal;
+        break;
 
-void ZclAttribute::setRangeMin(int rangeMin)
-{
-    Q_D(ZclAttribute);
-    d->m_rangeMin = rangeMin;
-}
+    case Zcl128BitSecurityKey:
+        setValue(QVariant(QByteArray(reinterpret_cast<const char*>(data), 16)));
+        break;
 
-int ZclAttribute::rangeMax() const
-{
-    Q_D(const ZclAttribute);
-    return d->m_rangeMax;
-}
+    case Zcl8BitBitMap:
+    case Zcl16BitBitMap:
+    case Zcl24BitBitMap:
+    case Zcl32BitBitMap:
+    case Zcl40BitBitMap:
+    case Zcl48BitBitMap:
+    case Zcl56BitBitMap:
+    case Zcl64BitBitMap:
+        setBitmap(d->m_numericValue.u64);
+        break;
 
-void ZclAttribute::setRangeMax(int rangeMax)
-{
-    Q_D(ZclAttribute);
-    d->m_rangeMax = rangeMax;
-}
+    case Zcl24BitData:
+    case Zcl40BitData:
+    case Zcl48BitData:
+    case Zcl56BitData:
+    case Zcl24BitUint:
+    case Zcl40BitUint:
+    case Zcl48BitUint:
+    case Zcl56BitUint:
+    case ZclIeeeAddress:
+    case Zcl64BitData:
+    case Zcl64BitUint:
+        d->m_valueKind = ZclAttributePrivate::ValueUInt64;
+        break;
 
-quint16 ZclAttribute::manufacturerCode() const
-{
-    Q_D(const ZclAttribute);
-    return d->m_manufacturerCode;
-}
+    case ZclBoolean:
+        d->m_numericValue.u8 = (d->m_numericValue.u8 == 1) ? 1 : 0;
+        d->m_valueKind = ZclAttributePrivate::ValueBool;
+        break;
 
-ManufacturerCode_t ZclAttribute::manufacturerCode_t() const
-{
-    Q_D(const ZclAttribute);
-    return ManufacturerCode_t(d->m_manufacturerCode);
-}
+    default:
+        return 0;
+    }
 
-void ZclAttribute::setManufacturerCode(quint16 mfcode)
-{
-    Q_D(ZclAttribute);
-    d->m_manufacturerCode = mfcode;
+    return ti.width;
 }
 
-void ZclAttribute::setManufacturerCode(ManufacturerCode_t mfcode)
+/*! Writes the lower \p width bytes of \p val in little endian order. */
+static uint8_t *putUintLe(uint8_t *p, uint64_t val, unsigned width)
 {
-    Q_D(ZclAttribute);
-    d->m_manufacturerCode = static_cast<quint16>(mfcode);
+    for (unsigned i = 0; i < width; i++)
+    {
+        *p++ = static_cast<uint8_t>(val & 0xff);
+        val >>= 8;
+    }
+    return p;
 }
 
-bool ZclAttribute::isManufacturerSpecific() const
+/*! Returns the value of \p num for a data type of \p width bytes independent of host byte order. */
+static uint64_t numericValueBits(const NumericUnion &num, unsigned width)
 {
-    Q_D(const ZclAttribute);
-    return d->m_manufacturerCode != 0;
+    switch (width)
+    {
+    case 1: return num.u8;
+    case 2: return num.u16;
+    case 4: return num.u32;
+    default: return num.u64;
+    }
 }
 
-void ZclAttribute::setAttributeSet(quint16 attrSetId, quint16 mfcode)
-{
-    Q_D(ZclAttribute);
-    d->m_attrSetId = attrSetId;
-    d->m_attrSetManufacturerCode = mfcode;
-}
+/*!
+    Writes the attribute in the specifications format to a caller provided buffer.
 
-quint16 ZclAttribute::attributeSet() const
-{
-    Q_D(const ZclAttribute);
-    return d->m_attrSetId;
-}
+    The bytes are the same as written by writeToStream(), but no QDataStream and
+    ZCLDB lookups are needed.
 
-quint16 ZclAttribute::attributeSetManufacturerCode() const
+    \param data the buffer, or nullptr to only calculate the required size
+    \param size size of \p data in bytes
+    \returns number of bytes written or required, 0 if the type is not supported,
+             the attribute is not valid or \p size is too small.
+ */
+int ZclAttribute::writeToBuffer(uint8_t *data, unsigned size) const
 {
     Q_D(const ZclAttribute);
-    return d->m_attrSetManufacturerCode;
-}
-
-void ZclAttribute::setValue(quint64 value)
-{
-    Q_D(ZclAttribute);
-    d->m_numericValue.u64 = 0;
+    const ZclDataTypeTraits ti = ZCL_DataTypeTraits(d->m_dataType);
+    QByteArray arr;
+    unsigned len = ti.width;
 
-    switch (dataType())
-    {
-    case ZclBoolean:
+    switch (d->m_dataType)
     {
-        d->m_numericValue.u8 = value > 0;
-        d->m_value = value > 0;
-    }
+    case Zcl8BitEnum:
+        if (d->m_numericValue.u32 > 0xFFul) { return 0; }
         break;
 
-    case Zcl8BitData:
-    case Zcl8BitUint:
-    {
-        d->m_numericValue.u8 = boundChecked(d->m_numericValue.u8, value);
-        d->m_value = uint(d->m_numericValue.u8);
-    }
+    case Zcl16BitEnum:
+        if (d->m_numericValue.u32 > 0xFFFFul) { return 0; }
         break;
 
-    case ZclAttributeId:
-    case ZclClusterId:
-    case Zcl16BitData:
-    case Zcl16BitUint:
-    {
-        d->m_numericValue.u16 = boundChecked(d->m_numericValue.u16, value);
-        d->m_value = uint(d->m_numericValue.u16);
-    }
+    case ZclOctedString:
+        if (d->value().isValid() && d->value().userType() == QVariant::ByteArray)
+        {
+            arr = d->value().toByteArray();
+            if (arr.size() > UINT8_MAX) { return 0; }
+        }
+        len = 1 + unsigned(arr.size());
         break;
 
-    case Zcl24BitUint:
-    case Zcl24BitData:
-    case Zcl32BitData:
-    case Zcl32BitUint:
-    case ZclUtcTime:
+    case ZclCharacterString:
     {
-        d->m_numericValue.u32 = boundChecked(d->m_numericValue.u32, value);
-        d->m_value = uint(d->m_numericValue.u32);
-    }
-        break;
+        const QString text = d->value().toString();
+        if (text.size() > UINT8_MAX) { return 0; }
 
-    case Zcl40BitData:
-    case Zcl40BitUint:
-    case Zcl48BitData:
-    case Zcl48BitUint:
-    case Zcl56BitData:
-    case Zcl56BitUint:
-    case ZclIeeeAddress:
-    case Zcl64BitData:
-    case Zcl64BitUint:
-    {
-        d->m_numericValue.u64 = value;
-        d->m_value = value;
+        arr.resize(text.size());
+        for (int i = 0; i < text.size(); i++)
+        {
+            arr[i] = text[i].toLatin1();
+        }
+        len = 1 + unsigned(arr.size());
     }
         break;
 
-    case Zcl8BitEnum:
-    case Zcl16BitEnum:
-    {
-        setEnumerator(value);
-    }
+    case Zcl128BitSecurityKey:
+        arr = d->value().toByteArray();
+        if (arr.size() != 16) { return 0; }
         break;
 
-    case Zcl8BitBitMap:
-    case Zcl16BitBitMap:
-    case Zcl24BitBitMap:
-    case Zcl32BitBitMap:
-    case Zcl40BitBitMap:
-    case Zcl48BitBitMap:
-    case Zcl56BitBitMap:
-    case Zcl64BitBitMap:
-    {
-       setBitmap(value);
-    }
-        break;
+    case ZclSemiFloat:
+    case ZclDoubleFloat:
+    case ZclTimeOfDay:
+    case ZclDate:
+        return 0; // not supported by writeToStream() either
 
     default:
+        if (ti.width == 0 || (ti.flags & ZclTypeValid) == 0)
         {
-            DBG_Printf(DBG_ERROR, "ZclAttribute::setValue() unsupported datatype 0x%02X\n", dataType());
+            return 0;
         }
         break;
     }
-}
-
-void ZclAttribute::setValue(bool value)
-{
-    Q_D(ZclAttribute);
-
-    if (dataType() == ZclBoolean)
-    {
-        d->m_numericValue.u64 = 0;
-        d->m_numericValue.u8 = (value == true) ? 1 : 0;
-        d->m_value.setValue(value);
-    }
-}
-
-void ZclAttribute::setValue(qint64 value)
-{
-    Q_D(ZclAttribute);
-
-    d->m_numericValue.s64 = 0;
-
-    switch (dataType())
-    {
-    case ZclBoolean:
-    {
-        d->m_numericValue.u8 = value > 0;
-        d->m_value = value > 0;
-    }
-        break;
 
-    case Zcl8BitInt:
+    if (!data)
     {
-        d->m_numericValue.s8 = boundChecked(d->m_numericValue.s8, value);
-        d->m_value = int(d->m_numericValue.s8);
+        return int(len);
     }
-        break;
 
-    case Zcl16BitInt:
+    if (len > size)
     {
-        d->m_numericValue.s16 = boundChecked(d->m_numericValue.s16, value);
-        d->m_value = int(d->m_numericValue.s16);
+        return 0;
     }
-        break;
 
-    case Zcl24BitInt:
-    case Zcl32BitInt:
-    {
-        d->m_numericValue.s32 = boundChecked(d->m_numericValue.s32, value);
-        d->m_value = int(d->m_numericValue.s32);
-    }
-        break;
+    uint8_t *p = data;
 
-    case Zcl40BitInt:
-    case Zcl48BitInt:
-    case Zcl56BitInt:
-    case Zcl64BitInt:
+    switch (d->m_dataType)
     {
-        d->m_numericValue.s64 = value;
-        d->m_value = value;
-    }
+    case ZclOctedString:
+    case ZclCharacterString:
+        *p++ = static_cast<uint8_t>(arr.size());
+        if (!arr.isEmpty())
+        {
+            memcpy(p, arr.constData(), size_t(arr.size()));
+        }
         break;
 
-    case Zcl8BitEnum:
-    case Zcl16BitEnum:
-    {
-        setEnumerator(uint(value));
-    }
+    case Zcl128BitSecurityKey:
+        memcpy(p, arr.constData(), 16);
         break;
 
     case Zcl8BitBitMap:
@@ -1448,393 +1586,423 @@ void ZclAttribute::setValue(qint64 value)
     case Zcl48BitBitMap:
     case Zcl56BitBitMap:
     case Zcl64BitBitMap:
+        putUintLe(p, bitmap(), ti.width);
+        break;
+
+    case Zcl24BitInt:
+    case Zcl40BitInt:
+    case Zcl48BitInt:
+    case Zcl56BitInt:
     {
-        setBitmap(static_cast<quint64>(value));
+        const uint64_t tmp = d->m_numericValue.s64 >= 0 ? d->m_numericValue.s64 : -d->m_numericValue.s64;
+        putUintLe(p, tmp, ti.width);
+        if (d->m_numericValue.s64 < 0)
+        {
+            p[ti.width - 1] |= 0x80; // signed
+        }
     }
         break;
 
     default:
-    {
-        DBG_Printf(DBG_INFO, "ZclAttribute::setValue(qint64 value) for unsupported datatype 0x%02X\n", dataType());
-    }
+        putUintLe(p, numericValueBits(d->m_numericValue, ti.width), ti.width);
         break;
     }
+
+    return int(len);
 }
 
-void ZclAttribute::setValue(const QVariant &value)
+/*!
+    Writes the reportable change in the specifications format to a caller provided buffer.
+
+    \param data the buffer, or nullptr to only calculate the required size
+    \param size size of \p data in bytes
+    \returns number of bytes written or required, 0 if the type is not supported or \p size is too small.
+ */
+int ZclAttribute::writeReportableChangeToBuffer(uint8_t *data, unsigned size) const
 {
-    bool ok;
-    Q_D(ZclAttribute);
+    Q_D(const ZclAttribute);
+    const ZclDataTypeTraits ti = ZCL_DataTypeTraits(d->m_dataType);
 
-    if (dataType() == ZclSingleFloat)
+    switch (d->m_dataType)
     {
-        const float val = value.toFloat(&ok);
-        if (!ok)
-        {
-            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X can't set float\n", id());
-        }
-        else
-        {
-            d->m_numericValue.real = val;
-            d->m_value = value;
-        }
+    case ZclBoolean:
+    case Zcl8BitUint:
+    case Zcl16BitUint:
+    case Zcl24BitUint:
+    case Zcl32BitUint:
+    case Zcl40BitUint:
+    case Zcl48BitUint:
+    case Zcl56BitUint:
+    case Zcl64BitUint:
+    case Zcl8BitInt:
+    case Zcl16BitInt:
+    case Zcl32BitInt:
+    case Zcl64BitInt:
+        break;
+
+    default:
+        return 0;
     }
-    else if (dataType() >= Zcl8BitBitMap && (dataType() <= Zcl64BitBitMap))
-    {
-        qulonglong bmp = value.toULongLong(&ok);
 
-        if (!ok)
-        {
-            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X cant't set bitmap mask\n", id());
-        }
-        else
+    if (data)
+    {
+        if (ti.width > size)
         {
-            setBitmap(bmp);
+            return 0;
         }
+        putUintLe(data, numericValueBits(d->m_reportableChange, ti.width), ti.width);
     }
-    else if ((dataType() == Zcl8BitEnum) || (dataType() == Zcl16BitEnum))
+
+    return ti.width;
+}
+
+/*!
+    Writes the reportable change in the specifications format to the stream.
+
+    \return true if the data was written
+            false if the type is not supported or the data is not valid.
+ */
+bool ZclAttribute::writeReportableChangeToStream(QDataStream &stream) const
+{
+    bool ok = false;
+
+    switch (dataType())
     {
-        const uint enumerator = value.toUInt(&ok);
+    case ZclBoolean:
+    case Zcl8BitUint:  stream << reportableChange().u8; return true;
+    case Zcl16BitUint: stream << reportableChange().u16; return true;
+    case Zcl32BitUint: stream << reportableChange().u32; return true;
+    case Zcl64BitUint: stream << (quint64)reportableChange().u64; return true;
 
-        if (!ok)
-        {
-            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X cant't set enumerator\n", id());
-        }
-        else
-        {
-            setEnumerator(enumerator);
-        }
-    }
-    else if (dataType() >= Zcl8BitUint && (dataType() <= Zcl64BitUint))
+    case Zcl8BitInt:  stream << reportableChange().s8; return true;
+    case Zcl16BitInt: stream << reportableChange().s16; return true;
+    case Zcl32BitInt: stream << reportableChange().s32; return true;
+    case Zcl64BitInt: stream << (qint64)reportableChange().s64; return true;
+
+    case Zcl24BitUint:
+    case Zcl40BitUint:
+    case Zcl48BitUint:
+    case Zcl56BitUint:
     {
-        const quint64 val = value.toULongLong(&ok);
+        quint64 tmp = reportableChange().u64;
+        const int typeLength = ZCL_DataTypeTraits(dataType()).width;
 
-        if (!ok)
+        if ((typeLength <= 0) || (typeLength > 64))
         {
-            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X cant't set value\n", id());
+            return false;
         }
-        else
+
+        for (int i = 0; i < typeLength; i++)
         {
-            setValue(val);
+            stream << static_cast<quint8>(tmp & 0xff);
+            tmp >>= 8;
         }
     }
-    else if (dataType() >= Zcl8BitInt && (dataType() <= Zcl64BitInt))
-    {
-        const qint64 val = value.toLongLong(&ok);
+        return true;
 
-        if (!ok)
-        {
-            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X cant't set value\n", id());
-        }
-        else
-        {
-            setValue(val);
-        }
+    default:
+        ok = false;
+        break;
     }
-    else if (dataType() >= Zcl8BitData && (dataType() <= Zcl64BitData))
-    {
-        const quint64 val = value.toULongLong(&ok);
 
-        if (!ok)
-        {
-            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X cant't set value\n", id());
-        }
-        else
-        {
-            setValue(val);
-        }
+    return ok;
+}
+
+bool ZclAttribute::readReportableChangeFromStream(QDataStream &stream)
+{
+    if (stream.atEnd())
+    {
+        return false;
     }
-    else if (dataType() == ZclBoolean)
+
+    Q_D(ZclAttribute);
+    const int typeLength = ZCL_DataTypeTraits(dataType()).width;
+
+    if ((ZCL_DataTypeTraits(dataType()).flags & ZclTypeKnown) == 0)
     {
-        d->m_numericValue.u64 = 0;
-        d->m_numericValue.u8 = value.toBool() ? 1 : 0;
-        d->m_value = value;
+        DBG_Printf(DBG_ZCLDB, "ZCL Read Attributes Datatype %02X %s"
+               " not supported yet, abort\n",
+               dataType(), qPrintable(zclSnapshot()->dataType(dataType()).name()));
+        return false;
     }
-    else
+
+    d->m_reportableChange.u64 = 0;
+    qint64 s64;
+    quint64 u64;
+
+    switch (dataType())
+    {
+    case Zcl8BitUint:  stream >> d->m_reportableChange.u8; break;
+    case Zcl16BitUint:  stream >> d->m_reportableChange.u16; break;
+    case Zcl32BitUint:  stream >> d->m_reportableChange.u32; break;
+    case Zcl64BitUint:  stream >> u64; d->m_reportableChange.u64 = u64; break;
+
+    case Zcl24BitUint:
+    case Zcl40BitUint:
+    case Zcl48BitUint:
+    case Zcl56BitUint:
     {
-        d->m_value = value;
+        d->m_reportableChange.u64 = 0;
+
+        quint8 byte;
+        for (int i = 0; i < typeLength; i++)
+        {
+            stream >> byte;
+            d->m_reportableChange.u64 |= byte << 8 * i;
+        }
     }
-}
+    break;
 
-void ZclAttribute::setLastRead(int64_t time)
-{
-    Q_D(ZclAttribute);
-    d->m_lastRead = time;
-}
+    case Zcl8BitInt:  stream >> d->m_reportableChange.s8; break;
+    case Zcl16BitInt:  stream >> d->m_reportableChange.s16; break;
+    case Zcl32BitInt:  stream >> d->m_reportableChange.s32; break;
+    case Zcl64BitInt:  stream >> s64; d->m_reportableChange.s64 = s64; break;
 
-uint16_t ZclAttribute::listSizeAttribute() const
-{
-    Q_D(const ZclAttribute);
-    return d->m_listSizeAttr;
+    case ZclBoolean:   stream >> d->m_reportableChange.u8; break;
+
+    default:
+        return false;
+    }
+
+    return true;
 }
 
-void ZclAttribute::setListSizeAttribute(uint16_t id)
+void ZclAttribute::setFormatHint(ZclAttribute::FormatHint formatHint)
 {
     Q_D(ZclAttribute);
-    d->m_listSizeAttr = id;
+    d->m_schema.detach()->m_formatHint = formatHint;
 }
 
-bool ZclAttribute::isList() const
+ZclAttribute::FormatHint ZclAttribute::formatHint() const
 {
     Q_D(const ZclAttribute);
-    return d->m_listSizeAttr != 0xFFFF;
+    return d->m_schema->m_formatHint;
 }
 
-int ZclAttribute::listSize() const
+int ZclAttribute::rangeMin() const
 {
     Q_D(const ZclAttribute);
-    return d->m_listSize;
+    return d->m_schema->m_rangeMin;
 }
 
-void ZclAttribute::setListSize(int listSize)
+void ZclAttribute::setRangeMin(int rangeMin)
 {
     Q_D(ZclAttribute);
-    d->m_listSize = listSize;
+    d->m_schema.detach()->m_rangeMin = rangeMin;
 }
 
-int64_t ZclAttribute::lastRead() const
+int ZclAttribute::rangeMax() const
 {
     Q_D(const ZclAttribute);
-    return d->m_lastRead;
+    return d->m_schema->m_rangeMax;
 }
 
-bool ZclAttribute::isReadonly() const
+void ZclAttribute::setRangeMax(int rangeMax)
 {
-    Q_D(const ZclAttribute);
-    return (d->m_access == ZclRead);
+    Q_D(ZclAttribute);
+    d->m_schema.detach()->m_rangeMax = rangeMax;
 }
 
-bool ZclAttribute::isWriteonly() const
+quint16 ZclAttribute::manufacturerCode() const
 {
     Q_D(const ZclAttribute);
-    return (d->m_access == ZclWrite);
+    return d->m_schema->m_manufacturerCode;
 }
 
-bool ZclAttribute::isMandatory() const
+ManufacturerCode_t ZclAttribute::manufacturerCode_t() const
 {
     Q_D(const ZclAttribute);
-    return d->m_required;
+    return ManufacturerCode_t(d->m_schema->m_manufacturerCode);
 }
 
-bool ZclAttribute::isAvailable() const
+void ZclAttribute::setManufacturerCode(quint16 mfcode)
 {
-    Q_D(const ZclAttribute);
-    return d->m_avail;
+    Q_D(ZclAttribute);
+    d->m_schema.detach()->m_manufacturerCode = mfcode;
 }
 
-void ZclAttribute::setAvailable(bool available)
+void ZclAttribute::setManufacturerCode(ManufacturerCode_t mfcode)
 {
     Q_D(ZclAttribute);
-    d->m_avail = available;
+    d->m_schema.detach()->m_manufacturerCode = static_cast<quint16>(mfcode);
 }
 
-uint8_t ZclAttribute::numericBase() const
+bool ZclAttribute::isManufacturerSpecific() const
 {
     Q_D(const ZclAttribute);
-    return d->m_numericBase;
+    return d->m_schema->m_manufacturerCode != 0;
 }
 
-void ZclAttribute::setNumericBase(uint8_t base)
+void ZclAttribute::setAttributeSet(quint16 attrSetId, quint16 mfcode)
 {
     Q_D(ZclAttribute);
-    d->m_numericBase = base;
+    ZclAttributeSchema *schema = d->m_schema.detach();
+    schema->m_attrSetId = attrSetId;
+    schema->m_attrSetManufacturerCode = mfcode;
 }
 
-uint ZclAttribute::enumerator() const
+quint16 ZclAttribute::attributeSet() const
 {
     Q_D(const ZclAttribute);
-    return d->m_numericValue.u32;
+    return d->m_schema->m_attrSetId;
 }
 
-void ZclAttribute::setEnumerator(uint value)
+quint16 ZclAttribute::attributeSetManufacturerCode() const
 {
-    Q_D(ZclAttribute);
-    d->m_numericValue.u32 = value;
-    d->m_value = value;
+    Q_D(const ZclAttribute);
+    return d->m_schema->m_attrSetManufacturerCode;
 }
 
-void ZclAttribute::setBit(uint bit, bool one)
+void ZclAttribute::setValue(quint64 value)
 {
     Q_D(ZclAttribute);
+    d->m_numericValue.u64 = 0;
 
-    if (bit < 64)
+    switch (dataType())
     {
-        if (one) d->m_valueState.bitmap |= (1ULL << (uint64_t)bit);
-        else     d->m_valueState.bitmap &= ~(1ULL << (uint64_t)bit);
-
-        d->m_value = quint64(d->m_valueState.bitmap);
+    case ZclBoolean:
+    {
+        d->m_numericValue.u8 = value > 0;
+        d->m_valueKind = ZclAttributePrivate::ValueBool;
     }
-}
-
-bool ZclAttribute::bit(int bit) const
-{
-    Q_D(const ZclAttribute);
-    if (bit >= 0 && bit < 64)
-        return d->m_valueState.bitmap & (1ULL << (uint64_t)bit);
-    return false;
-}
+        break;
 
-int ZclAttribute::bitCount() const
-{
-    switch (dataType()) {
-    case Zcl8BitBitMap:  return  8;
-    case Zcl16BitBitMap: return 16;
-    case Zcl24BitBitMap: return 24;
-    case Zcl32BitBitMap: return 32;
-    case Zcl40BitBitMap: return 40;
-    case Zcl48BitBitMap: return 48;
-    case Zcl56BitBitMap: return 56;
-    case Zcl64BitBitMap: return 64;
-    default:
+    case Zcl8BitData:
+    case Zcl8BitUint:
+    {
+        d->m_numericValue.u8 = boundChecked(d->m_numericValue.u8, value);
+        d->m_valueKind = ZclAttributePrivate::ValueUInt8;
+    }
         break;
+
+    case ZclAttributeId:
+    case ZclClusterId:
+    case Zcl16BitData:
+    case Zcl16BitUint:
+    {
+        d->m_numericValue.u16 = boundChecked(d->m_numericValue.u16, value);
+        d->m_valueKind = ZclAttributePrivate::ValueUInt16;
     }
+        break;
 
-    return 0;
-}
+    case Zcl24BitUint:
+    case Zcl24BitData:
+    case Zcl32BitData:
+    case Zcl32BitUint:
+    case ZclUtcTime:
+    {
+        d->m_numericValue.u32 = boundChecked(d->m_numericValue.u32, value);
+        d->m_valueKind = ZclAttributePrivate::ValueUInt32;
+    }
+        break;
 
-quint64 ZclAttribute::bitmap() const
-{
-    Q_D(const ZclAttribute);
-    return d->m_valueState.bitmap;
-}
+    case Zcl40BitData:
+    case Zcl40BitUint:
+    case Zcl48BitData:
+    case Zcl48BitUint:
+    case Zcl56BitData:
+    case Zcl56BitUint:
+    case ZclIeeeAddress:
+    case Zcl64BitData:
+    case Zcl64BitUint:
+    {
+        d->m_numericValue.u64 = value;
+        d->m_valueKind = ZclAttributePrivate::ValueUInt64;
+    }
+        break;
 
-void ZclAttribute::setBitmap(quint64 bmp)
-{
-    Q_D(ZclAttribute);
-    d->m_valueState.bitmap = bmp;
-    d->m_value = quint64(bmp);
-}
+    case Zcl8BitEnum:
+    case Zcl16BitEnum:
+    {
+        setEnumerator(value);
+    }
+        break;
 
-int ZclAttribute::enumCount() const
-{
-    Q_D(const ZclAttribute);
-    return int(d->m_valuePos.size());
-}
+    case Zcl8BitBitMap:
+    case Zcl16BitBitMap:
+    case Zcl24BitBitMap:
+    case Zcl32BitBitMap:
+    case Zcl40BitBitMap:
+    case Zcl48BitBitMap:
+    case Zcl56BitBitMap:
+    case Zcl64BitBitMap:
+    {
+       setBitmap(value);
+    }
+        break;
 
-quint8 ZclAttribute::enumerationId() const
-{
-    Q_D(const ZclAttribute);
-    return d->m_enumerationId;
+    default:
+        {
+            DBG_Printf(DBG_ERROR, "ZclAttribute::setValue() unsupported datatype 0x%02X\n", dataType());
+        }
+        break;
+    }
 }
 
-void ZclAttribute::setEnumerationId(quint8 id)
+void ZclAttribute::setValue(bool value)
 {
     Q_D(ZclAttribute);
-    d->m_enumerationId = id;
-}
 
-QString ZclAttribute::toString(ZclAttribute::FormatHint formatHint) const
-{
-    const ZclDataType &dataType = zclDataBase()->dataType(this->dataType());
-    return toString(dataType, formatHint);
+    if (dataType() == ZclBoolean)
+    {
+        d->m_numericValue.u64 = 0;
+        d->m_numericValue.u8 = (value == true) ? 1 : 0;
+        d->m_valueKind = ZclAttributePrivate::ValueBool;
+    }
 }
 
-QString ZclAttribute::toString(const ZclDataType &dataType, ZclAttribute::FormatHint formatHint) const
+void ZclAttribute::setValue(qint64 value)
 {
-    QString str;
-    Q_D(const ZclAttribute);
+    Q_D(ZclAttribute);
 
-    int fieldWidth = 0; // auto
-    if (numericBase() == 16)
-    {
-        fieldWidth = dataType.length() * 2;
-    }
+    d->m_numericValue.s64 = 0;
 
-    switch (d->m_dataType)
+    switch (dataType())
     {
     case ZclBoolean:
-        str = (d->m_numericValue.u8 == 1) ? QLatin1String("true") : QLatin1String("false");
-        break;
-
-    case ZclOctedString:
     {
-        if (d->m_value.isValid())
-        {
-            QByteArray arr = d->m_value.toByteArray();
-            if (arr.size() > 0)
-            {
-                U_SStream ss;
-                U_sstream_init(&ss, arr.data(), (unsigned)arr.size());
-
-                if (U_sstream_is_valid_utf8(&ss))
-                {
-                    str = arr;
-                }
-                else
-                {
-                    str = QLatin1String("0x") + arr.toHex();
-                }
-            }
-        }
+        d->m_numericValue.u8 = value > 0;
+        d->m_valueKind = ZclAttributePrivate::ValueBool;
     }
         break;
-    case ZclCharacterString:
+
+    case Zcl8BitInt:
     {
-        if (d->m_value.isValid())
-        {
-            if (d->m_formatHint == ZclAttribute::Prefix)
-            {
-                const QByteArray arr = d->m_value.toByteArray();
-                if (arr.size() > 0)
-                {
-                    str = QLatin1String("0x") + arr.toHex();
-                }
-            }
-            else
-            {
-                str = d->m_value.toString();
-            }
-        }
+        d->m_numericValue.s8 = boundChecked(d->m_numericValue.s8, value);
+        d->m_valueKind = ZclAttributePrivate::ValueInt8;
     }
         break;
 
-    case Zcl8BitData:
-    case Zcl8BitUint:
-        str = QString("%1").arg((quint16)d->m_numericValue.u8, fieldWidth, (int)numericBase(), QChar('0'));
-        break;
-    case ZclAttributeId:
-    case ZclClusterId:
-    case Zcl16BitUint:
-    case Zcl16BitData:
-        str = QString("%1").arg(d->m_numericValue.u16, fieldWidth, (int)numericBase(), QChar('0'));
-        break;
-    case Zcl24BitUint:
-    case Zcl32BitUint:
-        str = QString("%1").arg(d->m_numericValue.u32, fieldWidth, (int)numericBase(), QChar('0'));
-        break;
-
-    case Zcl40BitData:
-    case Zcl48BitData:
-    case Zcl56BitData:
-    case Zcl64BitData:
-
-    case Zcl40BitUint:
-    case Zcl48BitUint:
-    case Zcl56BitUint:
-    case Zcl64BitUint:
-        str = QString("%1").arg(d->m_numericValue.u64, fieldWidth, (int)numericBase(), QChar('0'));
-        break;
-
-    case ZclIeeeAddress:
-        str = QString("%1").arg(d->m_numericValue.u64, (int)16, (int)16, QChar('0'));
-        break;
-
-    case Zcl8BitInt:
-        str = QString("%1").arg((qint16)d->m_numericValue.s8, fieldWidth, (int)numericBase(), QChar('0'));
-        break;
     case Zcl16BitInt:
-        str = QString("%1").arg(d->m_numericValue.s16, fieldWidth, (int)numericBase(), QChar('0'));
+    {
+        d->m_numericValue.s16 = boundChecked(d->m_numericValue.s16, value);
+        d->m_valueKind = ZclAttributePrivate::ValueInt16;
+    }
         break;
+
     case Zcl24BitInt:
     case Zcl32BitInt:
-        str = QString("%1").arg(d->m_numericValue.s32, fieldWidth, (int)numericBase(), QChar('0'));
+    {
+        d->m_numericValue.s32 = boundChecked(d->m_numericValue.s32, value);
+        d->m_valueKind = ZclAttributePrivate::ValueInt32;
+    }
         break;
 
     case Zcl40BitInt:
     case Zcl48BitInt:
     case Zcl56BitInt:
     case Zcl64BitInt:
-        str = QString("%1").arg(d->m_numericValue.s64, fieldWidth, (int)numericBase(), QChar('0'));
+    {
+        d->m_numericValue.s64 = value;
+        d->m_valueKind = ZclAttributePrivate::ValueInt64;
+    }
+        break;
+
+    case Zcl8BitEnum:
+    case Zcl16BitEnum:
+    {
+        setEnumerator(uint(value));
+    }
         break;
 
     case Zcl8BitBitMap:
@@ -1846,398 +2014,795 @@ QString ZclAttribute::toString(const ZclDataType &dataType, ZclAttribute::Format
     case Zcl56BitBitMap:
     case Zcl64BitBitMap:
     {
-        str = QString("%1").arg(bitmap(), (int)dataType.length() * 2, (int)16, QChar('0'));
+        setBitmap(static_cast<quint64>(value));
     }
         break;
 
-    case Zcl8BitEnum:
-    case Zcl16BitEnum:
-        str = valueNameAt(enumerator());
-        if (str.isEmpty())
-        {
-            str = QString("%1").arg(enumerator(), (int)dataType.length() * 2, (int)16, QChar('0'));
-        }
-        break;
-
-    case ZclSingleFloat:
-        //DBG_Printf(DBG_INFO, "float: 0x%08X\n", d->m_numericValue.u32);
-        str.setNum(d->m_numericValue.real, 'g', 6);
-        break;
-
-    case ZclUtcTime:
+    default:
     {
-        // UTCTime is an unsigned 32-bit value representing the number of seconds since 0 hours, 0 minutes,
-        // 0 seconds, on the 1st of January, 2000 UTC (Universal Coordinated Time). The value that
-        // represents an invalid value of this type is 0xffffffff.
-
-        QDateTime utc = QDateTime::fromString(QLatin1String("2000-01-01T00:00:00Z"), Qt::ISODate);
-        str = utc.addSecs(d->m_numericValue.u32).toString();
+        DBG_Printf(DBG_INFO, "ZclAttribute::setValue(qint64 value) for unsupported datatype 0x%02X\n", dataType());
     }
         break;
+    }
+}
 
-    case Zcl128BitSecurityKey:
+void ZclAttribute::setValue(const QVariant &value)
+{
+    bool ok;
+    Q_D(ZclAttribute);
+
+    if (dataType() == ZclSingleFloat)
     {
-        if (d->m_value.isValid())
+        const float val = value.toFloat(&ok);
+        if (!ok)
+        {
+            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X can't set float\n", id());
+        }
+        else
         {
-            str = d->m_value.toByteArray().toHex();
+            d->m_numericValue.real = val;
+            d->setVariant(value);
         }
     }
-        break;
-
-    case ZclArray:
+    else if (dataType() >= Zcl8BitBitMap && (dataType() <= Zcl64BitBitMap))
     {
-        if (d->m_value.isValid())
+        qulonglong bmp = value.toULongLong(&ok);
+
+        if (!ok)
+        {
+            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X cant't set bitmap mask\n", id());
+        }
+        else
         {
-            str = d->m_value.toByteArray().toHex();
+            setBitmap(bmp);
         }
     }
-        break;
-
-
-    default:
+    else if ((dataType() == Zcl8BitEnum) || (dataType() == Zcl16BitEnum))
     {
-        DBG_Printf(DBG_ZCLDB, "ZclAttribute::toString()) no string support for data type %s\n", qPrintable(dataType.name()));
-    }
-        break;
-    }
+        const uint enumerator = value.toUInt(&ok);
 
-    switch (formatHint)
-    {
-    case Prefix:
-        if (numericBase() == 16)
+        if (!ok)
         {
-            str.prepend("0x");
+            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X cant't set enumerator\n", id());
         }
-        else if (numericBase() == 2)
+        else
         {
-            str.prepend("0b");
+            setEnumerator(enumerator);
         }
-        break;
-
-    default:
-        break;
     }
-
-    return str;
+    else if (dataType() >= Zcl8BitUint && (dataType() <= Zcl64BitUint))
+    {
+        const quint64 val = value.toULongLong(&ok);
+
+        if (!ok)
+        {
+            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X cant't set value\n", id());
+        }
+        else
+        {
+            setValue(val);
+        }
+    }
+    else if (dataType() >= Zcl8BitInt && (dataType() <= Zcl64BitInt))
+    {
+        const qint64 val = value.toLongLong(&ok);
+
+        if (!ok)
+        {
+            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X cant't set value\n", id());
+        }
+        else
+        {
+            setValue(val);
+        }
+    }
+    else if (dataType() >= Zcl8BitData && (dataType() <= Zcl64BitData))
+    {
+        const quint64 val = value.toULongLong(&ok);
+
+        if (!ok)
+        {
+            DBG_Printf(DBG_ZCLDB, "ZclAttribute 0x%04X cant't set value\n", id());
+        }
+        else
+        {
+            setValue(val);
+        }
+    }
+    else if (dataType() == ZclBoolean)
+    {
+        d->m_numericValue.u64 = 0;
+        d->m_numericValue.u8 = value.toBool() ? 1 : 0;
+        d->setVariant(value);
+    }
+    else
+    {
+        d->setVariant(value);
+    }
 }
 
-const QVariant &ZclAttribute::toVariant() const
+void ZclAttribute::setLastRead(int64_t time)
 {
-    Q_D(const ZclAttribute);
-    return d->m_value;
+    Q_D(ZclAttribute);
+    d->m_lastRead = time;
 }
 
-uint16_t ZclAttribute::minReportInterval() const
+uint16_t ZclAttribute::listSizeAttribute() const
 {
     Q_D(const ZclAttribute);
-    return d->m_minReportInterval;
+    return d->m_schema->m_listSizeAttr;
 }
 
-void ZclAttribute::setMinReportInterval(uint16_t interval)
+void ZclAttribute::setListSizeAttribute(uint16_t id)
 {
     Q_D(ZclAttribute);
-    d->m_minReportInterval = interval;
+    d->m_schema.detach()->m_listSizeAttr = id;
 }
 
-uint16_t ZclAttribute::maxReportInterval() const
+bool ZclAttribute::isList() const
 {
     Q_D(const ZclAttribute);
-    return d->m_maxReportInterval;
-}
-
-void ZclAttribute::setMaxReportInterval(uint16_t interval)
-{
-    Q_D(ZclAttribute);
-    d->m_maxReportInterval = interval;
+    return d->m_schema->m_listSizeAttr != 0xFFFF;
 }
 
-uint16_t ZclAttribute::reportTimeoutPeriod() const
+int ZclAttribute::listSize() const
 {
     Q_D(const ZclAttribute);
-    return d->m_reportTimeout;
+    return d->m_listSize;
 }
 
-void ZclAttribute::setReportTimeoutPeriod(uint16_t period)
+void ZclAttribute::setListSize(int listSize)
 {
     Q_D(ZclAttribute);
-    d->m_reportTimeout = period;
+    d->m_listSize = listSize;
 }
 
-const NumericUnion &ZclAttribute::reportableChange() const
+int64_t ZclAttribute::lastRead() const
 {
     Q_D(const ZclAttribute);
-    return d->m_reportableChange;
+    return d->m_lastRead;
 }
 
-void ZclAttribute::setReportableChange(const NumericUnion &reportableChange)
+bool ZclAttribute::isReadonly() const
 {
-    Q_D(ZclAttribute);
-    d->m_reportableChange = reportableChange;
+    Q_D(const ZclAttribute);
+    return (d->m_schema->m_access == ZclRead);
 }
 
-ZclAttributeSetPrivate::ZclAttributeSetPrivate() :
-    id(0xFFFF),
-    manufacturerCode(0)
+bool ZclAttribute::isWriteonly() const
 {
+    Q_D(const ZclAttribute);
+    return (d->m_schema->m_access == ZclWrite);
 }
 
-ZclAttributeSet::ZclAttributeSet() :
-    d_ptr(new ZclAttributeSetPrivate)
+bool ZclAttribute::isMandatory() const
 {
+    Q_D(const ZclAttribute);
+    return d->m_schema->m_required;
 }
 
-ZclAttributeSet::~ZclAttributeSet()
+bool ZclAttribute::isAvailable() const
 {
-    delete d_ptr;
-    d_ptr = 0;
+    Q_D(const ZclAttribute);
+    return d->m_avail;
 }
 
-ZclAttributeSet::ZclAttributeSet(const ZclAttributeSet &other) :
-    d_ptr(new ZclAttributeSetPrivate(*other.d_ptr))
+void ZclAttribute::setAvailable(bool available)
 {
+    Q_D(ZclAttribute);
+    d->m_avail = available;
 }
 
-ZclAttributeSet &ZclAttributeSet::operator= (const ZclAttributeSet &other)
+uint8_t ZclAttribute::numericBase() const
 {
-    // Self assignment?
-    if (this == &other)
-    {
-        return *this;
-    }
-
-    DBG_Assert(other.d_ptr != 0);
-    *this->d_ptr = *other.d_ptr;
-    return *this;
+    Q_D(const ZclAttribute);
+    return d->m_schema->m_numericBase;
 }
 
-ZclAttributeSet::ZclAttributeSet(uint16_t id, const QString &description) :
-    d_ptr(new ZclAttributeSetPrivate)
+void ZclAttribute::setNumericBase(uint8_t base)
 {
-    Q_D(ZclAttributeSet);
-    d->id = id;
-    d->description = description;
-
-#ifdef ZCL_LOAD_DBG
-    qDebug("Attribute Set: %04X -- %s", id, qPrintable(description));
-#endif
+    Q_D(ZclAttribute);
+    d->m_schema.detach()->m_numericBase = base;
 }
 
-uint16_t ZclAttributeSet::id() const
+uint ZclAttribute::enumerator() const
 {
-    Q_D(const ZclAttributeSet);
-    return d->id;
+    Q_D(const ZclAttribute);
+    return d->m_numericValue.u32;
 }
 
-const QString &ZclAttributeSet::description() const
+void ZclAttribute::setEnumerator(uint value)
 {
-    Q_D(const ZclAttributeSet);
-    return d->description;
+    Q_D(ZclAttribute);
+    d->m_numericValue.u32 = value;
+    d->m_valueKind = ZclAttributePrivate::ValueUInt32;
 }
 
-const std::vector<int> &ZclAttributeSet::attributes() const
+void ZclAttribute::setBit(uint bit, bool one)
 {
-    Q_D(const ZclAttributeSet);
-    return d->attributeIndexes;
+    Q_D(ZclAttribute);
+
+    if (bit < 64)
+    {
+        if (one) d->m_valueState.bitmap |= (1ULL << (uint64_t)bit);
+        else     d->m_valueState.bitmap &= ~(1ULL << (uint64_t)bit);
+
+        d->m_valueKind = ZclAttributePrivate::ValueBitmap;
+    }
 }
 
-void ZclAttributeSet::addAttribute(int idx)
+bool ZclAttribute::bit(int bit) const
 {
-    Q_D(ZclAttributeSet);
-    d->attributeIndexes.push_back(idx);
+    Q_D(const ZclAttribute);
+    if (bit >= 0 && bit < 64)
+        return d->m_valueState.bitmap & (1ULL << (uint64_t)bit);
+    return false;
 }
 
-quint16 ZclAttributeSet::manufacturerCode() const
+int ZclAttribute::bitCount() const
 {
-    Q_D(const ZclAttributeSet);
-    return d->manufacturerCode;
+    switch (dataType()) {
+    case Zcl8BitBitMap:  return  8;
+    case Zcl16BitBitMap: return 16;
+    case Zcl24BitBitMap: return 24;
+    case Zcl32BitBitMap: return 32;
+    case Zcl40BitBitMap: return 40;
+    case Zcl48BitBitMap: return 48;
+    case Zcl56BitBitMap: return 56;
+    case Zcl64BitBitMap: return 64;
+    default:
+        break;
+    }
+
+    return 0;
 }
 
-void ZclAttributeSet::setManufacturerCode(quint16 mfcode)
+quint64 ZclAttribute::bitmap() const
 {
-    Q_D(ZclAttributeSet);
-    d->manufacturerCode = mfcode;
+    Q_D(const ZclAttribute);
+    return d->m_valueState.bitmap;
 }
 
-ZclCommandPrivate::ZclCommandPrivate() :
-    m_id (0xFF),
-    m_manufacturerId(0),
-    m_responseId(0xFF),
-    m_required(false),
-    m_recv(false),
-    m_isProfileWide(false),
-    m_disableDefaultResponse(false)
+void ZclAttribute::setBitmap(quint64 bmp)
 {
+    Q_D(ZclAttribute);
+    d->m_valueState.bitmap = bmp;
+    d->m_valueKind = ZclAttributePrivate::ValueBitmap;
 }
 
-ZclCommand::ZclCommand() :
-    d_ptr(new ZclCommandPrivate)
+int ZclAttribute::enumCount() const
 {
-
+    Q_D(const ZclAttribute);
+    return int(d->m_schema->m_valuePos.size());
 }
 
-ZclCommand::ZclCommand(const ZclCommand &other) :
-    d_ptr(new ZclCommandPrivate(*other.d_ptr))
+quint8 ZclAttribute::enumerationId() const
 {
+    Q_D(const ZclAttribute);
+    return d->m_schema->m_enumerationId;
 }
 
-ZclCommand::ZclCommand(ZclCommand &&other) noexcept :
-    d_ptr(other.d_ptr)
+void ZclAttribute::setEnumerationId(quint8 id)
 {
-    Q_ASSERT(d_ptr);
-    Q_ASSERT(other.d_ptr);
-    other.d_ptr = nullptr;
+    Q_D(ZclAttribute);
+    d->m_schema.detach()->m_enumerationId = id;
 }
 
-ZclCommand &ZclCommand::operator=(const ZclCommand &other)
+QString ZclAttribute::toString(ZclAttribute::FormatHint formatHint) const
 {
-    // Self assignment?
-    if (this == &other)
-    {
-        return *this;
-    }
-
-    Q_ASSERT(d_ptr);
-    Q_ASSERT(other.d_ptr);
-    *d_ptr = *other.d_ptr;
-    return *this;
+    const ZclSnapshotPtr db = zclSnapshot(); // safe on any thread, the live database isn't
+    return toString(db->dataType(dataType()), formatHint);
 }
 
-ZclCommand &ZclCommand::operator=(ZclCommand &&other) noexcept
+QString ZclAttribute::toString(const ZclDataType &dataType, ZclAttribute::FormatHint formatHint) const
 {
-    // Self assignment?
-    if (this == &other)
-    {
-        return *this;
-    }
-
-    Q_ASSERT(other.d_ptr);
+    QString str;
+    Q_D(const ZclAttribute);
 
-    if (d_ptr)
+    int fieldWidth = 0; // auto
+    if (numericBase() == 16)
     {
-        delete d_ptr;
+        fieldWidth = dataType.length() * 2;
     }
 
-    d_ptr = other.d_ptr;
-    other.d_ptr = nullptr;
-    Q_ASSERT(d_ptr);
+    switch (d->m_dataType)
+    {
+    case ZclBoolean:
+        str = (d->m_numericValue.u8 == 1) ? QLatin1String("true") : QLatin1String("false");
+        break;
 
-    return *this;
-}
+    case ZclOctedString:
+    {
+        if (d->value().isValid())
+        {
+            QByteArray arr = d->value().toByteArray();
+            if (arr.size() > 0)
+            {
+                U_SStream ss;
+                U_sstream_init(&ss, arr.data(), (unsigned)arr.size());
 
-ZclCommand::ZclCommand(uint8_t id, const QString &name, bool required, bool recv, const QString &description) :
-    d_ptr(new ZclCommandPrivate)
-{
-    Q_D(ZclCommand);
-    d->m_id = id;
-    d->m_responseId = 0xFF;
-    d->m_name = name;
-    d->m_required = required;
-    d->m_recv = recv;
-    d->m_description = description;
-    d->m_isProfileWide = false;
-    d->m_disableDefaultResponse = false;
-#ifdef ZCL_LOAD_DBG_COMMAND
-    qDebug("Command: %s %02X", qPrintable(name), id);
-#endif
-}
+                if (U_sstream_is_valid_utf8(&ss))
+                {
+                    str = arr;
+                }
+                else
+                {
+                    str = QLatin1String("0x") + arr.toHex();
+                }
+            }
+        }
+    }
+        break;
+    case ZclCharacterString:
+    {
+        if (d->value().isValid())
+        {
+            if (d->m_schema->m_formatHint == ZclAttribute::Prefix)
+            {
+                const QByteArray arr = d->value().toByteArray();
+                if (arr.size() > 0)
+                {
+                    str = QLatin1String("0x") + arr.toHex();
+                }
+            }
+            else
+            {
+                str = d->value().toString();
+            }
+        }
+    }
+        break;
 
-ZclCommand::~ZclCommand()
-{
-    if (d_ptr)
+    case Zcl8BitData:
+    case Zcl8BitUint:
+        str = QString("%1").arg((quint16)d->m_numericValue.u8, fieldWidth, (int)numericBase(), QChar('0'));
+        break;
+    case ZclAttributeId:
+    case ZclClusterId:
+    case Zcl16BitUint:
+    case Zcl16BitData:
+        str = QString("%1").arg(d->m_numericValue.u16, fieldWidth, (int)numericBase(), QChar('0'));
+        break;
+    case Zcl24BitUint:
+    case Zcl32BitUint:
+        str = QString("%1").arg(d->m_numericValue.u32, fieldWidth, (int)numericBase(), QChar('0'));
+        break;
+
+    case Zcl40BitData:
+    case Zcl48BitData:
+    case Zcl56BitData:
+    case Zcl64BitData:
+
+    case Zcl40BitUint:
+    case Zcl48BitUint:
+    case Zcl56BitUint:
+    case Zcl64BitUint:
+        str = QString("%1").arg(d->m_numericValue.u64, fieldWidth, (int)numericBase(), QChar('0'));
+        break;
+
+    case ZclIeeeAddress:
+        str = QString("%1").arg(d->m_numericValue.u64, (int)16, (int)16, QChar('0'));
+        break;
+
+    case Zcl8BitInt:
+        str = QString("%1").arg((qint16)d->m_numericValue.s8, fieldWidth, (int)numericBase(), QChar('0'));
+        break;
+    case Zcl16BitInt:
+        str = QString("%1").arg(d->m_numericValue.s16, fieldWidth, (int)numericBase(), QChar('0'));
+        break;
+    case Zcl24BitInt:
+    case Zcl32BitInt:
+        str = QString("%1").arg(d->m_numericValue.s32, fieldWidth, (int)numericBase(), QChar('0'));
+        break;
+
+    case Zcl40BitInt:
+    case Zcl48BitInt:
+    case Zcl56BitInt:
+    case Zcl64BitInt:
+        str = QString("%1").arg(d->m_numericValue.s64, fieldWidth, (int)numericBase(), QChar('0'));
+        break;
+
+    case Zcl8BitBitMap:
+    case Zcl16BitBitMap:
+    case Zcl24BitBitMap:
+    case Zcl32BitBitMap:
+    case Zcl40BitBitMap:
+    case Zcl48BitBitMap:
+    case Zcl56BitBitMap:
+    case Zcl64BitBitMap:
     {
-        delete d_ptr;
-        d_ptr = nullptr;
+        str = QString("%1").arg(bitmap(), (int)dataType.length() * 2, (int)16, QChar('0'));
     }
-}
+        break;
 
-uint8_t ZclCommand::id() const
-{
-    Q_D(const ZclCommand);
-    return d->m_id;
+    case Zcl8BitEnum:
+    case Zcl16BitEnum:
+        str = valueNameAt(enumerator());
+        if (str.isEmpty())
+        {
+            str = QString("%1").arg(enumerator(), (int)dataType.length() * 2, (int)16, QChar('0'));
+        }
+        break;
+
+    case ZclSingleFloat:
+        //DBG_Printf(DBG_INFO, "float: 0x%08X\n", d->m_numericValue.u32);
+        str.setNum(d->m_numericValue.real, 'g', 6);
+        break;
+
+    case ZclUtcTime:
+    {
+        // UTCTime is an unsigned 32-bit value representing the number of seconds since 0 hours, 0 minutes,
+        // 0 seconds, on the 1st of January, 2000 UTC (Universal Coordinated Time). The value that
+        // represents an invalid value of this type is 0xffffffff.
+
+        QDateTime utc = QDateTime::fromString(QLatin1String("2000-01-01T00:00:00Z"), Qt::ISODate);
+        str = utc.addSecs(d->m_numericValue.u32).toString();
+    }
+        break;
+
+    case Zcl128BitSecurityKey:
+    {
+        if (d->value().isValid())
+        {
+            str = d->value().toByteArray().toHex();
+        }
+    }
+        break;
+
+    case ZclArray:
+    {
+        if (d->value().isValid())
+        {
+            str = d->value().toByteArray().toHex();
+        }
+    }
+        break;
+
+
+    default:
+    {
+        DBG_Printf(DBG_ZCLDB, "ZclAttribute::toString()) no string support for data type %s\n", qPrintable(dataType.name()));
+    }
+        break;
+    }
+
+    switch (formatHint)
+    {
+    case Prefix:
+        if (numericBase() == 16)
+        {
+            str.prepend("0x");
+        }
+        else if (numericBase() == 2)
+        {
+            str.prepend("0b");
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return str;
 }
 
-ZclCommandId_t ZclCommand::id_t() const
+const QVariant &ZclAttribute::toVariant() const
 {
-    Q_D(const ZclCommand);
-    return ZclCommandId_t(d->m_id);
+    Q_D(const ZclAttribute);
+    return d->value();
 }
 
-void ZclCommand::setId(uint8_t id)
+uint16_t ZclAttribute::minReportInterval() const
 {
-    Q_D(ZclCommand);
-    d->m_id = id;
+    Q_D(const ZclAttribute);
+    return d->m_minReportInterval;
 }
 
-bool ZclCommand::isValid() const
+void ZclAttribute::setMinReportInterval(uint16_t interval)
 {
-    Q_D(const ZclCommand);
-    return (d->m_id != 0xFF);
+    Q_D(ZclAttribute);
+    d->m_minReportInterval = interval;
 }
 
-
-uint16_t ZclCommand::manufacturerId() const
+uint16_t ZclAttribute::maxReportInterval() const
 {
-    Q_D(const ZclCommand);
-    return d->m_manufacturerId;
+    Q_D(const ZclAttribute);
+    return d->m_maxReportInterval;
 }
 
-void ZclCommand::setManufacturerId(uint16_t id)
+void ZclAttribute::setMaxReportInterval(uint16_t interval)
 {
-    Q_D(ZclCommand);
-    d->m_manufacturerId = id;
+    Q_D(ZclAttribute);
+    d->m_maxReportInterval = interval;
 }
 
-uint8_t ZclCommand::responseId() const
+uint16_t ZclAttribute::reportTimeoutPeriod() const
 {
-    Q_D(const ZclCommand);
-    return d->m_responseId;
+    Q_D(const ZclAttribute);
+    return d->m_reportTimeout;
 }
 
-void ZclCommand::setResponseId(uint8_t id)
+void ZclAttribute::setReportTimeoutPeriod(uint16_t period)
 {
-    Q_D(ZclCommand);
-    d->m_responseId = id;
+    Q_D(ZclAttribute);
+    d->m_reportTimeout = period;
 }
 
-bool ZclCommand::hasResponse() const
+const NumericUnion &ZclAttribute::reportableChange() const
 {
-    Q_D(const ZclCommand);
-    return (d->m_responseId != 0xFF);
+    Q_D(const ZclAttribute);
+    return d->m_reportableChange;
 }
 
-bool ZclCommand::directionReceived() const
+void ZclAttribute::setReportableChange(const NumericUnion &reportableChange)
 {
-    Q_D(const ZclCommand);
-    return d->m_recv;
+    Q_D(ZclAttribute);
+    d->m_reportableChange = reportableChange;
 }
 
-bool ZclCommand::directionSend() const
+ZclAttributeSetPrivate::ZclAttributeSetPrivate() :
+    id(0xFFFF),
+    manufacturerCode(0)
 {
-    Q_D(const ZclCommand);
-    return !d->m_recv;
 }
 
-const QString &ZclCommand::name() const
+ZclAttributeSet::ZclAttributeSet() :
+    d_ptr(new ZclAttributeSetPrivate)
 {
-    Q_D(const ZclCommand);
-    return d->m_name;
 }
 
-const QString &ZclCommand::description() const
+ZclAttributeSet::~ZclAttributeSet()
 {
-    Q_D(const ZclCommand);
-    return d->m_description;
+    delete d_ptr;
+    d_ptr = 0;
 }
 
-void ZclCommand::setDescription(const QString &description)
+ZclAttributeSet::ZclAttributeSet(const ZclAttributeSet &other) :
+    d_ptr(new ZclAttributeSetPrivate(*other.d_ptr))
 {
-    Q_D(ZclCommand);
-    d->m_description = description;
 }
 
-bool ZclCommand::isProfileWide() const
+ZclAttributeSet &ZclAttributeSet::operator= (const ZclAttributeSet &other)
 {
-    Q_D(const ZclCommand);
+    // Self assignment?
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    DBG_Assert(other.d_ptr != 0);
+    *this->d_ptr = *other.d_ptr;
+    return *this;
+}
+
+ZclAttributeSet::ZclAttributeSet(uint16_t id, const QString &description) :
+    d_ptr(new ZclAttributeSetPrivate)
+{
+    Q_D(ZclAttributeSet);
+    d->id = id;
+    d->description = description;
+
+#ifdef ZCL_LOAD_DBG
+    qDebug("Attribute Set: %04X -- %s", id, qPrintable(description));
+#endif
+}
+
+uint16_t ZclAttributeSet::id() const
+{
+    Q_D(const ZclAttributeSet);
+    return d->id;
+}
+
+const QString &ZclAttributeSet::description() const
+{
+    Q_D(const ZclAttributeSet);
+    return d->description;
+}
+
+const std::vector<int> &ZclAttributeSet::attributes() const
+{
+    Q_D(const ZclAttributeSet);
+    return d->attributeIndexes;
+}
+
+void ZclAttributeSet::addAttribute(int idx)
+{
+    Q_D(ZclAttributeSet);
+    d->attributeIndexes.push_back(idx);
+}
+
+quint16 ZclAttributeSet::manufacturerCode() const
+{
+    Q_D(const ZclAttributeSet);
+    return d->manufacturerCode;
+}
+
+void ZclAttributeSet::setManufacturerCode(quint16 mfcode)
+{
+    Q_D(ZclAttributeSet);
+    d->manufacturerCode = mfcode;
+}
+
+ZclCommandPrivate::ZclCommandPrivate() :
+    m_id (0xFF),
+    m_manufacturerId(0),
+    m_responseId(0xFF),
+    m_required(false),
+    m_recv(false),
+    m_isProfileWide(false),
+    m_disableDefaultResponse(false)
+{
+}
+
+ZclCommand::ZclCommand() :
+    d_ptr(new ZclCommandPrivate)
+{
+
+}
+
+ZclCommand::ZclCommand(const ZclCommand &other) :
+    d_ptr(new ZclCommandPrivate(*other.d_ptr))
+{
+}
+
+ZclCommand::ZclCommand(ZclCommand &&other) noexcept :
+    d_ptr(other.d_ptr)
+{
+    Q_ASSERT(d_ptr);
+    Q_ASSERT(other.d_ptr);
+    other.d_ptr = nullptr;
+}
+
+ZclCommand &ZclCommand::operator=(const ZclCommand &other)
+{
+    // Self assignment?
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    Q_ASSERT(d_ptr);
+    Q_ASSERT(other.d_ptr);
+    *d_ptr = *other.d_ptr;
+    return *this;
+}
+
+ZclCommand &ZclCommand::operator=(ZclCommand &&other) noexcept
+{
+    // Self assignment?
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    Q_ASSERT(other.d_ptr);
+
+    if (d_ptr)
+    {
+        delete d_ptr;
+    }
+
+    d_ptr = other.d_ptr;
+    other.d_ptr = nullptr;
+    Q_ASSERT(d_ptr);
+
+    return *this;
+}
+
+ZclCommand::ZclCommand(uint8_t id, const QString &name, bool required, bool recv, const QString &description) :
+    d_ptr(new ZclCommandPrivate)
+{
+    Q_D(ZclCommand);
+    d->m_id = id;
+    d->m_responseId = 0xFF;
+    d->m_name = name;
+    d->m_required = required;
+    d->m_recv = recv;
+    d->m_description = description;
+    d->m_isProfileWide = false;
+    d->m_disableDefaultResponse = false;
+#ifdef ZCL_LOAD_DBG_COMMAND
+    qDebug("Command: %s %02X", qPrintable(name), id);
+#endif
+}
+
+ZclCommand::~ZclCommand()
+{
+    if (d_ptr)
+    {
+        delete d_ptr;
+        d_ptr = nullptr;
+    }
+}
+
+uint8_t ZclCommand::id() const
+{
+    Q_D(const ZclCommand);
+    return d->m_id;
+}
+
+ZclCommandId_t ZclCommand::id_t() const
+{
+    Q_D(const ZclCommand);
+    return ZclCommandId_t(d->m_id);
+}
+
+void ZclCommand::setId(uint8_t id)
+{
+    Q_D(ZclCommand);
+    d->m_id = id;
+}
+
+bool ZclCommand::isValid() const
+{
+    Q_D(const ZclCommand);
+    return (d->m_id != 0xFF);
+}
+
+
+uint16_t ZclCommand::manufacturerId() const
+{
+    Q_D(const ZclCommand);
+    return d->m_manufacturerId;
+}
+
+void ZclCommand::setManufacturerId(uint16_t id)
+{
+    Q_D(ZclCommand);
+    d->m_manufacturerId = id;
+}
+
+uint8_t ZclCommand::responseId() const
+{
+    Q_D(const ZclCommand);
+    return d->m_responseId;
+}
+
+void ZclCommand::setResponseId(uint8_t id)
+{
+    Q_D(ZclCommand);
+    d->m_responseId = id;
+}
+
+bool ZclCommand::hasResponse() const
+{
+    Q_D(const ZclCommand);
+    return (d->m_responseId != 0xFF);
+}
+
+bool ZclCommand::directionReceived() const
+{
+    Q_D(const ZclCommand);
+    return d->m_recv;
+}
+
+bool ZclCommand::directionSend() const
+{
+    Q_D(const ZclCommand);
+    return !d->m_recv;
+}
+
+const QString &ZclCommand::name() const
+{
+    Q_D(const ZclCommand);
+    return d->m_name;
+}
+
+const QString &ZclCommand::description() const
+{
+    Q_D(const ZclCommand);
+    return d->m_description;
+}
+
+void ZclCommand::setDescription(const QString &description)
+{
+    Q_D(ZclCommand);
+    d->m_description = description;
+}
+
+bool ZclCommand::isProfileWide() const
+{
+    Q_D(const ZclCommand);
     return d->m_isProfileWide;
 }
 
@@ -2330,14 +2895,32 @@ ZclClusterPrivate::ZclClusterPrivate() :
 
 }
 
+ZclClusterPrivate::ZclClusterPrivate(const ZclClusterPrivate &other) :
+    id(other.id),
+    oppositeId(other.oppositeId),
+    manufacturerCode(other.manufacturerCode),
+    name(other.name),
+    description(other.description),
+    isZcl(other.isZcl),
+    isServer(other.isServer),
+    attributes(other.attributes),
+    attributeSets(other.attributeSets),
+    commands(other.commands),
+    commandIndex(other.commandIndex),
+    commandIndexValid(other.commandIndexValid)
+{
+
+}
+
 ZclCluster::ZclCluster() :
     d_ptr(new ZclClusterPrivate)
 {
 }
 
 ZclCluster::ZclCluster(const ZclCluster &other)
-    : d_ptr(new ZclClusterPrivate(*other.d_ptr))
+    : d_ptr(other.d_ptr)
 {
+    d_ptr->ref.fetch_add(1, std::memory_order_relaxed);
 }
 
 ZclCluster::ZclCluster(uint16_t id, const QString &name, const QString &description) :
@@ -2365,21 +2948,43 @@ ZclCluster &ZclCluster::operator= (const ZclCluster &other)
     }
 
     DBG_Assert(other.d_ptr != 0);
-    *this->d_ptr = *other.d_ptr;
+    other.d_ptr->ref.fetch_add(1, std::memory_order_relaxed);
+    if (d_ptr->ref.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete d_ptr;
+    }
+    d_ptr = other.d_ptr;
     return *this;
 }
 
 ZclCluster::~ZclCluster()
 {
-    delete d_ptr;
+    if (d_ptr && d_ptr->ref.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete d_ptr;
+    }
     d_ptr = 0;
 }
 
-uint16_t ZclCluster::id() const
+/*! Makes a private copy of shared cluster data before it is modified. */
+void ZclCluster::detach()
 {
-    return d_ptr->id;
-}
-
+    if (d_ptr->ref.load(std::memory_order_acquire) != 1)
+    {
+        ZclClusterPrivate *x = new ZclClusterPrivate(*d_ptr);
+        if (d_ptr->ref.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete d_ptr;
+        }
+        d_ptr = x;
+    }
+}
+
+uint16_t ZclCluster::id() const
+{
+    return d_ptr->id;
+}
+
 ZclClusterId_t ZclCluster::id_t() const
 {
     Q_D(const ZclCluster);
@@ -2388,6 +2993,7 @@ ZclClusterId_t ZclCluster::id_t() const
 
 void ZclCluster::setId(uint16_t id)
 {
+    detach();
     d_ptr->id = id;
 }
 
@@ -2398,6 +3004,7 @@ uint16_t ZclCluster::oppositeId() const
 
 void ZclCluster::setOppositeId(uint16_t id)
 {
+    detach();
     d_ptr->oppositeId = id;
 }
 
@@ -2413,11 +3020,13 @@ ManufacturerCode_t ZclCluster::manufacturerCode_t() const
 
 void ZclCluster::setManufacturerCode(uint16_t manufacturerCode)
 {
+    detach();
     d_ptr->manufacturerCode = manufacturerCode;
 }
 
 void ZclCluster::setManufacturerCode(ManufacturerCode_t manufacturerCode)
 {
+    detach();
     d_ptr->manufacturerCode = static_cast<quint16>(manufacturerCode);
 }
 
@@ -2433,6 +3042,7 @@ const QString &ZclCluster::description() const
 
 void ZclCluster::setDescription(const QString &description)
 {
+    detach();
     d_ptr->description = description;
 }
 
@@ -2448,6 +3058,7 @@ bool ZclCluster::isZcl() const
 
 void ZclCluster::setIsZcl(bool isZcl)
 {
+    detach();
     d_ptr->isZcl = isZcl;
 }
 
@@ -2463,7 +3074,9 @@ bool ZclCluster::isClient() const
 
 void ZclCluster::setIsServer(bool isServer)
 {
+    detach();
     d_ptr->isServer = isServer;
+    d_ptr->commandIndexValid = false;
 }
 
 bool ZclCluster::readCommand(const deCONZ::ApsDataIndication &ind)
@@ -2487,6 +3100,7 @@ bool ZclCluster::readCommand(const deCONZ::ApsDataIndication &ind)
 
 std::vector<ZclAttribute> &ZclCluster::attributes()
 {
+    detach();
     return d_ptr->attributes;
 }
 
@@ -2497,6 +3111,7 @@ const std::vector<ZclAttribute> &ZclCluster::attributes() const
 
 std::vector<ZclAttributeSet> &ZclCluster::attributeSets()
 {
+    detach();
     return d_ptr->attributeSets;
 }
 
@@ -2507,6 +3122,8 @@ const std::vector<ZclAttributeSet> &ZclCluster::attributeSets() const
 
 std::vector<ZclCommand> &ZclCluster::commands()
 {
+    detach();
+    d_ptr->commandIndexValid = false;
     return d_ptr->commands;
 }
 
@@ -2515,6 +3132,73 @@ const std::vector<ZclCommand> &ZclCluster::commands() const
     return d_ptr->commands;
 }
 
+static unsigned zclDecodeValue(ZclAttributeRecord &rec, const uint8_t *data, unsigned size);
+
+#define ZCL_CMD_KEY_S2C 0x100 // frame direction server to client
+#define ZCL_CMD_KEY_ANY 0x200 // entry for any manufacturer code
+
+static quint32 commandKey(uint8_t commandId, bool serverToClient, uint16_t mfcode)
+{
+    return quint32(mfcode) << 16 | (serverToClient ? ZCL_CMD_KEY_S2C : 0) | commandId;
+}
+
+int ZclCluster::commandIndex(uint8_t commandId, bool serverToClient, uint16_t mfcode) const
+{
+    const ZclClusterPrivate *d = d_ptr;
+
+    if (!d->commandIndexValid)
+    {
+        d->commandIndex.clear();
+
+        // the first match wins, same as in the former linear search
+        for (size_t n = 0; n < d->commands.size(); n++)
+        {
+            const ZclCommand &cmd = d->commands[n];
+
+            for (const bool s2c : { false, true })
+            {
+                const bool match = d->isServer ? (s2c ? cmd.directionSend() : cmd.directionReceived())
+                                               : (s2c ? cmd.directionReceived() : cmd.directionSend());
+                if (!match)
+                {
+                    continue;
+                }
+
+                const quint32 key = commandKey(cmd.id(), s2c, cmd.manufacturerId());
+                const quint32 anyKey = commandKey(cmd.id(), s2c, 0) | ZCL_CMD_KEY_ANY;
+
+                if (!d->commandIndex.contains(key)) { d->commandIndex.insert(key, int(n)); }
+                if (!d->commandIndex.contains(anyKey)) { d->commandIndex.insert(anyKey, int(n)); }
+            }
+        }
+
+        d->commandIndexValid = true;
+    }
+
+    auto i = d->commandIndex.constFind(commandKey(commandId, serverToClient, mfcode));
+
+    if (i == d->commandIndex.cend())
+    {
+        i = d->commandIndex.constFind(commandKey(commandId, serverToClient, 0) | ZCL_CMD_KEY_ANY);
+    }
+
+    return i != d->commandIndex.cend() ? i.value() : -1;
+}
+
+int ZclCluster::commandIndex(const ZclFrame &zclFrame) const
+{
+    const bool s2c = (zclFrame.frameControl() & ZclFCDirectionServerToClient) != 0;
+    const uint16_t mfcode = (zclFrame.frameControl() & ZclFCManufacturerSpecific) ? zclFrame.manufacturerCode() : 0;
+
+    return commandIndex(zclFrame.commandId(), s2c, mfcode);
+}
+
+int ZclCluster::commandIndex(const ZclFrameView &zclFrame) const
+{
+    const bool s2c = (zclFrame.frameControl() & ZclFCDirectionServerToClient) != 0;
+    return commandIndex(zclFrame.commandId(), s2c, zclFrame.manufacturerCode());
+}
+
 bool ZclCluster::readCommand(const ZclFrame &zclFrame)
 {
     if (!isZcl())
@@ -2522,47 +3206,95 @@ bool ZclCluster::readCommand(const ZclFrame &zclFrame)
         return false;
     }
 
-    std::vector<ZclCommand>::iterator i = commands().begin();
-    std::vector<ZclCommand>::iterator end = commands().end();
+    detach(); // before the lookup, the index is copied along
+
+    const int idx = commandIndex(zclFrame);
+    if (idx < 0)
+    {
+        return false;
+    }
+
     QDataStream stream(zclFrame.payload());
     stream.setByteOrder(QDataStream::LittleEndian);
 
-    for (; i != end; ++i)
+    // not via commands(), only parameter values change and the index stays valid
+    return d_ptr->commands[size_t(idx)].readFromStream(stream);
+}
+
+/*! Decodes the parameters of \p cmd from \p data of \p size bytes into \p params. */
+static bool decodeCommandParameters(const ZclCommand &cmd, const uint8_t *data, unsigned size, ZclCommandParameters &params)
+{
+    unsigned pos = 0;
+
+    params.command = &cmd;
+
+    for (const ZclAttribute &param : cmd.parameters())
     {
-        if (i->id() != zclFrame.commandId())
+        if (params.count == ZclCommandParameters::MaxParameters)
         {
-            continue;
+            return false;
         }
 
-        if (isServer())
-        {
-            if (i->directionReceived() && ((zclFrame.frameControl() & ZclFCDirectionServerToClient) == 0))
-            {
-                return i->readFromStream(stream);
-            }
-            else if (i->directionSend() && (zclFrame.frameControl() & ZclFCDirectionServerToClient))
-            {
-                return i->readFromStream(stream);
-            }
-        }
-        else if (isClient())
+        ZclAttributeRecord &rec = params.parameters[params.count];
+        rec.id = param.id();
+        rec.dataType = param.dataType();
+        rec.status = 0x00;
+
+        const unsigned len = zclDecodeValue(rec, data + pos, size - pos);
+        if (len == 0)
         {
-            if (i->directionReceived() && (zclFrame.frameControl() & ZclFCDirectionServerToClient))
-            {
-                return i->readFromStream(stream);
-            }
-            else if (i->directionSend() && ((zclFrame.frameControl() & ZclFCDirectionServerToClient) == 0))
-            {
-                return i->readFromStream(stream);
-            }
+            return false;
         }
+
+        pos += len;
+        params.count++;
     }
 
-    return false;
+    return true;
+}
+
+bool ZclCluster::readCommand(const ZclFrame &zclFrame, ZclCommandParameters &params) const
+{
+    params.command = nullptr;
+    params.count = 0;
+
+    if (!isZcl())
+    {
+        return false;
+    }
+
+    const int idx = commandIndex(zclFrame);
+    if (idx < 0)
+    {
+        return false;
+    }
+
+    const QByteArray &payload = zclFrame.payload();
+    return decodeCommandParameters(d_ptr->commands[size_t(idx)], reinterpret_cast<const uint8_t*>(payload.constData()),
+                                   unsigned(payload.size()), params);
+}
+
+bool ZclCluster::readCommand(const ZclFrameView &zclFrame, ZclCommandParameters &params) const
+{
+    params.command = nullptr;
+    params.count = 0;
+
+    if (!isZcl() || !zclFrame.isValid())
+    {
+        return false;
+    }
+
+    const int idx = commandIndex(zclFrame);
+    if (idx < 0)
+    {
+        return false;
+    }
+
+    return decodeCommandParameters(d_ptr->commands[size_t(idx)], zclFrame.payload(), zclFrame.payloadSize(), params);
 }
 
 ZclFrame::ZclFrame() :
-    d_ptr(MEM_AllocItem<ZclFramePrivate>(&zclMemPriv->mem))
+    d_ptr(zclAllocPrivate<ZclFramePrivate>())
 {
     if (d_ptr->payload.size() > 0)
     {
@@ -2579,7 +3311,7 @@ ZclFrame::ZclFrame() :
 }
 
 ZclFrame::ZclFrame(const ZclFrame &other) :
-    d_ptr(MEM_AllocItem<ZclFramePrivate>(&zclMemPriv->mem))
+    d_ptr(zclAllocPrivate<ZclFramePrivate>())
 {
     *d_ptr = *other.d_ptr;
 }
@@ -2599,7 +3331,7 @@ ZclFrame &ZclFrame::operator=(const ZclFrame &other)
 
 ZclFrame::~ZclFrame()
 {
-    MEM_DeallocItem<ZclFramePrivate>(d_ptr, &zclMemPriv->mem);
+    zclDeallocPrivate(d_ptr);
     d_ptr = nullptr;
 }
 
@@ -2717,6 +3449,39 @@ void ZclFrame::writeToStream(QDataStream &stream)
     }
 }
 
+int ZclFrame::writeToBuffer(uint8_t *data, unsigned size) const
+{
+    Q_D(const ZclFrame);
+    const bool mfSpecific = (d->frameControl & ZclFCManufacturerSpecific) != 0;
+    const unsigned len = (mfSpecific ? 5 : 3) + unsigned(d->payload.size());
+
+    if (!data)
+    {
+        return int(len);
+    }
+
+    if (len > size)
+    {
+        return 0;
+    }
+
+    uint8_t *p = data;
+    *p++ = d->frameControl;
+    if (mfSpecific)
+    {
+        p = put_u16_le(p, &d->manufacturerCode);
+    }
+    *p++ = d->seqNumber;
+    *p++ = d->commandId;
+
+    if (!d->payload.isEmpty())
+    {
+        memcpy(p, d->payload.constData(), size_t(d->payload.size()));
+    }
+
+    return int(len);
+}
+
 void ZclFrame::readFromStream(QDataStream &stream)
 {
     quint8 u8;
@@ -2750,6 +3515,55 @@ void ZclFrame::readFromStream(QDataStream &stream)
     }
 }
 
+ZclFrameView::ZclFrameView(const uint8_t *data, unsigned size)
+{
+    if (!data || size < 3)
+    {
+        return;
+    }
+
+    unsigned pos = 0;
+    m_frameControl = data[pos++];
+
+    if (m_frameControl & ZclFCManufacturerSpecific)
+    {
+        if (size < 5)
+        {
+            return;
+        }
+        m_manufacturerCode = uint16_t(data[pos] | data[pos + 1] << 8);
+        pos += 2;
+    }
+
+    m_seqNumber = data[pos++];
+    m_commandId = data[pos++];
+    m_payload = data + pos;
+    m_payloadSize = size - pos;
+}
+
+ZclFrameView::ZclFrameView(const ApsDataIndication &ind) :
+    ZclFrameView(reinterpret_cast<const uint8_t*>(ind.asdu().constData()), unsigned(ind.asdu().size()))
+{
+}
+
+ZclFrame ZclFrameView::toFrame() const
+{
+    ZclFrame zclFrame;
+
+    if (isValid())
+    {
+        ZclFramePrivate *d = zclFrame.d_ptr;
+        d->valid = 1; // same as after readFromStream()
+        d->frameControl = m_frameControl;
+        d->manufacturerCode = m_manufacturerCode;
+        d->seqNumber = m_seqNumber;
+        d->commandId = m_commandId;
+        d->payload.append(reinterpret_cast<const char*>(m_payload), int(m_payloadSize));
+    }
+
+    return zclFrame;
+}
+
 bool ZclFrame::isClusterCommand() const
 {
     Q_D(const ZclFrame);
@@ -2943,6 +3757,8 @@ ZclDataBase::ZclDataBase() :
     m_unknownCluster(0xFFFF, "unknown", "unkown cluster"),
     m_unknownDataType(0x00, "No Data", "-", 0, '-')
 {
+    m_dataTypeIndex.fill(-1);
+
 #ifdef PL_WINDOWS
     m_iconPath = QString("icons") + QDir::separator();
 #else
@@ -2952,13 +3768,37 @@ ZclDataBase::ZclDataBase() :
     m_iconPath = dir.absolutePath() + "/";
 #endif
     //m_iconPath(QString("../share/deCONZ/icons") + QDir::separator())
+    m_snapshot = std::make_shared<const ZclDataBaseSnapshot>();
     // singleton
     DBG_Assert(_zclDB == 0);
 }
 
+/*! Creates a partial database for parallel loading, see zcl_parallel.cpp.
+
+    Data types and enumerations of \p base are copied since attributes refer
+    to them by name, domains and profiles start empty.
+ */
+ZclDataBase::ZclDataBase(const ZclDataBase *base) :
+    m_enums(base->m_enums),
+    m_unknownCluster(0xFFFF, "unknown", "unkown cluster"),
+    m_unknownDataType(0x00, "No Data", "-", 0, '-'),
+    m_dataTypes(base->m_dataTypes),
+    m_iconPath(base->m_iconPath),
+    m_lazyLoading(base->m_lazyLoading),
+    m_internStrings(base->m_internStrings),
+    m_headless(base->m_headless),
+    m_internedStrings(base->m_internedStrings)
+{
+    m_snapshot = std::make_shared<const ZclDataBaseSnapshot>();
+    buildIndex();
+}
+
 ZclDataBase::~ZclDataBase()
 {
-    _zclDB = 0;
+    if (_zclDB == this)
+    {
+        _zclDB = nullptr;
+    }
 }
 
 static_assert (sizeof deCONZ::ZclNoData == 1, "Assumed enum sizeof deCONZ::ZclNoData is 1");
@@ -2970,7 +3810,207 @@ static_assert (sizeof deCONZ::ZclClusterId_t(quint16(1)) == 2, "Assumed enum siz
 static_assert (sizeof deCONZ::ManufacturerCode_t(quint16(1)) == 2, "Assumed enum sizeof ManufacturerCode_t(quint16(1)) is 2");
 static_assert (sizeof deCONZ::ZclCommandId_t(quint8(1)) == 1, "Assumed enum sizeof ZclCommandId_t(quint8(1)) is 1");
 
+static quint32 clusterHash(quint16 clusterId, quint16 mfcode)
+{
+    quint32 hash = 0;
+    if (clusterId >= 0xfc00) {
+        hash |= mfcode;
+        hash <<= 16;
+    }
+    hash |= clusterId;
+    return hash;
+}
+
+/*! State of a single ZCLDB file parse run. */
+struct ZclLoadContext
+{
+    /*! Converts a QXmlStreamReader character offset into a byte offset of the UTF-8 \c data.
+        Offsets must be passed in increasing order.
+     */
+    int byteOffset(qint64 charOffset)
+    {
+        while (charPos < charOffset && bytePos < data.size())
+        {
+            const uchar c = static_cast<uchar>(data.at(bytePos));
+            int n = 1;
+            if      (c >= 0xF0) { n = 4; }
+            else if (c >= 0xE0) { n = 3; }
+            else if (c >= 0xC0) { n = 2; }
+            bytePos += n;
+            charPos += n == 4 ? 2 : 1; // UTF-16 surrogate pair
+        }
+        return bytePos;
+    }
+
+    QString path;
+    QByteArray data; //!< File content, only set in lazy loading mode.
+    qint64 charPos = 0;
+    int bytePos = 0;
+    ZclDomain *fragment = nullptr; //!< Set when materializing a single <cluster> element.
+};
+
 void ZclDataBase::load(const QString &dbfile)
+{
+    ZclLoadContext ctx;
+    QFile file(dbfile);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        DBG_Printf(DBG_ZCLDB, "%s can't read %s\n", Q_FUNC_INFO, qPrintable(dbfile));
+        return;
+    }
+
+    DBG_Printf(DBG_ZCLDB, "%s reading file %s\n", Q_FUNC_INFO, qPrintable(dbfile));
+
+    if (m_lazyLoading)
+    {
+        ctx.path = dbfile;
+        ctx.data = file.readAll();
+        if (ctx.data.startsWith("\xEF\xBB\xBF"))
+        {
+            ctx.bytePos = 3; // UTF-8 BOM isn't counted as character
+        }
+
+        QXmlStreamReader xml(ctx.data);
+        parse(xml, ctx);
+    }
+    else
+    {
+        QXmlStreamReader xml(&file);
+        parse(xml, ctx);
+    }
+
+    buildIndex();
+}
+
+/*! Records the <cluster> element at the current \p xml position in the lazy index of \p domain.
+
+    Only the byte range of the element is stored, it is parsed by materialize()
+    when the cluster is requested the first time.
+
+    \returns true if the element was recorded and skipped.
+ */
+bool ZclDataBase::recordLazyCluster(QXmlStreamReader &xml, ZclLoadContext &ctx, ZclDomain &domain, quint32 hash)
+{
+    const int tagEnd = ctx.byteOffset(xml.characterOffset());
+    const int start = ctx.data.lastIndexOf("<cluster", tagEnd);
+
+    // verify the offset really points to the current start element
+    if (start < 0 || tagEnd <= start || ctx.data.indexOf('>', start) != tagEnd - 1)
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCL line: %d, can't index cluster, parse now\n", (int)xml.lineNumber());
+        return false;
+    }
+
+    xml.skipCurrentElement();
+
+    int end = ctx.byteOffset(xml.characterOffset());
+    if (end <= start || ctx.data.at(end - 1) != '>')
+    {
+        end = ctx.data.size();
+    }
+
+    ZclLazyCluster lc;
+    lc.path = ctx.path;
+    lc.offset = start;
+    lc.length = end - start;
+    lc.hash = hash;
+    lc.useZcl = domain.useZcl();
+    lc.digest.resize(U_SHA256_HASH_SIZE);
+    U_Sha256(ctx.data.constData() + start, unsigned(lc.length), reinterpret_cast<unsigned char*>(lc.digest.data()));
+
+    domain.m_lazyIndex.insert(hash, int(m_lazyClusters.size()));
+    m_lazyClusters.push_back(lc);
+
+    return true;
+}
+
+/*! Moves a lazy indexed cluster of \p domain into its regular cluster lists.
+
+    Used when a cluster is defined again, so that the later definition
+    updates the former one like in eager parsing.
+ */
+void ZclDataBase::resolveLazyCluster(ZclDomain &domain, quint32 hash)
+{
+    const auto i = domain.m_lazyIndex.constFind(hash);
+    if (i == domain.m_lazyIndex.cend())
+    {
+        return;
+    }
+
+    const ZclLazyCluster &lc = materialize(i.value());
+    domain.m_lazyIndex.remove(hash);
+
+    if (lc.hasServer)
+    {
+        domain.m_inClusters.insert(hash, lc.server);
+    }
+
+    if (lc.hasClient)
+    {
+        domain.m_outClusters.insert(hash, lc.client);
+    }
+}
+
+/*! Parses the <cluster> element of a lazy index entry on first use. */
+const ZclLazyCluster &ZclDataBase::materialize(int index)
+{
+    ZclLazyCluster &lc = m_lazyClusters[size_t(index)];
+
+    if (lc.materialized)
+    {
+        return lc;
+    }
+
+    lc.materialized = true;
+
+    QFile file(lc.path);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(lc.offset))
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCL can't read cluster 0x%08X from %s\n", lc.hash, qPrintable(lc.path));
+        return lc;
+    }
+
+    ZclLoadContext ctx;
+    ZclDomain domain;
+    domain.setUseZcl(lc.useZcl);
+    ctx.fragment = &domain;
+
+    QXmlStreamReader xml(file.read(lc.length));
+    parse(xml, ctx);
+
+    const auto srv = domain.m_inClusters.constFind(lc.hash);
+    if (srv != domain.m_inClusters.cend())
+    {
+        lc.server = srv.value();
+        lc.hasServer = true;
+    }
+
+    const auto cli = domain.m_outClusters.constFind(lc.hash);
+    if (cli != domain.m_outClusters.cend())
+    {
+        lc.client = cli.value();
+        lc.hasClient = true;
+    }
+
+    if (!lc.hasServer && !lc.hasClient)
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCL failed to materialize cluster 0x%08X from %s, file changed?\n", lc.hash, qPrintable(lc.path));
+    }
+
+    return lc;
+}
+
+void ZclDataBase::setLazyLoading(bool enabled)
+{
+    m_lazyLoading = enabled;
+}
+
+bool ZclDataBase::lazyLoading() const
+{
+    return m_lazyLoading;
+}
+
+void ZclDataBase::parse(QXmlStreamReader &xml, ZclLoadContext &ctx)
 {
     QString name;
     QString descr;
@@ -2990,17 +4030,12 @@ void ZclDataBase::load(const QString &dbfile)
     QStringList attrValueNames;
     std::vector<int> attrValuePos;
 
-    QFile file(dbfile);
-
-    if (!file.open(QIODevice::ReadOnly)) {
-        DBG_Printf(DBG_ZCLDB, "%s can't read %s\n", Q_FUNC_INFO, qPrintable(dbfile));
-        return;
+    if (ctx.fragment)
+    {
+        domain = *ctx.fragment;
+        curSection.push(InDomain);
     }
 
-    DBG_Printf(DBG_ZCLDB, "%s reading file %s\n", Q_FUNC_INFO, qPrintable(dbfile));
-
-    QXmlStreamReader xml(&file);
-
     while (!xml.atEnd())
     {
             xml.readNext();
@@ -3037,6 +4072,7 @@ void ZclDataBase::load(const QString &dbfile)
                         // check for properitary clusters
                         if (xmlAttributes.hasAttribute(QLatin1String("useZcl")))
                         {
+                            m_useZclDomains.insert(name.toLower());
                             if (xmlAttributes.value(QLatin1String("useZcl")) == QLatin1String("false"))
                             {
                                 domain.setUseZcl(false);
@@ -3112,14 +4148,17 @@ void ZclDataBase::load(const QString &dbfile)
                         profile.setId(u16id);
                         profile.setName(name);
                         profile.setDescription(descr);
-                        if (!icon.startsWith(QDir::separator()))
+                        if (!m_headless)
                         {
-                            icon.prepend(m_iconPath);
-                        }
-
-                        if (QFile::exists(icon))
-                        {
-                            profile.setIcon(QIcon(icon));
+                            if (!icon.startsWith(QDir::separator()))
+                            {
+                                icon.prepend(m_iconPath);
+                            }
+
+                            if (QFile::exists(icon))
+                            {
+                                profile.setIconPath(icon); // loaded on first ZclProfile::icon() call
+                            }
                         }
                     }
                     else
@@ -3187,16 +4226,24 @@ void ZclDataBase::load(const QString &dbfile)
                         }
 
                         curSection.push(InDevice);
-                        if (!icon.startsWith(QDir::separator()))
+                        if (m_headless)
                         {
-                            icon.prepend(m_iconPath);
+                            icon.clear();
                         }
-                        QIcon devIcon;
-                        if (QFile::exists(icon))
+                        else
                         {
-                            devIcon = QIcon(icon);
+                            if (!icon.startsWith(QDir::separator()))
+                            {
+                                icon.prepend(m_iconPath);
+                            }
+
+                            if (!QFile::exists(icon))
+                            {
+                                icon.clear();
+                            }
                         }
-                        device = ZclDevice(u16id, name, descr, devIcon);
+                        device = ZclDevice(u16id, name, descr);
+                        device.setIconPath(icon); // loaded on first ZclDevice::icon() call
                     }
                     else
                     {
@@ -3213,10 +4260,26 @@ void ZclDataBase::load(const QString &dbfile)
                     if (ok && !xmlAttributes.hasAttribute(QLatin1String("id"))) ok = false;
                     if (ok && !xmlAttributes.hasAttribute(QLatin1String("name"))) ok = false;
 
+                    if (ok && !ctx.fragment)
+                    {
+                        u16id = xmlAttributes.value(QLatin1String("id")).toUShort(0, 16);
+                        const quint16 mfcode = xmlAttributes.value(QLatin1String("mfcode")).toUShort(0, 16);
+                        const quint32 hash = clusterHash(u16id, mfcode);
+
+                        resolveLazyCluster(domain, hash);
+
+                        if (m_lazyLoading && !ctx.data.isEmpty() &&
+                            !domain.m_inClusters.contains(hash) && !domain.m_outClusters.contains(hash) &&
+                            recordLazyCluster(xml, ctx, domain, hash))
+                        {
+                            continue;
+                        }
+                    }
+
                     if (ok)
                     {
                         u16id = xmlAttributes.value(QLatin1String("id")).toUShort(0, 16);
-                        name = xmlAttributes.value(QLatin1String("name")).toString();
+                        name = intern(xmlAttributes.value(QLatin1String("name")).toString());
                         cluster = ZclCluster(u16id, name);
                         cluster.setIsZcl(domain.useZcl());
                         // check if opposite cluster id differs
@@ -3257,7 +4320,7 @@ void ZclDataBase::load(const QString &dbfile)
                         bool required = false;
 
                         u8id = (uint8_t)xmlAttributes.value(QLatin1String("id")).toUShort(0, 16);
-                        name = xmlAttributes.value(QLatin1String("name")).toString();
+                        name = intern(xmlAttributes.value(QLatin1String("name")).toString());
 
                         if (xmlAttributes.value(QLatin1String("dir")) == QLatin1String("recv"))
                         {
@@ -3388,7 +4451,7 @@ void ZclDataBase::load(const QString &dbfile)
                             uint16_t type = 0;
 
                             u16id = xmlAttributes.value(QLatin1String("id")).toUShort(0, 16);
-                            name = xmlAttributes.value(QLatin1String("name")).toString();
+                            name = intern(xmlAttributes.value(QLatin1String("name")).toString());
                             const auto typeStr = xmlAttributes.value(QLatin1String("type"));
                             if (!typeStr.isEmpty())
                             {
@@ -3661,7 +4724,7 @@ void ZclDataBase::load(const QString &dbfile)
 
                         if (ok)
                         {
-                            const QString name = xmlAttributes.value(QLatin1String("name")).toString();
+                            const QString name = intern(xmlAttributes.value(QLatin1String("name")).toString());
                             uint pos = xmlAttributes.value(QLatin1String("value")).toUInt(&ok, 0);
 
                             if (!ok)
@@ -3696,7 +4759,7 @@ void ZclDataBase::load(const QString &dbfile)
 
                         if (ok)
                         {
-                            QString name = xmlAttributes.value(QLatin1String("name")).toString();
+                            QString name = intern(xmlAttributes.value(QLatin1String("name")).toString());
                             QString value = xmlAttributes.value(QLatin1String("value")).toString();
 
                             uint pos = value.toUInt(&ok, 0);
@@ -3741,15 +4804,15 @@ void ZclDataBase::load(const QString &dbfile)
                     switch (curSection.top())
                     {
                     case InCluster:
-                        cluster.setDescription(xml.readElementText());
+                        cluster.setDescription(intern(xml.readElementText()));
                         break;
 
                     case InAttribute:
-                        attr.setDescription(xml.readElementText());
+                        attr.setDescription(intern(xml.readElementText()));
                         break;
 
                     case InCommand:
-                        command.setDescription(xml.readElementText());
+                        command.setDescription(intern(xml.readElementText()));
                         break;
 
                     case InDomain:
@@ -3926,6 +4989,11 @@ void ZclDataBase::load(const QString &dbfile)
                         DBG_Printf(DBG_ZCLDB, "ZCL line: %d, </cluster> while not InCluster\n", (int)xml.lineNumber());
                     }
                     curSection.pop();
+
+                    if (ctx.fragment)
+                    {
+                        break; // done with single cluster
+                    }
                 }
                 else if (xmlName == QLatin1String("server"))
                 {
@@ -3999,8 +5067,9 @@ void ZclDataBase::load(const QString &dbfile)
                     {
                         if (!attrValueNames.isEmpty())
                         {
-                            attr.d_ptr->m_valueNames = attrValueNames;
-                            attr.d_ptr->m_valuePos = attrValuePos;
+                            ZclAttributeSchema *schema = attr.d_ptr->m_schema.detach();
+                            schema->m_valueNames = attrValueNames;
+                            schema->m_valuePos = attrValuePos;
                         }
 
                         curSection.pop();
@@ -4050,6 +5119,11 @@ void ZclDataBase::load(const QString &dbfile)
                 }
             }
     }
+
+    if (ctx.fragment)
+    {
+        *ctx.fragment = domain;
+    }
 }
 
 void ZclDataBase::initDbFile(const QString &zclFile)
@@ -4079,6 +5153,7 @@ void ZclDataBase::initDbFile(const QString &zclFile)
     if (QFile::exists(zclFile) && found == 0)
     {
         QFile::remove(zclFile); // could happen when installation moves
+        QFile::remove(zclFile + QLatin1String(".cache"));
     }
 
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text) || (file.size() <= 0))
@@ -4146,206 +5221,1008 @@ void ZclDataBase::initDbFile(const QString &zclFile)
             QDir dir(qApp->applicationDirPath());
             dir.cdUp();
 
-            QString gen = dir.absolutePath() + "/Resources/zcl/general.xml";
+            QString gen = dir.absolutePath() + "/Resources/zcl/general.xml";
+
+            if (QFile::exists(gen))
+            {
+                DBG_Printf(DBG_INFO, "ZCLDB add file %s \n", qPrintable(gen));
+                stream << gen;
+                stream << "\n";
+            }
+#endif // __APPLE__
+        }
+        else
+        {
+            DBG_Printf(DBG_ERROR, "ZCLDB failed to create %s: %s\n", qPrintable(zclFile), qPrintable(file.errorString()));
+        }
+    }
+}
+
+/*! Returns the ZCLDB files listed in \p zclFile in load order. */
+QStringList ZclDataBase::dbFiles(const QString &zclFile) const
+{
+    QFile file(zclFile);
+    QStringList files;
+
+#ifdef PL_UNIX
+    // TODO(mpi): this fails on Apple.
+    QString generalXml("/usr/share/deCONZ/zcl/general.xml");
+    if (QFile::exists(generalXml))
+    {
+        files.push_back(generalXml);
+    }
+#else
+    QString generalXml("");
+#endif // PL_UNIX
+
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        QTextStream stream(&file);
+
+        while (!stream.atEnd())
+        {
+            QString line = stream.readLine(1024).trimmed();
+            if (line.endsWith(".xml") && line != generalXml)
+            {
+                files.push_back(line);
+            }
+        }
+    }
+    else
+    {
+        DBG_Printf(DBG_ERROR, "ZCLDB failed to open %s:%s\n", qPrintable(zclFile), qPrintable(file.errorString()));
+    }
+
+    return files;
+}
+
+/*! Loads \p files into the cleared database, from the binary cache if \p key matches.
+    \param hashes SHA-256 of each file, see loadParts()
+ */
+void ZclDataBase::loadFiles(const QStringList &files, const QString &cacheFile, const QByteArray &key, const std::vector<QByteArray> &hashes)
+{
+    m_sourceKey = key;
+
+    // the binary cache holds fully parsed clusters, not used in lazy loading mode
+    if (!m_lazyLoading && !key.isEmpty() && loadCache(cacheFile, key))
+    {
+        return;
+    }
+
+    loadParts(files, hashes);
+
+    if (!m_lazyLoading && !key.isEmpty())
+    {
+        saveCache(cacheFile, key);
+    }
+}
+
+/*! Reloads all ZCLDB files listed in \p zclFile.
+
+    The parsed database is stored in a binary cache file next to \p zclFile.
+    As long as none of the XML source files change the cache is loaded
+    instead of parsing the XML files.
+ */
+void ZclDataBase::reloadAll(const QString &zclFile)
+{
+    clear();
+
+    std::vector<QByteArray> hashes;
+    const QStringList files = dbFiles(zclFile);
+    const QByteArray key = cacheKey(files, &hashes);
+    loadFiles(files, zclFile + QLatin1String(".cache"), key, hashes);
+    publishSnapshot();
+}
+
+void ZclDataBase::clear()
+{
+    m_enums.clear();
+    m_dataTypes.clear();
+    m_domains.clear();
+    m_profiles.clear();
+    m_devices.clear();
+    m_clusterCache.clear();
+    m_lazyClusters.clear();
+    m_fileParts.clear();
+    m_internedStrings.clear();
+    m_sourceKey.clear();
+    m_useZclDomains.clear();
+    buildIndex();
+}
+
+void ZclDataBase::setParallelLoading(bool enabled)
+{
+    m_parallelLoading = enabled;
+}
+
+bool ZclDataBase::parallelLoading() const
+{
+    return m_parallelLoading;
+}
+
+void ZclDataBase::setHeadless(bool enabled)
+{
+    m_headless = enabled;
+}
+
+bool ZclDataBase::headless() const
+{
+    return m_headless;
+}
+
+void ZclDataBase::setInternStrings(bool enabled)
+{
+    m_internStrings = enabled;
+}
+
+bool ZclDataBase::internStrings() const
+{
+    return m_internStrings;
+}
+
+/*! Returns the shared instance of \p str if string interning is enabled.
+
+    The first QString instance is returned for all equal strings.
+    If interning is disabled \p str is returned.
+ */
+QString ZclDataBase::intern(const QString &str)
+{
+    if (!m_internStrings || str.isEmpty())
+    {
+        return str;
+    }
+
+    const auto i = m_internedStrings.constFind(str);
+    if (i != m_internedStrings.cend())
+    {
+        return *i;
+    }
+
+    m_internedStrings.insert(str);
+    return str;
+}
+
+/*! Rebuilds the lookup indexes of data types, enumerations and devices.
+    Needs to be called after these lists were modified.
+ */
+void ZclDataBase::buildIndex()
+{
+    m_dataTypeIndex.fill(-1);
+    m_dataTypeNameIndex.clear();
+    m_enumIndex.clear();
+    m_deviceIndex.clear();
+
+    // the first match wins, same as in the former linear searches
+    for (size_t i = 0; i < m_dataTypes.size(); i++)
+    {
+        const ZclDataType &dt = m_dataTypes[i];
+        if (m_dataTypeIndex[dt.id()] == -1)
+        {
+            m_dataTypeIndex[dt.id()] = int16_t(i);
+        }
+
+        if (!m_dataTypeNameIndex.contains(dt.shortname()))
+        {
+            m_dataTypeNameIndex.insert(dt.shortname(), int(i));
+        }
+    }
+
+    for (size_t i = 0; i < m_enums.size(); i++)
+    {
+        if (!m_enumIndex.contains(m_enums[i].id()))
+        {
+            m_enumIndex.insert(m_enums[i].id(), int(i));
+        }
+    }
+
+    for (size_t i = 0; i < m_devices.size(); i++)
+    {
+        const quint32 key = quint32(m_devices[i].profileId()) << 16 | m_devices[i].id();
+        if (!m_deviceIndex.contains(key))
+        {
+            m_deviceIndex.insert(key, int(i));
+        }
+    }
+}
+
+const Enumeration *ZclDataBase::enumeration(uint id) const
+{
+    const auto i = m_enumIndex.constFind(id);
+    if (i != m_enumIndex.cend())
+    {
+        return &m_enums[size_t(i.value())];
+    }
+
+    return nullptr;
+}
+
+#define ZCL_CLUSTER_CACHE_MAX 4096
+
+static quint64 clusterCacheKey(uint16_t profileId, uint16_t clusterId, quint16 mfcode, ZclClusterSide side)
+{
+    return (quint64(profileId) << 48) | (quint64(clusterId) << 32) | (quint64(mfcode) << 16) | quint64(side);
+}
+
+/*! Removes attributes and commands of other manufacturers from server cluster \p cl. */
+static void filterServerCluster(ZclCluster &cl, quint16 mfcode)
+{
+    // shares the data with the database, only copied when filtered
+    const auto &ccl = cl;
+    const ManufacturerCode_t _mfcode(mfcode);
+
+    const auto attrFilter = [_mfcode](const ZclAttribute &a) {
+        return a.manufacturerCode_t() == 0x0000_mfcode
+               || a.manufacturerCode_t() == _mfcode
+               || (a.manufacturerCode_t() == 0x115f_mfcode && _mfcode == 0x1037_mfcode) /* Xiaomi used both on the same device */;
+    };
+
+    if (!std::all_of(ccl.attributes().cbegin(), ccl.attributes().cend(), attrFilter)) // filtered
+    {
+        std::vector<ZclAttribute> attributes;
+        std::copy_if(ccl.attributes().cbegin(), ccl.attributes().cend(), std::back_inserter(attributes), attrFilter);
+        cl.attributes() = std::move(attributes);
+    }
+
+    const auto cmdFilter = [mfcode](const ZclCommand &a) {
+        return a.manufacturerId() == 0 || a.manufacturerId() == mfcode;
+    };
+
+    if (!std::all_of(ccl.commands().cbegin(), ccl.commands().cend(), cmdFilter)) // filtered
+    {
+        std::vector<ZclCommand> commands;
+        std::copy_if(ccl.commands().cbegin(), ccl.commands().cend(), std::back_inserter(commands), cmdFilter);
+        cl.commands() = std::move(commands);
+    }
+}
+
+/*! Removes attributes of other manufacturers from client cluster \p cl. */
+static void filterClientCluster(ZclCluster &cl, quint16 mfcode)
+{
+    // shares the data with the database, only copied when filtered
+    const auto &ccl = cl;
+
+    const auto attrFilter = [mfcode](const ZclAttribute &a) {
+        return a.manufacturerCode() == 0 || a.manufacturerCode() == mfcode;
+    };
+
+    if (!std::all_of(ccl.attributes().cbegin(), ccl.attributes().cend(), attrFilter)) // filtered
+    {
+        std::vector<ZclAttribute> attributes;
+        std::copy_if(ccl.attributes().cbegin(), ccl.attributes().cend(), std::back_inserter(attributes), attrFilter);
+        cl.attributes() = std::move(attributes);
+    }
+}
+
+ZclCluster ZclDataBase::inCluster(uint16_t profileId, uint16_t clusterId, quint16 mfcode)
+{
+    const quint64 key = clusterCacheKey(profileId, clusterId, mfcode, ServerCluster);
+    const auto cached = m_clusterCache.constFind(key);
+
+    if (cached != m_clusterCache.cend())
+    {
+        return cached.value();
+    }
+
+    if (m_clusterCache.size() >= ZCL_CLUSTER_CACHE_MAX)
+    {
+        m_clusterCache.clear();
+    }
+
+    if (m_profiles.contains(profileId))
+    {
+        const ManufacturerCode_t _mfcode(mfcode);
+        const ZclProfile &profile = m_profiles[profileId];
+
+        for (auto i = profile.domains().cbegin(); i != profile.domains().cend(); ++i)
+        {
+            quint32 hash = 0;
+            if (clusterId >= 0xfc00) {
+                hash |= static_cast<quint16>(_mfcode);
+                hash <<= 16;
+            }
+            hash |= clusterId;
+
+            ZclCluster cl;
+            const auto ci = i->inClusters().constFind(hash);
+            const auto li = i->m_lazyIndex.constFind(hash);
+
+            if (ci != i->inClusters().cend())
+            {
+                cl = ci.value();
+            }
+            else if (li != i->m_lazyIndex.cend() && materialize(li.value()).hasServer)
+            {
+                cl = m_lazyClusters[size_t(li.value())].server;
+            }
+            else
+            {
+                continue;
+            }
+
+            filterServerCluster(cl, mfcode);
+            m_clusterCache.insert(key, cl);
+            return cl;
+        }
+    }
+
+    ZclCluster cl(clusterId, QLatin1String("Unknown"));
+    m_clusterCache.insert(key, cl);
+    return cl;
+}
+
+// constant initialized, a C array can't be returned from a constexpr function in C++14
+#define ZCL_TRAITS_4(i) ZCL_MakeDataTypeTraits(i), ZCL_MakeDataTypeTraits(i + 1), ZCL_MakeDataTypeTraits(i + 2), ZCL_MakeDataTypeTraits(i + 3)
+#define ZCL_TRAITS_16(i) ZCL_TRAITS_4(i), ZCL_TRAITS_4(i + 4), ZCL_TRAITS_4(i + 8), ZCL_TRAITS_4(i + 12)
+#define ZCL_TRAITS_64(i) ZCL_TRAITS_16(i), ZCL_TRAITS_16(i + 16), ZCL_TRAITS_16(i + 32), ZCL_TRAITS_16(i + 48)
+
+const ZclDataTypeTraits ZCL_DataTypeTraitsTable[256] = {
+    ZCL_TRAITS_64(0), ZCL_TRAITS_64(64), ZCL_TRAITS_64(128), ZCL_TRAITS_64(192)
+};
+
+#undef ZCL_TRAITS_64
+#undef ZCL_TRAITS_16
+#undef ZCL_TRAITS_4
+
+/*! Returns the size of a attribute value including length prefixes, 0 if malformed or unsupported.
+    For strings \p offset is set to the length prefix size.
+ */
+static unsigned zclValueSize(uint8_t dataType, const uint8_t *data, unsigned size, unsigned *offset)
+{
+    const ZclDataTypeTraits ti = ZCL_DataTypeTraits(dataType);
+    *offset = 0;
+
+    if (ti.width != 0)
+    {
+        return ti.width <= size ? ti.width : 0;
+    }
+
+    unsigned len = 0;
+
+    switch (dataType)
+    {
+    case ZclOctedString:
+    case ZclCharacterString:
+        if (size < 1)
+        {
+            return 0;
+        }
+        *offset = 1;
+        len = data[0] == 0xff ? 0 : data[0]; // 0xff invalid value
+        break;
+
+    case ZclLongOctedString:
+    case ZclLongCharacterString:
+        if (size < 2)
+        {
+            return 0;
+        }
+        *offset = 2;
+        len = unsigned(data[0] | data[1] << 8);
+        len = len == 0xffff ? 0 : len;
+        break;
+
+    case ZclArray:
+    {
+        if (size < 3)
+        {
+            return 0;
+        }
+
+        const ZclDataTypeTraits sub = ZCL_DataTypeTraits(data[0]);
+        unsigned m = unsigned(data[1] | data[2] << 8);
+        m = m == 0xffff ? 0 : m;
+
+        if (m == 0)
+        {
+            return 3;
+        }
+
+        if (sub.width == 0) // arrays of variable size elements aren't supported
+        {
+            return 0;
+        }
+
+        len = 3 + m * sub.width;
+    }
+        break;
+
+    default:
+        return 0;
+    }
+
+    return (*offset + len <= size) ? *offset + len : 0;
+}
+
+/*! Decodes the value of \p rec with data type rec.dataType from \p data.
+    \returns number of consumed bytes, 0 if malformed or unsupported
+ */
+static unsigned zclDecodeValue(ZclAttributeRecord &rec, const uint8_t *data, unsigned size)
+{
+    const ZclDataTypeTraits ti = ZCL_DataTypeTraits(rec.dataType);
+    unsigned offset;
+    const unsigned len = zclValueSize(rec.dataType, data, size, &offset);
+
+    if (len == 0 || (ti.flags & ZclTypeValid) == 0)
+    {
+        return 0;
+    }
+
+    rec.numericValue.u64 = 0;
+    rec.data = &data[offset];
+    rec.size = uint16_t(len - offset);
+
+    if (ti.width == 1)
+    {
+        rec.numericValue.u8 = rec.data[0];
+    }
+    else if (ti.width == 2)
+    {
+        get_u16_le(rec.data, &rec.numericValue.u16);
+    }
+    else if (ti.width == 4)
+    {
+        get_u32_le(rec.data, &rec.numericValue.u32);
+    }
+    else if (ti.width == 8)
+    {
+        get_u64_le(rec.data, &rec.numericValue.u64);
+    }
+    else if (ti.width > 0 && ti.width < 8)
+    {
+        for (unsigned i = 0; i < ti.width; i++)
+        {
+            rec.numericValue.u64 |= uint64_t(rec.data[i]) << (8 * i);
+        }
+    }
+    else if (ti.width == 0)
+    {
+        rec.numericValue.u64 = rec.size; // length of strings and arrays
+    }
+
+    if (rec.dataType >= Zcl8BitInt && rec.dataType < Zcl64BitInt && (rec.data[ti.width - 1] & 0x80))
+    {
+        rec.numericValue.u64 |= ~uint64_t(0) << (8 * ti.width); // sign extend to 64-bit
+    }
+
+    if (rec.dataType == ZclBoolean)
+    {
+        rec.numericValue.u8 = (rec.numericValue.u8 == 1) ? 1 : 0;
+    }
+
+    return len;
+}
+
+unsigned ZCL_ParseAttributeRecords(uint8_t commandId, const uint8_t *payload, unsigned size, ZclAttributeRecord *records, unsigned maxRecords)
+{
+    if (!payload || !records)
+    {
+        return 0;
+    }
+
+    if (commandId != ZclReadAttributesResponseId && commandId != ZclReportAttributesId)
+    {
+        return 0;
+    }
+
+    unsigned n = 0;
+    unsigned pos = 0;
+
+    while (n < maxRecords && pos + 3 <= size)
+    {
+        ZclAttributeRecord &rec = records[n];
+        rec.numericValue.u64 = 0;
+        rec.data = nullptr;
+        rec.size = 0;
+        rec.dataType = ZclNoData;
+        rec.status = 0x00;
+        rec.id = uint16_t(payload[pos] | payload[pos + 1] << 8);
+        pos += 2;
+
+        if (commandId == ZclReadAttributesResponseId)
+        {
+            rec.status = payload[pos++];
+            if (rec.status != 0x00) // no data type and value
+            {
+                n++;
+                continue;
+            }
+
+            if (pos >= size)
+            {
+                break;
+            }
+        }
+
+        rec.dataType = payload[pos++];
+
+        const unsigned len = zclDecodeValue(rec, &payload[pos], size - pos);
+
+        if (len == 0)
+        {
+            DBG_Printf(DBG_ZCL, "ZCL attribute record 0x%04X datatype 0x%02X malformed or not supported\n", rec.id, rec.dataType);
+            break;
+        }
+
+        pos += len;
+        n++;
+    }
+
+    return n;
+}
+
+unsigned ZCL_ParseAttributeRecords(const ZclFrame &zclFrame, ZclAttributeRecord *records, unsigned maxRecords)
+{
+    if (!zclFrame.isProfileWideCommand())
+    {
+        return 0;
+    }
+
+    const QByteArray &payload = zclFrame.payload();
+    return ZCL_ParseAttributeRecords(zclFrame.commandId(), reinterpret_cast<const uint8_t*>(payload.constData()),
+                                     unsigned(payload.size()), records, maxRecords);
+}
+
+unsigned ZCL_ParseAttributeRecords(const ZclFrameView &zclFrame, ZclAttributeRecord *records, unsigned maxRecords)
+{
+    if (!zclFrame.isValid() || !zclFrame.isProfileWideCommand())
+    {
+        return 0;
+    }
+
+    return ZCL_ParseAttributeRecords(zclFrame.commandId(), zclFrame.payload(), zclFrame.payloadSize(), records, maxRecords);
+}
+
+unsigned ZCL_WriteAttributeRecords(const ZclFrame &zclFrame, const ZclAttribute *attributes, unsigned count, uint8_t *data, unsigned size)
+{
+    if (!zclFrame.isProfileWideCommand() || (count > 0 && !attributes))
+    {
+        return 0;
+    }
+
+    const uint8_t commandId = zclFrame.commandId();
+
+    switch (commandId)
+    {
+    case ZclReadAttributesId:
+    case ZclReadAttributesResponseId:
+    case ZclWriteAttributesId:
+    case ZclWriteAttributesUndividedId:
+    case ZclWriteAttributesNoResponseId:
+    case ZclConfigureReportingId:
+    case ZclReportAttributesId:
+        break;
+
+    default:
+        return 0;
+    }
+
+    // ZCL header without payload
+    const bool mfSpecific = (zclFrame.frameControl() & ZclFCManufacturerSpecific) != 0;
+    unsigned pos = mfSpecific ? 5 : 3;
+
+    if (data)
+    {
+        if (pos > size)
+        {
+            return 0;
+        }
+
+        uint8_t *p = data;
+        *p++ = zclFrame.frameControl();
+        if (mfSpecific)
+        {
+            const uint16_t mfcode = zclFrame.manufacturerCode();
+            p = put_u16_le(p, &mfcode);
+        }
+        *p++ = zclFrame.sequenceNumber();
+        *p++ = commandId;
+    }
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        const ZclAttribute &attr = attributes[i];
+        const uint16_t id = attr.id();
+        const uint16_t minInterval = attr.minReportInterval();
+        const uint16_t maxInterval = attr.maxReportInterval();
+
+        unsigned hdrLen = 2; // attribute id
+        if      (commandId == ZclReadAttributesResponseId) { hdrLen = 4; } // + status + type
+        else if (commandId == ZclConfigureReportingId)     { hdrLen = 8; } // + direction + type + min + max
+        else if (commandId != ZclReadAttributesId)         { hdrLen = 3; } // + type
+
+        if (data && pos + hdrLen > size)
+        {
+            return 0;
+        }
+
+        uint8_t *p = data ? data + pos : nullptr;
+
+        if (p && commandId == ZclConfigureReportingId)
+        {
+            *p++ = 0x00; // direction: reported
+        }
+
+        if (p)
+        {
+            p = put_u16_le(p, &id);
+        }
+
+        if (commandId == ZclReadAttributesId)
+        {
+            pos += hdrLen;
+            continue;
+        }
+
+        if (p)
+        {
+            if (commandId == ZclReadAttributesResponseId)
+            {
+                *p++ = 0x00; // status: success
+            }
+
+            *p++ = attr.dataType();
+
+            if (commandId == ZclConfigureReportingId)
+            {
+                p = put_u16_le(p, &minInterval);
+                p = put_u16_le(p, &maxInterval);
+            }
+        }
+
+        pos += hdrLen;
 
-            if (QFile::exists(gen))
+        int n;
+        if (commandId == ZclConfigureReportingId)
+        {
+            if ((ZCL_DataTypeTraits(attr.dataType()).flags & ZclTypeAnalog) == 0)
             {
-                DBG_Printf(DBG_INFO, "ZCLDB add file %s \n", qPrintable(gen));
-                stream << gen;
-                stream << "\n";
+                continue; // no reportable change for discrete data types
             }
-#endif // __APPLE__
+            n = attr.writeReportableChangeToBuffer(data ? data + pos : nullptr, data ? size - pos : 0);
         }
         else
         {
-            DBG_Printf(DBG_ERROR, "ZCLDB failed to create %s: %s\n", qPrintable(zclFile), qPrintable(file.errorString()));
+            n = attr.writeToBuffer(data ? data + pos : nullptr, data ? size - pos : 0);
+        }
+
+        if (n <= 0)
+        {
+            return 0;
         }
+
+        pos += unsigned(n);
     }
+
+    return pos;
 }
 
-void ZclDataBase::reloadAll(const QString &zclFile)
+// the ZCL_ lookups use the published snapshot, so they can be called from any thread
+
+ZclCluster ZCL_InCluster(uint16_t profileId, uint16_t clusterId, uint16_t mfcode)
 {
-    QFile file(zclFile);
+    return zclSnapshot()->inCluster(profileId, clusterId, mfcode);
+}
 
-    clear();
+ZclCluster ZCL_OutCluster(uint16_t profileId, uint16_t clusterId, uint16_t mfcode)
+{
+    return zclSnapshot()->outCluster(profileId, clusterId, mfcode);
+}
 
-#ifdef PL_UNIX
-    // TODO(mpi): this fails on Apple.
-    QString generalXml("/usr/share/deCONZ/zcl/general.xml");
-    if (QFile::exists(generalXml))
+ZclDataType ZCL_DataType(uint8_t id)
+{
+    return zclSnapshot()->dataType(id);
+}
+
+ZclDataType ZCL_DataType(const QString &name)
+{
+    return zclSnapshot()->dataType(name);
+}
+
+ZclCluster ZclDataBase::outCluster(uint16_t profileId, uint16_t clusterId, quint16 mfcode)
+{
+    const quint64 key = clusterCacheKey(profileId, clusterId, mfcode, ClientCluster);
+    const auto cached = m_clusterCache.constFind(key);
+
+    if (cached != m_clusterCache.cend())
     {
-        zclDataBase()->load(generalXml);
+        return cached.value();
     }
-#else
-    QString generalXml("");
-#endif // PL_UNIX
 
-    if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+    if (m_clusterCache.size() >= ZCL_CLUSTER_CACHE_MAX)
     {
-        QTextStream stream(&file);
+        m_clusterCache.clear();
+    }
 
-        while (!stream.atEnd())
+    if (m_profiles.contains(profileId))
+    {
+        const ZclProfile &profile = m_profiles[profileId];
+
+        for (auto i = profile.domains().cbegin(); i != profile.domains().cend(); ++i)
         {
-            QString line = stream.readLine(1024).trimmed();
-            if (line.endsWith(".xml") && line != generalXml)
+            quint32 hash = 0;
+            if (clusterId >= 0xfc00) {
+                hash |= mfcode;
+                hash <<= 16;
+            }
+            hash |= clusterId;
+
+            ZclCluster cl;
+            const auto ci = i->outClusters().constFind(hash);
+            const auto li = i->m_lazyIndex.constFind(hash);
+
+            if (ci != i->outClusters().cend())
+            {
+                cl = ci.value();
+            }
+            else if (li != i->m_lazyIndex.cend() && materialize(li.value()).hasClient)
+            {
+                cl = m_lazyClusters[size_t(li.value())].client;
+            }
+            else
             {
-                zclDataBase()->load(line);
+                continue;
             }
+
+            filterClientCluster(cl, mfcode);
+            m_clusterCache.insert(key, cl);
+            return cl;
         }
     }
-    else
+
+    ZclCluster cl(clusterId, QLatin1String("Unknown"));
+    m_clusterCache.insert(key, cl);
+    return cl;
+}
+
+/*! Lazy indexed clusters of a ZclDataBaseSnapshot, parsed on first use from any thread. */
+class ZclSnapshotLazy
+{
+public:
+    explicit ZclSnapshotLazy(const ZclDataBase *base);
+    ~ZclSnapshotLazy();
+    const ZclLazyCluster &materialize(int index);
+
+    U_Mutex mutex;
+    ZclDataBase parser; //!< Copy of data types, enumerations and lazy index entries.
+};
+
+ZclSnapshotLazy::ZclSnapshotLazy(const ZclDataBase *base) :
+    parser(base)
+{
+    U_thread_mutex_init(&mutex);
+    parser.m_lazyClusters = base->m_lazyClusters;
+
+    for (const ZclLazyCluster &lc : parser.m_lazyClusters)
     {
-        DBG_Printf(DBG_ERROR, "ZCLDB failed to open %s:%s\n", qPrintable(zclFile), qPrintable(file.errorString()));
+        if (lc.materialized)
+        {
+            ZclDataBase::freezeCluster(lc.server);
+            ZclDataBase::freezeCluster(lc.client);
+        }
     }
 }
 
-void ZclDataBase::clear()
+ZclSnapshotLazy::~ZclSnapshotLazy()
 {
-    m_enums.clear();
-    m_dataTypes.clear();
-    m_domains.clear();
-    m_profiles.clear();
-    m_devices.clear();
+    U_thread_mutex_destroy(&mutex);
 }
 
-ZclCluster ZclDataBase::inCluster(uint16_t profileId, uint16_t clusterId, quint16 mfcode)
+const ZclLazyCluster &ZclSnapshotLazy::materialize(int index)
 {
-    if (m_profiles.contains(profileId))
-    {
-        const ManufacturerCode_t _mfcode(mfcode);
-        const ZclProfile &profile = m_profiles[profileId];
+    U_thread_mutex_lock(&mutex);
 
-        for (auto i = profile.domains().cbegin(); i != profile.domains().cend(); ++i)
-        {
-            quint32 hash = 0;
-            if (clusterId >= 0xfc00) {
-                hash |= static_cast<quint16>(_mfcode);
-                hash <<= 16;
-            }
-            hash |= clusterId;
+    // entries are never moved, materialized ones aren't modified anymore
+    const ZclLazyCluster &lc = parser.m_lazyClusters[size_t(index)];
 
-            if (i->inClusters().contains(hash))
-            {
-                auto cl = i->inClusters().value(hash);
+    if (!lc.materialized)
+    {
+        parser.materialize(index);
+        ZclDataBase::freezeCluster(lc.server);
+        ZclDataBase::freezeCluster(lc.client);
+    }
+
+    U_thread_mutex_unlock(&mutex);
+    return lc;
+}
 
-                std::vector<ZclAttribute> attributes;
+ZclDataBaseSnapshot::ZclDataBaseSnapshot() :
+    m_unknownDataType(0x00, "No Data", "-", 0, '-')
+{
+    m_dataTypeIndex.fill(-1);
+}
 
-                std::copy_if(cl.attributes().begin(), cl.attributes().end(), std::back_inserter(attributes), [_mfcode](const ZclAttribute &a) {
-                    return a.manufacturerCode_t() == 0x0000_mfcode
-                           || a.manufacturerCode_t() == _mfcode
-                           || (a.manufacturerCode_t() == 0x115f_mfcode && _mfcode == 0x1037_mfcode) /* Xiaomi used both on the same device */;
-                });
+const ZclCluster *ZclDataBaseSnapshot::findCluster(uint16_t profileId, uint16_t clusterId, quint16 mfcode, bool server) const
+{
+    const auto p = m_profiles.constFind(profileId);
+    if (p == m_profiles.cend())
+    {
+        return nullptr;
+    }
 
-                if (cl.attributes().size() != attributes.size()) // filtered
-                {
-                    cl.attributes() = std::move(attributes);
-                }
+    const quint32 hash = clusterHash(clusterId, mfcode);
 
-                std::vector<ZclCommand> commands;
+    for (const ZclDomain &dom : p->domains())
+    {
+        const QHash<uint32_t, ZclCluster> &clusters = server ? dom.inClusters() : dom.outClusters();
+        const auto i = clusters.constFind(hash);
+        if (i != clusters.cend())
+        {
+            return &i.value();
+        }
 
-                std::copy_if(cl.commands().begin(), cl.commands().end(), std::back_inserter(commands), [mfcode](const ZclCommand &a) {
-                    return a.manufacturerId() == 0 || a.manufacturerId() == mfcode;
-                });
+        const auto li = dom.m_lazyIndex.constFind(hash);
+        if (m_lazy && li != dom.m_lazyIndex.cend())
+        {
+            const ZclLazyCluster &lc = m_lazy->materialize(li.value());
 
-                if (cl.commands().size() != commands.size()) // filtered
-                {
-                    cl.commands() = std::move(commands);
-                }
+            if (server && lc.hasServer)
+            {
+                return &lc.server;
+            }
 
-                return cl;
+            if (!server && lc.hasClient)
+            {
+                return &lc.client;
             }
         }
     }
 
-    return ZclCluster(clusterId, QLatin1String("Unknown"));
+    return nullptr;
 }
 
-ZclCluster ZCL_InCluster(uint16_t profileId, uint16_t clusterId, uint16_t mfcode)
+ZclCluster ZclDataBaseSnapshot::inCluster(uint16_t profileId, uint16_t clusterId, quint16 mfcode) const
 {
-    if (_zclDB)
+    const ZclCluster *found = findCluster(profileId, clusterId, mfcode, true);
+    if (!found)
     {
-        return _zclDB->inCluster(profileId, clusterId, mfcode);
+        return ZclCluster(clusterId, QLatin1String("Unknown"));
     }
 
-    return {};
+    ZclCluster cl = *found;
+    filterServerCluster(cl, mfcode);
+    return cl;
 }
 
-ZclCluster ZCL_OutCluster(uint16_t profileId, uint16_t clusterId, uint16_t mfcode)
+ZclCluster ZclDataBaseSnapshot::outCluster(uint16_t profileId, uint16_t clusterId, quint16 mfcode) const
 {
-    if (_zclDB)
+    const ZclCluster *found = findCluster(profileId, clusterId, mfcode, false);
+    if (!found)
     {
-        return _zclDB->outCluster(profileId, clusterId, mfcode);
+        return ZclCluster(clusterId, QLatin1String("Unknown"));
     }
 
-    return {};
+    ZclCluster cl = *found;
+    filterClientCluster(cl, mfcode);
+    return cl;
 }
 
-ZclDataType ZCL_DataType(uint8_t id)
+const ZclDataType &ZclDataBaseSnapshot::dataType(uint8_t id) const
 {
-    if (_zclDB)
+    const int i = m_dataTypeIndex[id];
+    if (i >= 0)
     {
-        return _zclDB->dataType(id);
+        return m_dataTypes[size_t(i)];
     }
 
-    return {};
+    return m_unknownDataType;
 }
 
-ZclDataType ZCL_DataType(const QString &name)
+const ZclDataType &ZclDataBaseSnapshot::dataType(const QString &shortName) const
 {
-    if (_zclDB)
+    const auto i = m_dataTypeNameIndex.constFind(shortName);
+    if (i != m_dataTypeNameIndex.cend())
     {
-        return _zclDB->dataType(name);
+        return m_dataTypes[size_t(i.value())];
     }
 
-    return {};
+    return m_unknownDataType;
 }
 
-ZclCluster ZclDataBase::outCluster(uint16_t profileId, uint16_t clusterId, quint16 mfcode)
+const Enumeration *ZclDataBaseSnapshot::enumeration(uint id) const
 {
-    if (m_profiles.contains(profileId))
+    const auto i = m_enumIndex.constFind(id);
+    if (i != m_enumIndex.cend())
     {
-        const ZclProfile &profile = m_profiles[profileId];
+        return &m_enums[size_t(i.value())];
+    }
 
-        for (auto i = profile.domains().cbegin(); i != profile.domains().cend(); ++i)
+    return nullptr;
+}
+
+ZclDevice ZclDataBaseSnapshot::device(uint16_t profileId, uint16_t deviceId) const
+{
+    auto i = m_deviceIndex.constFind(quint32(profileId) << 16 | deviceId);
+
+    if (i == m_deviceIndex.cend())
+    {
+        i = m_deviceIndex.constFind(quint32(0xFFFF) << 16 | deviceId);
+    }
+
+    ZclDevice dev;
+    if (i != m_deviceIndex.cend())
+    {
+        dev = m_devices[size_t(i.value())];
+    }
+    else
+    {
+        dev = ZclDevice(deviceId, QString("%1").arg(deviceId, (int)4, (int)16, QChar('0')), QString());
+    }
+
+    dev.setProfileId(profileId);
+    return dev;
+}
+
+ZclSnapshotPtr ZclDataBase::snapshot() const
+{
+    return std::atomic_load(&m_snapshot);
+}
+
+/*! Prepares \p cl for const access from other threads.
+
+    Builds the command index and converts all attribute values to QVariant,
+    so that const access doesn't write to shared data.
+ */
+void ZclDataBase::freezeCluster(const ZclCluster &cl)
+{
+    cl.commandIndex(0, false, 0); // builds the command index
+
+    for (const ZclAttribute &attr : cl.attributes())
+    {
+        attr.d_ptr->value();
+    }
+
+    for (const ZclCommand &cmd : cl.commands())
+    {
+        for (const ZclAttribute &attr : cmd.parameters())
         {
-            quint32 hash = 0;
-            if (clusterId >= 0xfc00) {
-                hash |= mfcode;
-                hash <<= 16;
-            }
-            hash |= clusterId;
+            attr.d_ptr->value();
+        }
+    }
+}
 
-            if (i->outClusters().contains(hash))
-            {
-                auto cl = i->outClusters().value(hash);
+/*! Builds a new snapshot from the current state and swaps it in.
 
-                std::vector<ZclAttribute> attributes;
+    Lazy indexed clusters aren't parsed here, the snapshot keeps the lazy index
+    and parses them on first use with its own copy of the index entries.
+ */
+void ZclDataBase::publishSnapshot()
+{
+    auto snap = std::make_shared<ZclDataBaseSnapshot>();
 
-                std::copy_if(cl.attributes().begin(), cl.attributes().end(), std::back_inserter(attributes), [mfcode](const ZclAttribute &a) {
-                    return a.manufacturerCode() == 0 || a.manufacturerCode() == mfcode;
-                });
+    snap->m_version = ++m_snapshotVersion;
+    snap->m_profiles = m_profiles;
+    snap->m_dataTypes = m_dataTypes;
+    snap->m_dataTypeIndex = m_dataTypeIndex;
+    snap->m_dataTypeNameIndex = m_dataTypeNameIndex;
+    snap->m_enums = m_enums;
+    snap->m_enumIndex = m_enumIndex;
+    snap->m_devices = m_devices;
+    snap->m_deviceIndex = m_deviceIndex;
 
-                if (cl.attributes().size() != attributes.size()) // filtered
-                {
-                    cl.attributes() = std::move(attributes);
-                }
+    if (!m_lazyClusters.empty())
+    {
+        snap->m_lazy = std::make_shared<ZclSnapshotLazy>(this);
+    }
 
-                return cl;
-            }
+    const QHash<uint16_t, ZclProfile> &profiles = snap->m_profiles; // const, no detach
+    for (const ZclProfile &p : profiles)
+    {
+        for (const ZclDomain &dom : p.domains())
+        {
+            for (const ZclCluster &cl : dom.m_inClusters) { freezeCluster(cl); }
+            for (const ZclCluster &cl : dom.m_outClusters) { freezeCluster(cl); }
         }
     }
 
-    return ZclCluster(clusterId, QLatin1String("Unknown"));
+    std::atomic_store(&m_snapshot, ZclSnapshotPtr(std::move(snap)));
 }
 
 const ZclDataType &ZclDataBase::dataType(uint8_t id) const
 {
-    for (const ZclDataType &dt : m_dataTypes)
+    const int i = m_dataTypeIndex[id];
+    if (i >= 0)
     {
-        if (dt.id() == id)
-        {
-            return dt;
-        }
+        return m_dataTypes[size_t(i)];
     }
 
     return m_unknownDataType;
@@ -4353,12 +6230,10 @@ const ZclDataType &ZclDataBase::dataType(uint8_t id) const
 
 const ZclDataType &ZclDataBase::dataType(const QString &shortName) const
 {
-    for (const ZclDataType &dt : m_dataTypes)
+    const auto i = m_dataTypeNameIndex.constFind(shortName);
+    if (i != m_dataTypeNameIndex.cend())
     {
-        if (dt.shortname() == shortName)
-        {
-            return dt;
-        }
+        return m_dataTypes[size_t(i.value())];
     }
 
     return m_unknownDataType;
@@ -4366,13 +6241,10 @@ const ZclDataType &ZclDataBase::dataType(const QString &shortName) const
 
 ZclProfile ZclDataBase::profile(uint16_t id)
 {
-    const auto &profiles = m_profiles;
-    for (const ZclProfile &profile : profiles)
+    const auto i = m_profiles.constFind(id);
+    if (i != m_profiles.cend())
     {
-        if (profile.id() == id)
-        {
-            return profile;
-        }
+        return i.value();
     }
 
     ZclProfile pro;
@@ -4400,6 +6272,8 @@ ZclDomain ZclDataBase::domain(const QString &name)
  */
 void ZclDataBase::addDomain(const ZclDomain &domain)
 {
+    m_clusterCache.clear();
+
     for (auto i = m_domains.begin(); i != m_domains.end(); ++i)
     {
         if (i->name().toLower() == domain.name().toLower())
@@ -4417,6 +6291,8 @@ void ZclDataBase::addDomain(const ZclDomain &domain)
  */
 void ZclDataBase::addProfile(const ZclProfile &profile)
 {
+    m_clusterCache.clear();
+
     if (m_profiles.contains(profile.id()))
     {
         m_profiles[profile.id()] = profile;
@@ -4429,35 +6305,24 @@ void ZclDataBase::addProfile(const ZclProfile &profile)
 ZclDevice ZclDataBase::device(uint16_t profileId, uint16_t deviceId)
 {
     // search first for most specific device
-    auto i = m_devices.cbegin();
-    auto end = m_devices.cend();
+    auto i = m_deviceIndex.constFind(quint32(profileId) << 16 | deviceId);
 
-    for (; i != end; ++i)
+    if (i != m_deviceIndex.cend())
     {
-        if ((i->id() == deviceId) &&
-            (i->profileId() == profileId))
-        {
-            return *i;
-        }
+        return m_devices[size_t(i.value())];
     }
 
-
     // search for generic devices
-    i = m_devices.cbegin();
-    end = m_devices.cend();
+    i = m_deviceIndex.constFind(quint32(0xFFFF) << 16 | deviceId);
 
-    for (; i != end; ++i)
+    if (i != m_deviceIndex.cend())
     {
-        if ((i->id() == deviceId) &&
-            (i->profileId() == 0xFFFF))
-        {
-            ZclDevice dev = *i;
-            dev.setProfileId(profileId);
-            return dev;
-        }
+        ZclDevice dev = m_devices[size_t(i.value())];
+        dev.setProfileId(profileId);
+        return dev;
     }
 
-    ZclDevice dev(deviceId, QString("%1").arg(deviceId, (int)4, (int)16, QChar('0')), QString(), QIcon());
+    ZclDevice dev(deviceId, QString("%1").arg(deviceId, (int)4, (int)16, QChar('0')), QString());
     dev.setProfileId(profileId);
 
     return dev;
@@ -4470,58 +6335,7 @@ ZclDevice ZclDataBase::device(uint16_t profileId, uint16_t deviceId)
  */
 bool ZclDataBase::knownDataType(uint8_t id)
 {
-    switch (id) {
-    case Zcl8BitData:
-    case Zcl16BitData:
-    case Zcl24BitData:
-    case Zcl32BitData:
-    case Zcl40BitData:
-    case Zcl48BitData:
-    case Zcl56BitData:
-    case Zcl64BitData:
-    case ZclBoolean:
-    case Zcl8BitBitMap:
-    case Zcl16BitBitMap:
-    case Zcl24BitBitMap:
-    case Zcl32BitBitMap:
-    case Zcl40BitBitMap:
-    case Zcl48BitBitMap:
-    case Zcl56BitBitMap:
-    case Zcl64BitBitMap:
-    case Zcl8BitUint:
-    case Zcl16BitUint:
-    case Zcl24BitUint:
-    case Zcl32BitUint:
-    case Zcl40BitUint:
-    case Zcl48BitUint:
-    case Zcl56BitUint:
-    case Zcl64BitUint:
-    case Zcl8BitInt:
-    case Zcl16BitInt:
-    case Zcl24BitInt:
-    case Zcl32BitInt:
-    case Zcl40BitInt:
-    case Zcl48BitInt:
-    case Zcl56BitInt:
-    case Zcl64BitInt:
-    case Zcl8BitEnum:
-    case Zcl16BitEnum:
-    case ZclSingleFloat:
-    case ZclCharacterString:
-    case ZclOctedString:
-    case ZclUtcTime:
-    case ZclAttributeId:
-    case ZclClusterId:
-    case ZclIeeeAddress:
-    case Zcl128BitSecurityKey:
-    case ZclArray:
-        return true;
-
-    default:
-        break;
-    }
-
-    return false;
+    return (ZCL_DataTypeTraits(id).flags & ZclTypeKnown) != 0;
 }
 
 void ZclProfile::addDomain(const ZclDomain &domain)
@@ -4542,12 +6356,26 @@ void ZclProfile::addDomain(const ZclDomain &domain)
 
 ZclDataBase *zclDataBase()
 {
-    if (!_zclDB)
+    ZclDataBase *db = _zclDB;
+    if (!db)
+    {
+        db = new ZclDataBase;
+        _zclDB = db;
+    }
+
+    return db;
+}
+
+ZclSnapshotPtr zclSnapshot()
+{
+    const ZclDataBase *db = _zclDB;
+    if (db)
     {
-        _zclDB = new ZclDataBase;
+        return db->snapshot();
     }
 
-    return _zclDB;
+    static const ZclSnapshotPtr empty = std::make_shared<ZclDataBaseSnapshot>();
+    return empty;
 }
 
 } // namespace deCONZ
@@ -0,0 +1,721 @@
+/*
+ * Copyright (c) 2012-2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+/*
+ * Binary cache of the ZCLDB.
+ *
+ * Parsing all ZCLDB XML files is one of the more expensive parts during
+ * startup, especially on ARM based gateways. After a successful XML parse
+ * the complete database is written into a compact binary file. On the
+ * next start the cache is used as long as the source files didn't change.
+ *
+ * File layout (little endian):
+ *
+ *   u32     magic 'ZCDB'
+ *   u32     format version
+ *   u8[32]  key: SHA-256 over the source file paths and their contents
+ *   u32     payload size
+ *   u8[32]  payload checksum: SHA-256 of the payload
+ *   u8[]    payload: QDataStream serialized database
+ */
+
+#include <QDataStream>
+#include <cstring>
+#include "deconz/aps.h"
+#include "deconz/buffer_helper.h"
+#include "deconz/dbg_trace.h"
+#include "deconz/file.h"
+#include "deconz/u_sha256.h"
+#include "deconz/zcl.h"
+#include "zcl_private.h"
+
+#define ZCL_CACHE_MAGIC   0x4244435AU /* 'ZCDB' */
+#define ZCL_CACHE_VERSION 1
+#define ZCL_CACHE_HASH_SIZE 32
+#define ZCL_CACHE_HEADER_SIZE (4 + 4 + ZCL_CACHE_HASH_SIZE + 4 + ZCL_CACHE_HASH_SIZE)
+#define ZCL_CACHE_MAX_SIZE (32 * 1024 * 1024)
+
+namespace deCONZ {
+
+static bool readWholeFile(const QString &path, QByteArray &out)
+{
+    FS_File fp;
+    const QByteArray path8 = path.toUtf8();
+
+    if (FS_OpenFile(&fp, FS_MODE_R, path8.constData()) == 0)
+    {
+        return false;
+    }
+
+    bool ret = false;
+    const long size = FS_GetFileSize(&fp);
+
+    if (size >= 0 && size <= ZCL_CACHE_MAX_SIZE)
+    {
+        out.resize(int(size));
+        ret = size == 0 || FS_ReadFile(&fp, out.data(), size) == size;
+    }
+
+    FS_CloseFile(&fp);
+    return ret;
+}
+
+/*! Calculates the cache key over all \p files which would be loaded.
+
+    Besides file contents the key covers the cache format version,
+    the Qt version, since QDataStream serialization depends on it, and
+    the icon directory or headless mode as resolved icon paths are stored.
+
+    \returns 32-byte SHA-256 hash or empty array if a file can't be read.
+ */
+QByteArray ZclDataBase::cacheKey(const QStringList &files, std::vector<QByteArray> *fileHashes) const
+{
+    QByteArray buf;
+    QByteArray content;
+    unsigned char hash[ZCL_CACHE_HASH_SIZE];
+
+    buf += QByteArray::number(ZCL_CACHE_VERSION);
+    buf += ' ';
+    buf += QT_VERSION_STR;
+    buf += '\0';
+    // resolved icon paths are stored in the cache
+    buf += m_headless ? QByteArray("headless") : m_iconPath.toUtf8();
+    buf += '\0';
+
+    for (const QString &path : files)
+    {
+        if (!readWholeFile(path, content))
+        {
+            DBG_Printf(DBG_ZCLDB, "ZCLDB cache can't read %s\n", qPrintable(path));
+            return {};
+        }
+
+        U_Sha256(content.constData(), unsigned(content.size()), hash);
+        if (fileHashes)
+        {
+            fileHashes->emplace_back(reinterpret_cast<const char*>(hash), int(sizeof(hash)));
+        }
+
+        buf += path.toUtf8();
+        buf += '\0';
+        buf.append(reinterpret_cast<const char*>(hash), sizeof(hash));
+    }
+
+    U_Sha256(buf.constData(), unsigned(buf.size()), hash);
+    return QByteArray(reinterpret_cast<const char*>(hash), sizeof(hash));
+}
+
+void ZclDataBase::writeAttribute(QDataStream &stream, const ZclAttribute &attr)
+{
+    const ZclAttributePrivate *d = attr.d_ptr;
+
+    stream << d->m_id;
+    stream << d->m_dataType;
+    stream << d->m_subType;
+    stream << d->m_schema->m_name;
+    stream << d->m_schema->m_description;
+    stream << quint8(d->m_schema->m_access);
+    stream << d->m_schema->m_enumerationId;
+    stream << d->m_schema->m_numericBase;
+    stream << d->m_schema->m_required;
+    stream << d->m_avail;
+    stream << quint64(d->m_valueState.bitmap);
+    stream << d->value();
+    stream << quint64(d->m_numericValue.u64);
+    stream << quint32(d->m_schema->m_valuePos.size());
+    for (int pos : d->m_schema->m_valuePos)
+    {
+        stream << qint32(pos);
+    }
+    stream << d->m_schema->m_valueNames;
+    stream << d->m_schema->m_listSizeAttr;
+    stream << qint32(d->m_listSize);
+    stream << d->m_minReportInterval;
+    stream << d->m_maxReportInterval;
+    stream << d->m_reportTimeout;
+    stream << quint64(d->m_reportableChange.u64);
+    stream << quint8(d->m_schema->m_formatHint);
+    stream << qint32(d->m_schema->m_rangeMin);
+    stream << qint32(d->m_schema->m_rangeMax);
+    stream << d->m_schema->m_manufacturerCode;
+    stream << d->m_schema->m_attrSetId;
+    stream << d->m_schema->m_attrSetManufacturerCode;
+}
+
+void ZclDataBase::readAttribute(QDataStream &stream, ZclAttribute &attr)
+{
+    ZclAttributePrivate *d = attr.d_ptr;
+    ZclAttributeSchema *schema = d->m_schema.detach();
+    quint8 u8;
+    quint32 u32;
+    qint32 s32;
+    quint64 u64;
+
+    stream >> d->m_id;
+    stream >> d->m_dataType;
+    stream >> d->m_subType;
+    stream >> schema->m_name;
+    stream >> schema->m_description;
+    stream >> u8; schema->m_access = static_cast<ZclAccess>(u8);
+    stream >> schema->m_enumerationId;
+    stream >> schema->m_numericBase;
+    stream >> schema->m_required;
+    stream >> d->m_avail;
+    stream >> u64; d->m_valueState.bitmap = u64;
+    stream >> d->m_value;
+    d->m_valueKind = ZclAttributePrivate::ValueVariant;
+    stream >> u64; d->m_numericValue.u64 = u64;
+    stream >> u32;
+    schema->m_valuePos.clear();
+    for (quint32 i = 0; i < u32 && stream.status() == QDataStream::Ok; i++)
+    {
+        stream >> s32;
+        schema->m_valuePos.push_back(s32);
+    }
+    stream >> schema->m_valueNames;
+    stream >> schema->m_listSizeAttr;
+    stream >> s32; d->m_listSize = s32;
+    stream >> d->m_minReportInterval;
+    stream >> d->m_maxReportInterval;
+    stream >> d->m_reportTimeout;
+    stream >> u64; d->m_reportableChange.u64 = u64;
+    stream >> u8; schema->m_formatHint = static_cast<ZclAttribute::FormatHint>(u8);
+    stream >> s32; schema->m_rangeMin = s32;
+    stream >> s32; schema->m_rangeMax = s32;
+    stream >> schema->m_manufacturerCode;
+    stream >> schema->m_attrSetId;
+    stream >> schema->m_attrSetManufacturerCode;
+
+    schema->m_name = intern(schema->m_name);
+    schema->m_description = intern(schema->m_description);
+    for (QString &name : schema->m_valueNames)
+    {
+        name = intern(name);
+    }
+}
+
+void ZclDataBase::writeCommand(QDataStream &stream, const ZclCommand &cmd)
+{
+    const ZclCommandPrivate *d = cmd.d_ptr;
+
+    stream << d->m_id;
+    stream << d->m_manufacturerId;
+    stream << d->m_responseId;
+    stream << d->m_name;
+    stream << d->m_required;
+    stream << d->m_recv;
+    stream << d->m_description;
+    stream << d->m_isProfileWide;
+    stream << d->m_disableDefaultResponse;
+    stream << quint32(d->m_payload.size());
+    for (const ZclAttribute &attr : d->m_payload)
+    {
+        writeAttribute(stream, attr);
+    }
+}
+
+void ZclDataBase::readCommand(QDataStream &stream, ZclCommand &cmd)
+{
+    ZclCommandPrivate *d = cmd.d_ptr;
+    quint32 count = 0;
+
+    stream >> d->m_id;
+    stream >> d->m_manufacturerId;
+    stream >> d->m_responseId;
+    stream >> d->m_name;
+    stream >> d->m_required;
+    stream >> d->m_recv;
+    stream >> d->m_description;
+    stream >> d->m_isProfileWide;
+    stream >> d->m_disableDefaultResponse;
+    stream >> count;
+
+    d->m_name = intern(d->m_name);
+    d->m_description = intern(d->m_description);
+
+    d->m_payload.clear();
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        d->m_payload.emplace_back();
+        readAttribute(stream, d->m_payload.back());
+    }
+}
+
+void ZclDataBase::writeCluster(QDataStream &stream, const ZclCluster &cl)
+{
+    stream << cl.id();
+    stream << cl.oppositeId();
+    stream << cl.manufacturerCode();
+    stream << cl.name();
+    stream << cl.description();
+    stream << cl.isZcl();
+    stream << cl.isServer();
+
+    stream << quint32(cl.attributes().size());
+    for (const ZclAttribute &attr : cl.attributes())
+    {
+        writeAttribute(stream, attr);
+    }
+
+    stream << quint32(cl.attributeSets().size());
+    for (const ZclAttributeSet &set : cl.attributeSets())
+    {
+        stream << set.id();
+        stream << set.description();
+        stream << set.manufacturerCode();
+        stream << quint32(set.attributes().size());
+        for (int idx : set.attributes())
+        {
+            stream << qint32(idx);
+        }
+    }
+
+    stream << quint32(cl.commands().size());
+    for (const ZclCommand &cmd : cl.commands())
+    {
+        writeCommand(stream, cmd);
+    }
+}
+
+void ZclDataBase::readCluster(QDataStream &stream, ZclCluster &cl)
+{
+    quint16 id;
+    quint16 oppositeId;
+    quint16 mfcode;
+    QString name;
+    QString description;
+    bool isZcl;
+    bool isServer;
+    quint32 count = 0;
+
+    stream >> id >> oppositeId >> mfcode >> name >> description >> isZcl >> isServer;
+
+    cl = ZclCluster(id, intern(name), intern(description));
+    cl.setOppositeId(oppositeId);
+    cl.setManufacturerCode(mfcode);
+    cl.setIsZcl(isZcl);
+    cl.setIsServer(isServer);
+
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        cl.attributes().emplace_back();
+        readAttribute(stream, cl.attributes().back());
+    }
+
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        quint16 setId;
+        quint16 setMfcode;
+        quint32 nIndexes = 0;
+        QString setDescription;
+
+        stream >> setId >> setDescription >> setMfcode >> nIndexes;
+
+        ZclAttributeSet set(setId, setDescription);
+        set.setManufacturerCode(setMfcode);
+
+        for (quint32 j = 0; j < nIndexes && stream.status() == QDataStream::Ok; j++)
+        {
+            qint32 idx;
+            stream >> idx;
+            set.addAttribute(idx);
+        }
+
+        cl.attributeSets().push_back(set);
+    }
+
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        cl.commands().emplace_back();
+        readCommand(stream, cl.commands().back());
+    }
+}
+
+void ZclDataBase::writeDomain(QDataStream &stream, const ZclDomain &dom)
+{
+    stream << dom.m_name;
+    stream << dom.m_description;
+    stream << dom.m_useZcl;
+
+    for (const auto *clusters : { &dom.m_inClusters, &dom.m_outClusters })
+    {
+        stream << quint32(clusters->size());
+        for (auto i = clusters->cbegin(); i != clusters->cend(); ++i)
+        {
+            stream << quint32(i.key());
+            writeCluster(stream, i.value());
+        }
+    }
+}
+
+void ZclDataBase::readDomain(QDataStream &stream, ZclDomain &dom)
+{
+    stream >> dom.m_name;
+    stream >> dom.m_description;
+    stream >> dom.m_useZcl;
+
+    for (auto *clusters : { &dom.m_inClusters, &dom.m_outClusters })
+    {
+        quint32 count = 0;
+        stream >> count;
+
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+        {
+            quint32 key;
+            ZclCluster cl;
+            stream >> key;
+            readCluster(stream, cl);
+            clusters->insert(key, cl);
+        }
+    }
+}
+
+/*! Writes the database to the binary cache file \p path.
+
+    Profiles hold copies of the domains they reference, in most cases these
+    are identical to the global domains. Each distinct domain is only written
+    once, profiles refer to it by index.
+ */
+bool ZclDataBase::saveCache(const QString &path, const QByteArray &key) const
+{
+    if (key.size() != ZCL_CACHE_HASH_SIZE)
+    {
+        return false;
+    }
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    // data types
+    stream << quint32(m_dataTypes.size());
+    for (const ZclDataType &dt : m_dataTypes)
+    {
+        char ad = '-';
+        if      (dt.isAnalog())   { ad = 'A'; }
+        else if (dt.isDiscrete()) { ad = 'D'; }
+
+        stream << dt.id() << dt.name() << dt.shortname() << qint32(dt.length()) << qint8(ad);
+    }
+
+    // enumerations
+    stream << quint32(m_enums.size());
+    for (const Enumeration &e : m_enums)
+    {
+        stream << quint32(e.id()) << e.name() << e.values();
+    }
+
+    // distinct domains
+    std::vector<QByteArray> domains;
+    const auto domainIndex = [&domains](const ZclDomain &dom) -> quint32
+    {
+        QByteArray buf;
+        QDataStream ds(&buf, QIODevice::WriteOnly);
+        ds.setByteOrder(QDataStream::LittleEndian);
+        writeDomain(ds, dom);
+
+        for (size_t i = 0; i < domains.size(); i++)
+        {
+            if (domains[i] == buf)
+            {
+                return quint32(i);
+            }
+        }
+
+        domains.push_back(buf);
+        return quint32(domains.size() - 1);
+    };
+
+    std::vector<quint32> dbDomains;
+    for (const ZclDomain &dom : m_domains)
+    {
+        dbDomains.push_back(domainIndex(dom));
+    }
+
+    std::vector<std::vector<quint32>> profileDomains;
+    for (const ZclProfile &pro : m_profiles)
+    {
+        profileDomains.emplace_back();
+        for (const ZclDomain &dom : pro.domains())
+        {
+            profileDomains.back().push_back(domainIndex(dom));
+        }
+    }
+
+    stream << quint32(domains.size());
+    for (const QByteArray &buf : domains)
+    {
+        stream.writeRawData(buf.constData(), buf.size());
+    }
+
+    stream << quint32(dbDomains.size());
+    for (quint32 idx : dbDomains)
+    {
+        stream << idx;
+    }
+
+    // profiles
+    size_t p = 0;
+    stream << quint32(m_profiles.size());
+    for (const ZclProfile &pro : m_profiles)
+    {
+        stream << pro.id() << pro.name() << pro.description() << pro.iconPath();
+        stream << quint32(profileDomains[p].size());
+        for (quint32 idx : profileDomains[p])
+        {
+            stream << idx;
+        }
+        p++;
+    }
+
+    // devices
+    stream << quint32(m_devices.size());
+    for (const ZclDevice &dev : m_devices)
+    {
+        stream << dev.id() << dev.profileId() << dev.name() << dev.description() << dev.iconPath();
+    }
+
+    if (stream.status() != QDataStream::Ok || payload.size() > ZCL_CACHE_MAX_SIZE)
+    {
+        return false;
+    }
+
+    uint8_t header[ZCL_CACHE_HEADER_SIZE];
+    uint8_t *h = header;
+    const uint32_t magic = ZCL_CACHE_MAGIC;
+    const uint32_t version = ZCL_CACHE_VERSION;
+    const uint32_t payloadSize = uint32_t(payload.size());
+
+    h = put_u32_le(h, &magic);
+    h = put_u32_le(h, &version);
+    memcpy(h, key.constData(), ZCL_CACHE_HASH_SIZE);
+    h += ZCL_CACHE_HASH_SIZE;
+    h = put_u32_le(h, &payloadSize);
+    U_Sha256(payload.constData(), unsigned(payload.size()), h);
+
+    FS_File fp;
+    const QByteArray path8 = path.toUtf8();
+
+    if (FS_OpenFile(&fp, FS_MODE_RW, path8.constData()) == 0)
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCLDB failed to create cache %s\n", path8.constData());
+        return false;
+    }
+
+    bool ret = FS_TruncateFile(&fp, 0) != 0 &&
+               FS_WriteFile(&fp, header, sizeof(header)) == long(sizeof(header)) &&
+               FS_WriteFile(&fp, payload.constData(), payload.size()) == payload.size();
+
+    FS_CloseFile(&fp);
+
+    if (ret)
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCLDB wrote cache %s (%d bytes)\n", path8.constData(), int(payload.size()));
+    }
+    else
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCLDB failed to write cache %s\n", path8.constData());
+        FS_DeleteFile(path8.constData());
+    }
+
+    return ret;
+}
+
+/*! Loads the database from the binary cache file \p path.
+
+    The cache is only accepted when format version, \p key and checksum
+    match. On success the current content of the database is replaced.
+ */
+bool ZclDataBase::loadCache(const QString &path, const QByteArray &key)
+{
+    QByteArray buf;
+
+    if (key.size() != ZCL_CACHE_HASH_SIZE || !readWholeFile(path, buf))
+    {
+        return false;
+    }
+
+    if (buf.size() < ZCL_CACHE_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    const uint8_t *h = reinterpret_cast<const uint8_t*>(buf.constData());
+    uint32_t magic;
+    uint32_t version;
+    uint32_t payloadSize;
+    unsigned char checksum[ZCL_CACHE_HASH_SIZE];
+
+    h = get_u32_le(h, &magic);
+    h = get_u32_le(h, &version);
+
+    if (magic != ZCL_CACHE_MAGIC || version != ZCL_CACHE_VERSION)
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCLDB cache format mismatch\n");
+        return false;
+    }
+
+    if (memcmp(h, key.constData(), ZCL_CACHE_HASH_SIZE) != 0)
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCLDB cache outdated, source files changed\n");
+        return false;
+    }
+    h += ZCL_CACHE_HASH_SIZE;
+    h = get_u32_le(h, &payloadSize);
+
+    if (payloadSize != uint32_t(buf.size() - ZCL_CACHE_HEADER_SIZE))
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCLDB cache size mismatch\n");
+        return false;
+    }
+
+    const char *payload = buf.constData() + ZCL_CACHE_HEADER_SIZE;
+    U_Sha256(payload, payloadSize, checksum);
+
+    if (memcmp(h, checksum, ZCL_CACHE_HASH_SIZE) != 0)
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCLDB cache checksum mismatch\n");
+        return false;
+    }
+
+    QDataStream stream(QByteArray::fromRawData(payload, int(payloadSize)));
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 count = 0;
+    std::vector<ZclDataType> dataTypes;
+    std::vector<Enumeration> enums;
+    std::vector<ZclDomain> domains;
+    std::vector<ZclDomain> dbDomains;
+    QHash<uint16_t, ZclProfile> profiles;
+    std::vector<ZclDevice> devices;
+
+    // data types
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        quint8 id;
+        QString name;
+        QString shortname;
+        qint32 length;
+        qint8 ad;
+
+        stream >> id >> name >> shortname >> length >> ad;
+        dataTypes.push_back(ZclDataType(id, name, shortname, length, char(ad)));
+    }
+
+    // enumerations
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        quint32 id;
+        QString name;
+        QHash<uint, QString> values;
+
+        stream >> id >> name >> values;
+        Enumeration e(id, name);
+        for (auto v = values.cbegin(); v != values.cend(); ++v)
+        {
+            e.setValue(v.key(), v.value());
+        }
+        enums.push_back(e);
+    }
+
+    // distinct domains
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        domains.emplace_back();
+        readDomain(stream, domains.back());
+    }
+
+    const auto domainAt = [&domains, &stream](quint32 idx) -> ZclDomain
+    {
+        if (idx < domains.size())
+        {
+            return domains[idx];
+        }
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return {};
+    };
+
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        quint32 idx;
+        stream >> idx;
+        dbDomains.push_back(domainAt(idx));
+    }
+
+    // profiles
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        quint16 id;
+        QString name;
+        QString description;
+        QString iconPath;
+        quint32 nDomains = 0;
+
+        stream >> id >> name >> description >> iconPath >> nDomains;
+
+        ZclProfile pro(id, name, description);
+        pro.setIconPath(iconPath);
+
+        for (quint32 j = 0; j < nDomains && stream.status() == QDataStream::Ok; j++)
+        {
+            quint32 idx;
+            stream >> idx;
+            pro.m_domains.push_back(domainAt(idx));
+        }
+
+        profiles.insert(id, pro);
+    }
+
+    // devices
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        quint16 id;
+        quint16 profileId;
+        QString name;
+        QString description;
+        QString iconPath;
+
+        stream >> id >> profileId >> name >> description >> iconPath;
+
+        ZclDevice dev(id, name, description);
+        dev.setProfileId(profileId);
+        dev.setIconPath(iconPath);
+        devices.push_back(dev);
+    }
+
+    if (stream.status() != QDataStream::Ok || !stream.atEnd())
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCLDB cache corrupt\n");
+        return false;
+    }
+
+    m_dataTypes = std::move(dataTypes);
+    m_enums = std::move(enums);
+    m_domains = std::move(dbDomains);
+    m_profiles = std::move(profiles);
+    m_devices = std::move(devices);
+    m_clusterCache.clear();
+    buildIndex();
+
+    DBG_Printf(DBG_ZCLDB, "ZCLDB loaded cache %s\n", qPrintable(path));
+
+    return true;
+}
+
+} // namespace deCONZ
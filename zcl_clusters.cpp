@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2012-2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "deconz/zcl_clusters.h"
+
+namespace deCONZ {
+
+constexpr ZclClusterId_t ZclOnOffAttributes::clusterId;
+constexpr ZclClusterId_t ZclLevelControlAttributes::clusterId;
+constexpr ZclClusterId_t ZclColorControlAttributes::clusterId;
+constexpr ZclClusterId_t ZclTemperatureAttributes::clusterId;
+constexpr ZclClusterId_t ZclHumidityAttributes::clusterId;
+constexpr ZclClusterId_t ZclIasZoneAttributes::clusterId;
+constexpr ZclClusterId_t ZclMeteringAttributes::clusterId;
+
+/*! Maps a attribute to a field of a decoder struct, the index in the table is the present bit. */
+struct ZclFieldInfo
+{
+    ZclAttributeId_t id;
+    ZclDataTypeId_t dataType;
+    uint16_t offset;
+    uint8_t size;
+};
+
+#define ZCL_FIELD(T, attrId, dataType, member) { attrId, dataType, uint16_t(offsetof(T, member)), uint8_t(sizeof(T::member)) }
+
+/*! Returns true if the fields are listed in declaration order, so the index matches the Present enum. */
+template <size_t N>
+static constexpr bool ZCL_FieldsOrdered(const ZclFieldInfo (&fields)[N], size_t i = 1)
+{
+    return i >= N || (fields[i - 1].offset < fields[i].offset && ZCL_FieldsOrdered(fields, i + 1));
+}
+
+static constexpr ZclFieldInfo onOffFields[] = {
+    ZCL_FIELD(ZclOnOffAttributes, 0x0000_atid, 0x10_dtid, onOff),
+    ZCL_FIELD(ZclOnOffAttributes, 0x4000_atid, 0x10_dtid, globalSceneControl),
+    ZCL_FIELD(ZclOnOffAttributes, 0x4001_atid, 0x21_dtid, onTime),
+    ZCL_FIELD(ZclOnOffAttributes, 0x4002_atid, 0x21_dtid, offWaitTime),
+    ZCL_FIELD(ZclOnOffAttributes, 0x4003_atid, 0x30_dtid, startUpOnOff)
+};
+
+static constexpr ZclFieldInfo levelControlFields[] = {
+    ZCL_FIELD(ZclLevelControlAttributes, 0x0000_atid, 0x20_dtid, currentLevel),
+    ZCL_FIELD(ZclLevelControlAttributes, 0x0001_atid, 0x21_dtid, remainingTime),
+    ZCL_FIELD(ZclLevelControlAttributes, 0x000F_atid, 0x18_dtid, options),
+    ZCL_FIELD(ZclLevelControlAttributes, 0x0010_atid, 0x21_dtid, onOffTransitionTime),
+    ZCL_FIELD(ZclLevelControlAttributes, 0x0011_atid, 0x20_dtid, onLevel),
+    ZCL_FIELD(ZclLevelControlAttributes, 0x4000_atid, 0x20_dtid, startUpCurrentLevel)
+};
+
+static constexpr ZclFieldInfo colorControlFields[] = {
+    ZCL_FIELD(ZclColorControlAttributes, 0x0000_atid, 0x20_dtid, currentHue),
+    ZCL_FIELD(ZclColorControlAttributes, 0x0001_atid, 0x20_dtid, currentSaturation),
+    ZCL_FIELD(ZclColorControlAttributes, 0x0002_atid, 0x21_dtid, remainingTime),
+    ZCL_FIELD(ZclColorControlAttributes, 0x0003_atid, 0x21_dtid, currentX),
+    ZCL_FIELD(ZclColorControlAttributes, 0x0004_atid, 0x21_dtid, currentY),
+    ZCL_FIELD(ZclColorControlAttributes, 0x0007_atid, 0x21_dtid, colorTemperature),
+    ZCL_FIELD(ZclColorControlAttributes, 0x0008_atid, 0x30_dtid, colorMode),
+    ZCL_FIELD(ZclColorControlAttributes, 0x4000_atid, 0x21_dtid, enhancedCurrentHue),
+    ZCL_FIELD(ZclColorControlAttributes, 0x4001_atid, 0x30_dtid, enhancedColorMode),
+    ZCL_FIELD(ZclColorControlAttributes, 0x400A_atid, 0x19_dtid, colorCapabilities),
+    ZCL_FIELD(ZclColorControlAttributes, 0x400B_atid, 0x21_dtid, colorTempPhysicalMin),
+    ZCL_FIELD(ZclColorControlAttributes, 0x400C_atid, 0x21_dtid, colorTempPhysicalMax)
+};
+
+static constexpr ZclFieldInfo temperatureFields[] = {
+    ZCL_FIELD(ZclTemperatureAttributes, 0x0000_atid, 0x29_dtid, measuredValue),
+    ZCL_FIELD(ZclTemperatureAttributes, 0x0001_atid, 0x29_dtid, minMeasuredValue),
+    ZCL_FIELD(ZclTemperatureAttributes, 0x0002_atid, 0x29_dtid, maxMeasuredValue),
+    ZCL_FIELD(ZclTemperatureAttributes, 0x0003_atid, 0x21_dtid, tolerance)
+};
+
+static constexpr ZclFieldInfo humidityFields[] = {
+    ZCL_FIELD(ZclHumidityAttributes, 0x0000_atid, 0x21_dtid, measuredValue),
+    ZCL_FIELD(ZclHumidityAttributes, 0x0001_atid, 0x21_dtid, minMeasuredValue),
+    ZCL_FIELD(ZclHumidityAttributes, 0x0002_atid, 0x21_dtid, maxMeasuredValue),
+    ZCL_FIELD(ZclHumidityAttributes, 0x0003_atid, 0x21_dtid, tolerance)
+};
+
+static constexpr ZclFieldInfo iasZoneFields[] = {
+    ZCL_FIELD(ZclIasZoneAttributes, 0x0000_atid, 0x30_dtid, zoneState),
+    ZCL_FIELD(ZclIasZoneAttributes, 0x0001_atid, 0x31_dtid, zoneType),
+    ZCL_FIELD(ZclIasZoneAttributes, 0x0002_atid, 0x19_dtid, zoneStatus),
+    ZCL_FIELD(ZclIasZoneAttributes, 0x0010_atid, 0xF0_dtid, iasCieAddress),
+    ZCL_FIELD(ZclIasZoneAttributes, 0x0011_atid, 0x20_dtid, zoneId)
+};
+
+static constexpr ZclFieldInfo meteringFields[] = {
+    ZCL_FIELD(ZclMeteringAttributes, 0x0000_atid, 0x25_dtid, currentSummationDelivered),
+    ZCL_FIELD(ZclMeteringAttributes, 0x0001_atid, 0x25_dtid, currentSummationReceived),
+    ZCL_FIELD(ZclMeteringAttributes, 0x0200_atid, 0x18_dtid, status),
+    ZCL_FIELD(ZclMeteringAttributes, 0x0300_atid, 0x30_dtid, unitOfMeasure),
+    ZCL_FIELD(ZclMeteringAttributes, 0x0301_atid, 0x22_dtid, multiplier),
+    ZCL_FIELD(ZclMeteringAttributes, 0x0302_atid, 0x22_dtid, divisor),
+    ZCL_FIELD(ZclMeteringAttributes, 0x0306_atid, 0x18_dtid, meteringDeviceType),
+    ZCL_FIELD(ZclMeteringAttributes, 0x0400_atid, 0x2A_dtid, instantaneousDemand)
+};
+
+#define ZCL_CHECK_FIELDS(fields, lastBit) \
+    static_assert(ZCL_FieldsOrdered(fields), #fields " not in declaration order"); \
+    static_assert((1u << (sizeof(fields) / sizeof(fields[0]) - 1)) == uint32_t(lastBit), #fields " doesn't match Present enum")
+
+ZCL_CHECK_FIELDS(onOffFields, ZclOnOffAttributes::HasStartUpOnOff);
+ZCL_CHECK_FIELDS(levelControlFields, ZclLevelControlAttributes::HasStartUpCurrentLevel);
+ZCL_CHECK_FIELDS(colorControlFields, ZclColorControlAttributes::HasColorTempPhysicalMax);
+ZCL_CHECK_FIELDS(temperatureFields, ZclTemperatureAttributes::HasTolerance);
+ZCL_CHECK_FIELDS(humidityFields, ZclHumidityAttributes::HasTolerance);
+ZCL_CHECK_FIELDS(iasZoneFields, ZclIasZoneAttributes::HasZoneId);
+ZCL_CHECK_FIELDS(meteringFields, ZclMeteringAttributes::HasInstantaneousDemand);
+
+template <typename T, size_t N>
+static bool decodeField(const ZclAttributeRecord &rec, T &out, const ZclFieldInfo (&fields)[N])
+{
+    static_assert(N <= 32, "present bitmap has 32 bits");
+    static_assert(std::is_standard_layout<T>::value, "offsetof() requires standard layout");
+
+    const ZclAttributeId_t id(rec.id);
+
+    for (size_t i = 0; i < N; i++)
+    {
+        if (fields[i].id != id)
+        {
+            continue;
+        }
+
+        if (fields[i].dataType != ZclDataTypeId_t(rec.dataType) || !rec.data)
+        {
+            return false; // unexpected data type, let the generic decoder handle it
+        }
+
+        const uint64_t value = rec.numericValue.u64; // signed integers are sign extended
+        uint8_t *p = reinterpret_cast<uint8_t*>(&out) + fields[i].offset;
+
+        switch (fields[i].size)
+        {
+        case 1: { const uint8_t v = uint8_t(value); memcpy(p, &v, sizeof(v)); } break;
+        case 2: { const uint16_t v = uint16_t(value); memcpy(p, &v, sizeof(v)); } break;
+        case 4: { const uint32_t v = uint32_t(value); memcpy(p, &v, sizeof(v)); } break;
+        case 8: { memcpy(p, &value, sizeof(value)); } break;
+        default:
+            return false;
+        }
+
+        out.present |= uint32_t(1) << i;
+        return true;
+    }
+
+    return false;
+}
+
+bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclOnOffAttributes &out)
+{
+    return decodeField(rec, out, onOffFields);
+}
+
+bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclLevelControlAttributes &out)
+{
+    return decodeField(rec, out, levelControlFields);
+}
+
+bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclColorControlAttributes &out)
+{
+    return decodeField(rec, out, colorControlFields);
+}
+
+bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclTemperatureAttributes &out)
+{
+    return decodeField(rec, out, temperatureFields);
+}
+
+bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclHumidityAttributes &out)
+{
+    return decodeField(rec, out, humidityFields);
+}
+
+bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclIasZoneAttributes &out)
+{
+    return decodeField(rec, out, iasZoneFields);
+}
+
+bool ZCL_DecodeAttribute(const ZclAttributeRecord &rec, ZclMeteringAttributes &out)
+{
+    return decodeField(rec, out, meteringFields);
+}
+
+} // namespace deCONZ
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2012-2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+/*
+ * Per file partial databases and parallel loading of the ZCLDB.
+ *
+ * The first file (general.xml) defines data types, enumerations, the
+ * standard domains and the profiles, it is parsed into the base part which
+ * is adopted by the cleared database. All further files are parsed into
+ * partial databases which are seeded with the data types and enumerations,
+ * with parallel loading concurrently. Afterwards the partial results are
+ * merged in file order, so the outcome equals a sequential load.
+ *
+ * A partial database can only be merged when the file adds domains,
+ * clusters and devices. Profiles capture domains at parse time and new
+ * data types or enumerations may be used by later files, in these cases
+ * the file and all following files are loaded directly instead.
+ *
+ * The parts are kept with the SHA-256 of their file, reloadChanged() only
+ * parses files whose hash changed. Since all parts are seeded from the base
+ * part, a changed first file requires to parse all files again.
+ */
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "deconz/dbg_trace.h"
+#include "deconz/u_threads.h"
+#include "deconz/zcl.h"
+#include "zcl_private.h"
+
+#define ZCL_LOAD_MAX_THREADS 4
+
+namespace deCONZ {
+
+/*! Shared state of the load threads. */
+struct ZclParallelLoad
+{
+    const std::vector<ZclFilePart*> *parts = nullptr;
+    std::atomic<int> next{0};
+};
+
+/*! Thread function, loads files into partial databases until all are taken. */
+void ZclDataBase::loadPartials(void *arg)
+{
+    ZclParallelLoad *job = static_cast<ZclParallelLoad*>(arg);
+
+    for (;;)
+    {
+        const int i = job->next++;
+        if (i >= int(job->parts->size()))
+        {
+            break;
+        }
+
+        ZclFilePart *part = (*job->parts)[size_t(i)];
+        part->db->load(part->path);
+    }
+}
+
+/*! Loads \p files into the cleared database.
+
+    Each file is parsed into a partial database which is kept in m_fileParts.
+    A kept part whose path and SHA-256 equals the one in \p hashes is reused,
+    only the other files are parsed. The parts are merged in file order.
+ */
+void ZclDataBase::loadParts(const QStringList &files, const std::vector<QByteArray> &hashes)
+{
+    std::vector<ZclFilePart> kept = std::move(m_fileParts);
+    std::vector<ZclFilePart> parts(size_t(files.size()));
+    m_fileParts.clear();
+
+    if (parts.empty())
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+        ZclFilePart &part = parts[i];
+        part.path = files.at(int(i));
+        part.hash = i < hashes.size() ? hashes[i] : QByteArray();
+
+        for (ZclFilePart &k : kept)
+        {
+            if (k.db && !part.hash.isEmpty() && k.hash == part.hash && k.path == part.path)
+            {
+                part.db = std::move(k.db);
+                break;
+            }
+        }
+    }
+
+    // all parts are seeded with the data types and enumerations of the base part
+    if (!parts[0].db)
+    {
+        for (ZclFilePart &part : parts)
+        {
+            part.db.reset();
+        }
+
+        parts[0].db.reset(new ZclDataBase(this));
+        parts[0].db->load(parts[0].path);
+    }
+
+    adoptBase(*parts[0].db);
+
+    std::vector<ZclFilePart*> changed;
+    for (size_t i = 1; i < parts.size(); i++)
+    {
+        if (!parts[i].db)
+        {
+            parts[i].db.reset(new ZclDataBase(this));
+            changed.push_back(&parts[i]);
+        }
+    }
+
+    parseParts(changed);
+
+    for (size_t i = 1; i < parts.size(); i++)
+    {
+        if (mergePartial(*parts[i].db))
+        {
+            continue;
+        }
+
+        DBG_Printf(DBG_ZCLDB, "ZCLDB %s defines profiles or types, load remaining files sequentially\n", qPrintable(parts[i].path));
+
+        for (; i < parts.size(); i++)
+        {
+            parts[i].db.reset();
+            load(parts[i].path);
+        }
+    }
+
+    buildIndex();
+    m_fileParts = std::move(parts);
+}
+
+/*! Parses the files of \p parts into their partial databases, on worker threads if parallel loading is enabled. */
+void ZclDataBase::parseParts(const std::vector<ZclFilePart*> &parts)
+{
+    ZclParallelLoad job;
+    job.parts = &parts;
+
+    U_Thread threads[ZCL_LOAD_MAX_THREADS];
+    unsigned nthreads = 0;
+
+    if (m_parallelLoading && parts.size() > 1)
+    {
+        nthreads = std::thread::hardware_concurrency();
+        nthreads = nthreads > 1 ? nthreads - 1 : 0; // the calling thread helps too
+        nthreads = std::min(nthreads, unsigned(ZCL_LOAD_MAX_THREADS));
+        nthreads = std::min(nthreads, unsigned(parts.size() - 1));
+    }
+
+    unsigned started = 0;
+    for (; started < nthreads; started++)
+    {
+        if (U_thread_create(&threads[started], loadPartials, &job) == 0)
+        {
+            DBG_Printf(DBG_ZCLDB, "ZCLDB failed to create load thread\n");
+            break;
+        }
+    }
+
+    loadPartials(&job);
+
+    for (unsigned i = 0; i < started; i++)
+    {
+        U_thread_join(&threads[i]);
+    }
+
+    DBG_Printf(DBG_ZCLDB, "ZCLDB parsed %d files with %u threads\n", int(parts.size()), started + 1);
+}
+
+/*! Takes over the parse result of the first file \p base into the cleared database. */
+void ZclDataBase::adoptBase(const ZclDataBase &base)
+{
+    m_enums = base.m_enums;
+    m_dataTypes = base.m_dataTypes;
+    m_domains = base.m_domains;
+    m_profiles = base.m_profiles;
+    m_devices = base.m_devices;
+    m_lazyClusters = base.m_lazyClusters;
+    m_useZclDomains = base.m_useZclDomains;
+    m_internedStrings = base.m_internedStrings;
+    buildIndex();
+}
+
+/*! Merges the partial database \p part into this one, like it would have been loaded directly.
+
+    \returns false if \p part can't be merged, nothing is changed then.
+ */
+bool ZclDataBase::mergePartial(ZclDataBase &part)
+{
+    if (!part.m_profiles.isEmpty() || part.m_enums.size() != m_enums.size() || part.typesDigest() != typesDigest())
+    {
+        return false;
+    }
+
+    m_internedStrings.unite(part.m_internedStrings); // equal strings of different files stay separate instances
+
+    // lazy index entries of part are appended, their indexes shift by offset
+    const int offset = int(m_lazyClusters.size());
+    m_lazyClusters.insert(m_lazyClusters.end(), part.m_lazyClusters.begin(), part.m_lazyClusters.end());
+
+    for (const ZclDomain &pd : part.m_domains)
+    {
+        ZclDomain dom = domain(pd.name());
+        const bool existed = dom.isValid();
+
+        // without useZcl attribute the former value is kept
+        bool useZcl = pd.useZcl();
+        if (existed && !part.m_useZclDomains.contains(pd.name().toLower()))
+        {
+            useZcl = dom.useZcl();
+        }
+        else if (part.m_useZclDomains.contains(pd.name().toLower()))
+        {
+            m_useZclDomains.insert(pd.name().toLower());
+        }
+
+        dom.setName(pd.name());
+        dom.setDescription(pd.description());
+        dom.setUseZcl(useZcl);
+
+        const auto insert = [&dom, useZcl](QHash<uint32_t, ZclCluster> &clusters, uint32_t key, const ZclCluster &cl)
+        {
+            ZclCluster c = cl;
+            if (c.isZcl() != useZcl)
+            {
+                c.setIsZcl(useZcl);
+            }
+            clusters.insert(key, c);
+        };
+
+        for (auto i = pd.m_inClusters.cbegin(); i != pd.m_inClusters.cend(); ++i)
+        {
+            resolveLazyCluster(dom, i.key()); // a former definition is updated
+            insert(dom.m_inClusters, i.key(), i.value());
+        }
+
+        for (auto i = pd.m_outClusters.cbegin(); i != pd.m_outClusters.cend(); ++i)
+        {
+            resolveLazyCluster(dom, i.key());
+            insert(dom.m_outClusters, i.key(), i.value());
+        }
+
+        for (auto i = pd.m_lazyIndex.cbegin(); i != pd.m_lazyIndex.cend(); ++i)
+        {
+            const int index = offset + i.value();
+            m_lazyClusters[size_t(index)].useZcl = useZcl;
+
+            if (!dom.m_inClusters.contains(i.key()) && !dom.m_outClusters.contains(i.key()) && !dom.m_lazyIndex.contains(i.key()))
+            {
+                dom.m_lazyIndex.insert(i.key(), index);
+                continue;
+            }
+
+            // already defined, a sequential load would have parsed the element right away
+            resolveLazyCluster(dom, i.key());
+            const ZclLazyCluster &lc = materialize(index);
+
+            if (lc.hasServer)
+            {
+                insert(dom.m_inClusters, i.key(), lc.server);
+            }
+
+            if (lc.hasClient)
+            {
+                insert(dom.m_outClusters, i.key(), lc.client);
+            }
+        }
+
+        addDomain(dom);
+    }
+
+    for (const ZclDevice &device : part.m_devices)
+    {
+        bool known = false;
+
+        for (auto &dev : m_devices)
+        {
+            if (dev.id() == device.id() && dev.name() == device.name())
+            {
+                dev = device; // update
+                known = true;
+                break;
+            }
+        }
+
+        if (!known)
+        {
+            m_devices.push_back(device);
+        }
+    }
+
+    return true;
+}
+
+} // namespace deCONZ
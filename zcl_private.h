@@ -11,14 +11,22 @@
 #ifndef ZCL_PRIVATE_H
 #define ZCL_PRIVATE_H
 
+#include <QSet>
 #include <QString>
 #include <QIcon>
+#include <array>
+#include <atomic>
 #include <cinttypes>
+#include <memory>
 #include "deconz/declspec.h"
 
+class QXmlStreamReader;
+
 namespace deCONZ
 {
 
+struct ZclLoadContext;
+
 class Enumeration
 {
 public:
@@ -50,6 +58,63 @@ private:
     QString m_name;
 };
 
+/*!
+    Schema part of a ZclAttribute as defined in the ZCLDB.
+
+    The schema is shared between all copies of an attribute, e.g. the per node
+    attributes copied from a ZclDataBase cluster. It is only copied when modified,
+    see ZclAttributeSchemaRef::detach().
+ */
+class ZclAttributeSchema
+{
+public:
+    std::atomic<int> ref{0}; //!< Number of ZclAttributeSchemaRef objects sharing this schema.
+    QString m_name;
+    QString m_description;
+    std::vector<int> m_valuePos;
+    QStringList m_valueNames;
+    ZclAccess m_access = ZclRead;
+    uint8_t m_enumerationId = 0xFF; //!<  Id of a enumeration repository.
+    uint8_t m_numericBase = 10; //!< For numeric data types.
+    bool m_required = false; //!< True if mandatory.
+
+    /*!
+         If this is a list here is the attribute id wich holds the list size.
+         if set to 0xFFFF this is no list.
+     */
+    uint16_t m_listSizeAttr = 0xFFFF;
+    quint16 m_manufacturerCode = 0;
+    quint16 m_attrSetId = 0xFFFF;
+    quint16 m_attrSetManufacturerCode = 0;
+    ZclAttribute::FormatHint m_formatHint = ZclAttribute::DefaultFormat;
+    int m_rangeMin = 0;
+    int m_rangeMax = 0;
+};
+
+/*!
+    Reference counted handle to a ZclAttributeSchema.
+
+    Read access via operator->() is const, modifications require detach().
+    A default constructed handle refers to a shared schema with default values.
+ */
+class ZclAttributeSchemaRef
+{
+public:
+    ZclAttributeSchemaRef();
+    ZclAttributeSchemaRef(const ZclAttributeSchemaRef &other);
+    ZclAttributeSchemaRef &operator=(const ZclAttributeSchemaRef &other);
+    ~ZclAttributeSchemaRef();
+    const ZclAttributeSchema *operator->() const { return m_schema; }
+    ZclAttributeSchema *detach();
+
+private:
+    ZclAttributeSchema *m_schema = nullptr;
+};
+
+/*!
+    Per attribute value and reporting state, the schema data is shared
+    via m_schema.
+ */
 class ZclAttributePrivate
 {
 public:
@@ -60,34 +125,53 @@ public:
     uint16_t m_id = 0xFFFF;
     uint8_t m_dataType = 0xFF;
     uint8_t m_subType = 0xFF;
-    QString m_name;
-    QString m_description;
-    ZclAccess m_access = ZclRead;
-    uint8_t m_enumerationId = 0xFF; //!<  Id of a enumeration repository.
-    uint8_t m_numericBase = 10; //!< For numeric data types.
-    bool m_required = false; //!< True if mandatory.
     bool m_avail = true; //!< Attribute is available in the cluster.
     union {
         int idx; //!< index into a list
         uint64_t bitmap; //!< bitmap bits set
     } m_valueState;
 
+    /*!
+        Tells where the current value is stored. Numeric values are only kept in
+        m_numericValue or m_valueState.bitmap, the QVariant m_value is built on
+        demand by value(). This keeps QVariant conversions out of the update path.
+     */
+    enum ValueKind : uint8_t
+    {
+        ValueVariant,     //!< m_value holds the value (strings, lists, ...)
+        ValueBool,        //!< bool(m_numericValue.u8)
+        ValueUInt8,       //!< uint(m_numericValue.u8)
+        ValueUInt16,      //!< uint(m_numericValue.u16)
+        ValueUInt16AsInt, //!< int(m_numericValue.u16)
+        ValueUInt32,      //!< uint(m_numericValue.u32)
+        ValueUInt64,      //!< quint64(m_numericValue.u64)
+        ValueInt8,        //!< int(m_numericValue.s8)
+        ValueInt16,       //!< int(m_numericValue.s16)
+        ValueInt32,       //!< int(m_numericValue.s32)
+        ValueInt64,       //!< qint64(m_numericValue.s64)
+        ValueReal,        //!< qreal(m_numericValue.real)
+        ValueBitmap       //!< quint64(m_valueState.bitmap)
+    };
+
+    /*! Sets a non numeric value. */
+    void setVariant(const QVariant &value)
+    {
+        m_value = value;
+        m_valueKind = ValueVariant;
+    }
+
+    const QVariant &value() const;
+
+    mutable uint8_t m_valueKind = ValueVariant;
+
     /*!
         May hold a value or the static content like enumeration or
         bitmap values. If so the m_valueInfo.(idx|bitmap) is used
         to optain the real value.
      */
-    QVariant m_value;
+    mutable QVariant m_value;
     NumericUnion m_numericValue{}; //!< Numeric data.
-    std::vector<int> m_valuePos;
-    QStringList m_valueNames;
     int64_t m_lastRead = -1;
-
-    /*!
-         If this is a list here is the attribute id wich holds the list size.
-         if set to 0xFFFF this is no list.
-     */
-    uint16_t m_listSizeAttr = 0xFFFF;
     int m_listSize = 0; //!< Current size of the list.
 
     // reporting
@@ -96,14 +180,7 @@ public:
     uint16_t m_reportTimeout = 0; //!< Report timeout period.
     NumericUnion m_reportableChange{}; //!< Reportable change.
 
-    ZclAttribute::FormatHint m_formatHint = ZclAttribute::DefaultFormat;
-    int m_rangeMin = 0;
-    int m_rangeMax = 0;
-
-    quint16 m_manufacturerCode = 0;
-
-    quint16 m_attrSetId = 0xFFFF;
-    quint16 m_attrSetManufacturerCode = 0;
+    ZclAttributeSchemaRef m_schema;
 };
 
 class ZclAttributeSetPrivate
@@ -116,10 +193,19 @@ public:
     std::vector<int> attributeIndexes;
 };
 
+/*!
+    Cluster data is shared between ZclCluster copies and only copied
+    on the first modification (copy-on-write), see ZclCluster::detach().
+    Clusters returned from the ZclDataBase therefore don't take extra memory
+    as long as they aren't modified.
+ */
 class ZclClusterPrivate
 {
 public:
     ZclClusterPrivate();
+    ZclClusterPrivate(const ZclClusterPrivate &other);
+    ZclClusterPrivate &operator=(const ZclClusterPrivate &) = delete;
+    std::atomic<int> ref{1}; //!< Number of ZclCluster objects sharing this data.
     uint16_t id;
     uint16_t oppositeId;
     uint16_t manufacturerCode;
@@ -130,6 +216,12 @@ public:
     std::vector<ZclAttribute> attributes;
     std::vector<ZclAttributeSet> attributeSets;
     std::vector<ZclCommand> commands;
+    /*!
+        Lookup of commands, built on first use, key: mfcode << 16 | flags << 8 | command id.
+        Copied along with the commands, invalidated when commands are modified.
+     */
+    mutable QHash<quint32, int> commandIndex;
+    mutable bool commandIndexValid = false;
 };
 
 class ZclFramePrivate
@@ -178,6 +270,26 @@ public:
     std::vector<ZclAttribute> m_payload;
 };
 
+/*!
+    Index entry of a <cluster> element which is parsed on first use,
+    see ZclDataBase::setLazyLoading().
+ */
+class ZclLazyCluster
+{
+public:
+    QString path; //!< ZCLDB file containing the element.
+    qint64 offset = 0; //!< Byte offset of the <cluster> element.
+    qint64 length = 0; //!< Byte length of the <cluster> element.
+    quint32 hash = 0; //!< Cluster key as used in ZclDomain cluster lists.
+    bool useZcl = true; //!< ZclDomain::useZcl() at the time the element was indexed.
+    QByteArray digest; //!< SHA-256 of the element bytes, compared by ZclDataBase::reloadChanged().
+    bool materialized = false;
+    bool hasServer = false;
+    bool hasClient = false;
+    ZclCluster server;
+    ZclCluster client;
+};
+
 // TODO: place in private header and hide in public release
 class DECONZ_DLLSPEC ZclDomain
 {
@@ -198,24 +310,32 @@ public:
     void setName(const QString &name) { m_name = name; }
     const QString &description() const { return m_description; }
     void setDescription(const QString &description) { m_description = description; }
+    /*! In lazy loading mode only clusters which are already parsed are listed. */
     const QHash<uint32_t, ZclCluster> &inClusters() const { return m_inClusters; }
+    /*! In lazy loading mode only clusters which are already parsed are listed. */
     const QHash<uint32_t, ZclCluster> &outClusters() const { return m_outClusters; }
     bool isValid() const { return !m_name.isEmpty(); }
 
 private:
     friend class ZclDataBase;
+    friend class ZclDataBaseSnapshot;
     bool m_useZcl;
     QString m_name;
     QString m_description;
     QHash<uint32_t, ZclCluster> m_inClusters;
     QHash<uint32_t, ZclCluster> m_outClusters;
+    /*!
+        Not yet parsed clusters, value is a index into ZclDataBase::m_lazyClusters.
+        The index is shared by all copies of the domain.
+     */
+    QHash<uint32_t, int> m_lazyIndex;
 };
 
 class DECONZ_DLLSPEC ZclDevice
 {
 public:
     ZclDevice() : m_deviceId(0xFFFF), m_profileId(0xFFFF) {}
-    ZclDevice(uint16_t id, const QString &name, const QString &description, const QIcon &icon) :
+    ZclDevice(uint16_t id, const QString &name, const QString &description, const QIcon &icon = QIcon()) :
         m_deviceId(id),
         m_profileId(0xFFFF),
         m_name(name),
@@ -233,14 +353,25 @@ public:
     void setProfileId(uint16_t id) { m_profileId = id; }
     const QString &name() const { return m_name; }
     const QString &description() const { return m_description; }
-    const QIcon &icon() const { return m_icon; }
+    /*! Returns the icon, it is loaded from iconPath() on first call. */
+    const QIcon &icon() const
+    {
+        if (m_icon.isNull() && !m_iconPath.isEmpty())
+        {
+            m_icon = QIcon(m_iconPath);
+        }
+        return m_icon;
+    }
+    const QString &iconPath() const { return m_iconPath; }
+    void setIconPath(const QString &iconPath) { m_iconPath = iconPath; m_icon = QIcon(); }
 
 private:
     uint16_t m_deviceId;
     uint16_t m_profileId;
     QString m_name;
     QString m_description;
-    QIcon m_icon;
+    mutable QIcon m_icon;
+    QString m_iconPath; //!< Resolved icon file path, empty if the icon doesn't exist.
 };
 
 // TODO: place in private header and hide in public release
@@ -248,7 +379,7 @@ class DECONZ_DLLSPEC ZclProfile
 {
 public:
     ZclProfile() : m_id(0xFFFF) {}
-    ZclProfile(uint16_t id, const QString &name, const QString &description, const QIcon &icon) :
+    ZclProfile(uint16_t id, const QString &name, const QString &description, const QIcon &icon = QIcon()) :
         m_id(id),
         m_name(name),
         m_description(description),
@@ -265,8 +396,18 @@ public:
     void setName(const QString &name) { m_name = name; }
     const QString &description() const { return m_description; }
     void setDescription(const QString &description) { m_description = description; }
-    const QIcon &icon() const { return m_icon; }
+    /*! Returns the icon, if not set explicitly it is loaded from iconPath() on first call. */
+    const QIcon &icon() const
+    {
+        if (m_icon.isNull() && !m_iconPath.isEmpty())
+        {
+            m_icon = QIcon(m_iconPath);
+        }
+        return m_icon;
+    }
     void setIcon(const QIcon &icon) { m_icon = icon; }
+    const QString &iconPath() const { return m_iconPath; }
+    void setIconPath(const QString &iconPath) { m_iconPath = iconPath; m_icon = QIcon(); }
     const std::vector<ZclDomain> &domains() const { return m_domains; }
     void addDomain(const ZclDomain &domain);
     bool isValid() const { return (m_id != 0xFFFF); }
@@ -277,10 +418,93 @@ private:
     uint16_t m_id;
     QString m_name;
     QString m_description;
-    QIcon m_icon;
+    mutable QIcon m_icon;
+    QString m_iconPath; //!< Resolved icon file path, empty if the icon doesn't exist.
     std::vector<ZclDomain> m_domains;
 };
 
+/*! Identifies a cluster which changed in a ZCLDB reload. */
+struct ZclClusterKey
+{
+    uint16_t profileId;
+    uint16_t clusterId;
+    uint16_t manufacturerCode; //!< Only set for manufacturer specific clusters >= 0xFC00.
+};
+
+/*! Result of ZclDataBase::reloadChanged().
+
+    Lists the clusters whose definition was added, removed or modified. Objects
+    previously returned by inCluster() or outCluster() for these keys are outdated.
+ */
+class DECONZ_DLLSPEC ZclChangeSet
+{
+public:
+    /*! Returns true if nothing changed. */
+    bool isEmpty() const { return !m_full && m_clusters.empty(); }
+    /*! Returns true if data types or enumerations changed, all clusters should be refreshed. */
+    bool isFull() const { return m_full; }
+    const std::vector<ZclClusterKey> &clusters() const { return m_clusters; }
+    bool contains(uint16_t profileId, uint16_t clusterId, uint16_t mfcode) const;
+
+private:
+    friend class ZclDataBase;
+    bool m_full = false;
+    std::vector<ZclClusterKey> m_clusters;
+};
+
+class ZclSnapshotLazy;
+class ZclDataBase;
+
+/*! A ZCLDB file parsed into its own partial database, see ZclDataBase::loadParts(). */
+struct ZclFilePart
+{
+    QString path;
+    QByteArray hash; //!< SHA-256 of the file content, empty if unknown.
+    std::unique_ptr<ZclDataBase> db; //!< Partial database, nullptr if the file was loaded directly.
+};
+
+/*! Immutable version of the ZCLDB, see ZclDataBase::snapshot().
+
+    A snapshot is never modified after it was published and no lookup caches
+    are maintained. Therefore it can be used from any thread as long as a
+    reference is held.
+
+    In lazy loading mode clusters which weren't parsed before publishing stay
+    in the lazy index, they are parsed on first use by a private parser of the
+    snapshot. Only this step is serialized by a mutex.
+ */
+class DECONZ_DLLSPEC ZclDataBaseSnapshot
+{
+public:
+    ZclDataBaseSnapshot();
+    /*! Returns the version, incremented with each published snapshot. */
+    unsigned version() const { return m_version; }
+    ZclCluster inCluster(uint16_t profileId, uint16_t clusterId, quint16 mfcode) const;
+    ZclCluster outCluster(uint16_t profileId, uint16_t clusterId, quint16 mfcode) const;
+    const ZclDataType &dataType(uint8_t id) const;
+    const ZclDataType &dataType(const QString &shortName) const;
+    const Enumeration *enumeration(uint id) const;
+    ZclDevice device(uint16_t profileId, uint16_t deviceId) const;
+
+private:
+    friend class ZclDataBase;
+    const ZclCluster *findCluster(uint16_t profileId, uint16_t clusterId, quint16 mfcode, bool server) const;
+
+    unsigned m_version = 0;
+    QHash<uint16_t, ZclProfile> m_profiles; //!< Domain lazy indexes refer to m_lazy.
+    std::shared_ptr<ZclSnapshotLazy> m_lazy; //!< nullptr if there are no lazy indexed clusters.
+    std::vector<ZclDataType> m_dataTypes;
+    std::array<int16_t, 256> m_dataTypeIndex;
+    QHash<QString, int> m_dataTypeNameIndex;
+    std::vector<deCONZ::Enumeration> m_enums;
+    QHash<uint, int> m_enumIndex;
+    std::vector<ZclDevice> m_devices;
+    QHash<quint32, int> m_deviceIndex;
+    ZclDataType m_unknownDataType;
+};
+
+typedef std::shared_ptr<const ZclDataBaseSnapshot> ZclSnapshotPtr;
+
 // TODO: place in private header and hide in public release
 class DECONZ_DLLSPEC ZclDataBase
 {
@@ -298,24 +522,108 @@ public:
     ZclDevice device(uint16_t profileId, uint16_t deviceId);
     bool getEnumeration(uint id, deCONZ::Enumeration &out)
     {
-        for (const auto &e : m_enums)
+        const Enumeration *e = enumeration(id);
+        if (e)
         {
-            if (e.id() == id)
-            {
-                out = e;
-                return true;
-            }
+            out = *e;
+            return true;
         }
 
         return false;
     }
+    /*! Returns the enumeration \p id or nullptr if not found, the pointer is valid until the next load. */
+    const Enumeration *enumeration(uint id) const;
     void load(const QString &dbfile);
+    /*! Enables or disables lazy loading, must be set before load() or reloadAll().
+
+        In lazy loading mode only a index of the <cluster> elements is created while
+        loading. A cluster is parsed the first time it is requested by inCluster()
+        or outCluster().
+     */
+    void setLazyLoading(bool enabled);
+    bool lazyLoading() const;
+    /*! Enables or disables interning of schema strings, must be set before load() or reloadAll().
+
+        Names, descriptions and value names of clusters, attributes and commands are
+        kept in a set owned by the database. Equal strings then share the same QString
+        data, copies only hold a reference. The set is released by clear().
+        With parallel loading equal strings of different files aren't shared.
+     */
+    void setInternStrings(bool enabled);
+    bool internStrings() const;
+    QString intern(const QString &str);
+    /*! Enables or disables headless mode, must be set before load() or reloadAll().
+
+        In headless mode icon files of profiles and devices aren't resolved,
+        icon() returns a null icon and iconPath() is empty.
+     */
+    void setHeadless(bool enabled);
+    bool headless() const;
+    /*! Enables or disables parallel loading, must be set before reloadAll().
+
+        Each file is parsed into a partial database which are merged in file order.
+        With parallel loading the files after the first one (general.xml) are parsed
+        on worker threads.
+     */
+    void setParallelLoading(bool enabled);
+    bool parallelLoading() const;
     void initDbFile(const QString &zclFile);
     void reloadAll(const QString &zclFile);
+    ZclChangeSet reloadChanged(const QString &zclFile);
+    /*! Returns the current immutable database version, safe to call from any thread.
+
+        Readers keep the returned reference as long as they need it, a reload
+        publishes a new version without affecting existing references.
+     */
+    ZclSnapshotPtr snapshot() const;
+    /*! Publishes the current state as new snapshot.
+
+        Called by reloadAll() and reloadChanged(), only needed after manual
+        load(), addDomain() or addProfile() calls. Must be called from the
+        thread which owns the database.
+     */
+    void publishSnapshot();
     void clear();
     bool knownDataType(uint8_t id);
 
 private:
+    friend class ZclSnapshotLazy;
+    explicit ZclDataBase(const ZclDataBase *base);
+    static void freezeCluster(const ZclCluster &cl);
+    void parse(QXmlStreamReader &xml, ZclLoadContext &ctx);
+    bool recordLazyCluster(QXmlStreamReader &xml, ZclLoadContext &ctx, ZclDomain &domain, quint32 hash);
+    void resolveLazyCluster(ZclDomain &domain, quint32 hash);
+    const ZclLazyCluster &materialize(int index);
+    QStringList dbFiles(const QString &zclFile) const;
+    void loadFiles(const QStringList &files, const QString &cacheFile, const QByteArray &key, const std::vector<QByteArray> &hashes);
+
+    // per file partial databases and parallel loading, see zcl_parallel.cpp
+    void loadParts(const QStringList &files, const std::vector<QByteArray> &hashes);
+    void parseParts(const std::vector<ZclFilePart*> &parts);
+    void adoptBase(const ZclDataBase &base);
+    bool mergePartial(ZclDataBase &part);
+    static void loadPartials(void *arg);
+
+    // incremental reload, see zcl_reload.cpp
+    QByteArray typesDigest() const;
+    static QByteArray clusterDigest(const ZclCluster &cl);
+    static QByteArray domainDigest(const ZclDomain &dom, const std::vector<ZclLazyCluster> &lazyClusters, QHash<quint64, QByteArray> *clusters);
+    void diffProfiles(const QHash<uint16_t, ZclProfile> &oldProfiles, const std::vector<ZclLazyCluster> &oldLazyClusters, ZclChangeSet &changes) const;
+
+    // binary cache, see zcl_cache.cpp
+    QByteArray cacheKey(const QStringList &files, std::vector<QByteArray> *fileHashes = nullptr) const;
+    bool loadCache(const QString &path, const QByteArray &key);
+    bool saveCache(const QString &path, const QByteArray &key) const;
+    static void writeAttribute(QDataStream &stream, const ZclAttribute &attr);
+    void readAttribute(QDataStream &stream, ZclAttribute &attr);
+    static void writeCommand(QDataStream &stream, const ZclCommand &cmd);
+    void readCommand(QDataStream &stream, ZclCommand &cmd);
+    static void writeCluster(QDataStream &stream, const ZclCluster &cl);
+    void readCluster(QDataStream &stream, ZclCluster &cl);
+    static void writeDomain(QDataStream &stream, const ZclDomain &dom);
+    void readDomain(QDataStream &stream, ZclDomain &dom);
+    void buildIndex();
+
     std::vector<deCONZ::Enumeration> m_enums;
     ZclCluster m_unknownCluster;
     ZclDataType m_unknownDataType;
@@ -328,9 +636,39 @@ private:
      */
     std::vector<ZclDevice> m_devices;
     QString m_iconPath;
+    QByteArray m_sourceKey; //!< cacheKey() of the loaded files, empty if unknown.
+
+    // lookup indexes built by buildIndex() after loading
+    std::array<int16_t, 256> m_dataTypeIndex; //!< Data type id -> m_dataTypes index, -1 if unknown.
+    QHash<QString, int> m_dataTypeNameIndex; //!< Data type short name -> m_dataTypes index.
+    QHash<uint, int> m_enumIndex; //!< Enumeration id -> m_enums index.
+    QHash<quint32, int> m_deviceIndex; //!< profile id | device id -> m_devices index, generic devices use profile id 0xFFFF.
+
+    /*!
+        Already filtered results of inCluster() and outCluster(),
+        key: profile id | cluster id | manufacturer code | side.
+     */
+    QHash<quint64, ZclCluster> m_clusterCache;
+    bool m_lazyLoading = false;
+    bool m_internStrings = false;
+    bool m_headless = false;
+    bool m_parallelLoading = false;
+    QSet<QString> m_useZclDomains; //!< Lower case names of domains with explicit useZcl attribute.
+    unsigned m_snapshotVersion = 0;
+    ZclSnapshotPtr m_snapshot; //!< Accessed only via std::atomic_load() and std::atomic_store().
+    QSet<QString> m_internedStrings; //!< Shared instances of schema strings.
+    std::vector<ZclLazyCluster> m_lazyClusters;
+    std::vector<ZclFilePart> m_fileParts; //!< Parsed files in load order, unchanged ones are reused by reloadChanged().
 };
 
 DECONZ_DLLSPEC ZclDataBase * zclDataBase();
+/*! Returns the current ZCLDB snapshot, safe to call from any thread.
+
+    zclDataBase() creates the database on first call and isn't thread safe, it
+    must be called on the main thread before workers use zclSnapshot().
+    Until then an empty snapshot is returned.
+ */
+DECONZ_DLLSPEC ZclSnapshotPtr zclSnapshot();
 
 } //namespace deCONZ
 
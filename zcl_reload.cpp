@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2012-2025 dresden elektronik ingenieurtechnik gmbh.
+ * All rights reserved.
+ *
+ * The software in this package is published under the terms of the BSD
+ * style license a copy of which has been included with this distribution in
+ * the LICENSE.txt file.
+ *
+ */
+
+/*
+ * Incremental reload of the ZCLDB.
+ *
+ * reloadAll() drops the complete database, afterwards every cluster object
+ * handed out before must be considered outdated. reloadChanged() instead
+ * compares the SHA-256 hashes of all source files with the ones of the
+ * last load and does nothing if they are equal. Otherwise only the changed
+ * files are parsed again, the partial databases of unchanged files are
+ * reused (see zcl_parallel.cpp). All parts are merged again in file order
+ * and the result is compared domain by domain against the former state,
+ * only clusters with a different definition are reported.
+ */
+
+#include <QDataStream>
+#include <QSet>
+#include <algorithm>
+#include "deconz/dbg_trace.h"
+#include "deconz/u_sha256.h"
+#include "deconz/zcl.h"
+#include "zcl_private.h"
+
+#define ZCL_SIDE_SERVER 0
+#define ZCL_SIDE_CLIENT 1
+#define ZCL_SIDE_LAZY   2 // not yet parsed <cluster> element, covers both sides
+
+namespace deCONZ {
+
+static QByteArray sha256(const QByteArray &data)
+{
+    QByteArray hash(U_SHA256_HASH_SIZE, '\0');
+    U_Sha256(data.constData(), unsigned(data.size()), reinterpret_cast<unsigned char*>(hash.data()));
+    return hash;
+}
+
+bool ZclChangeSet::contains(uint16_t profileId, uint16_t clusterId, uint16_t mfcode) const
+{
+    if (clusterId < 0xFC00)
+    {
+        mfcode = 0;
+    }
+
+    for (const ZclClusterKey &key : m_clusters)
+    {
+        if (key.profileId == profileId && key.clusterId == clusterId && key.manufacturerCode == mfcode)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*! Returns a hash over all data types and enumerations. */
+QByteArray ZclDataBase::typesDigest() const
+{
+    QByteArray buf;
+    QDataStream stream(&buf, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    for (const ZclDataType &dt : m_dataTypes)
+    {
+        stream << dt.id() << dt.name() << dt.shortname() << qint32(dt.length()) << dt.isAnalog() << dt.isDiscrete();
+    }
+
+    for (const Enumeration &e : m_enums)
+    {
+        stream << quint32(e.id()) << e.name() << e.values();
+    }
+
+    return sha256(buf);
+}
+
+QByteArray ZclDataBase::clusterDigest(const ZclCluster &cl)
+{
+    QByteArray buf;
+    QDataStream stream(&buf, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    writeCluster(stream, cl);
+
+    return 'C' + sha256(buf);
+}
+
+/*! Returns a hash over all clusters of \p dom.
+
+    \param lazyClusters the lazy index \p dom refers to
+    \param clusters receives the hash of each cluster, key: side << 32 | cluster key
+ */
+QByteArray ZclDataBase::domainDigest(const ZclDomain &dom, const std::vector<ZclLazyCluster> &lazyClusters, QHash<quint64, QByteArray> *clusters)
+{
+    clusters->clear();
+
+    for (auto i = dom.m_inClusters.cbegin(); i != dom.m_inClusters.cend(); ++i)
+    {
+        clusters->insert(quint64(ZCL_SIDE_SERVER) << 32 | i.key(), clusterDigest(i.value()));
+    }
+
+    for (auto i = dom.m_outClusters.cbegin(); i != dom.m_outClusters.cend(); ++i)
+    {
+        clusters->insert(quint64(ZCL_SIDE_CLIENT) << 32 | i.key(), clusterDigest(i.value()));
+    }
+
+    for (auto i = dom.m_lazyIndex.cbegin(); i != dom.m_lazyIndex.cend(); ++i)
+    {
+        if (i.value() >= 0 && size_t(i.value()) < lazyClusters.size())
+        {
+            clusters->insert(quint64(ZCL_SIDE_LAZY) << 32 | i.key(), 'L' + lazyClusters[size_t(i.value())].digest);
+        }
+    }
+
+    // QHash order is arbitrary
+    QList<quint64> keys = clusters->keys();
+    std::sort(keys.begin(), keys.end());
+
+    QByteArray buf = dom.m_name.toLower().toUtf8();
+    buf += dom.m_useZcl ? '1' : '0';
+
+    for (const quint64 key : keys)
+    {
+        buf.append(reinterpret_cast<const char*>(&key), sizeof(key));
+        buf += clusters->value(key);
+    }
+
+    return sha256(buf);
+}
+
+/*! Collects clusters of all profiles which differ between \p oldProfiles and the current profiles. */
+void ZclDataBase::diffProfiles(const QHash<uint16_t, ZclProfile> &oldProfiles, const std::vector<ZclLazyCluster> &oldLazyClusters, ZclChangeSet &changes) const
+{
+    QSet<quint64> changed; // profile id << 32 | cluster key
+    QSet<uint16_t> profileIds;
+
+    for (auto i = oldProfiles.cbegin(); i != oldProfiles.cend(); ++i) { profileIds.insert(i.key()); }
+    for (auto i = m_profiles.cbegin(); i != m_profiles.cend(); ++i) { profileIds.insert(i.key()); }
+
+    const ZclDomain noDomain;
+    QHash<quint64, QByteArray> oldClusters;
+    QHash<quint64, QByteArray> newClusters;
+
+    for (const uint16_t profileId : profileIds)
+    {
+        const ZclProfile oldProfile = oldProfiles.value(profileId);
+        const ZclProfile newProfile = m_profiles.value(profileId);
+
+        QStringList names;
+        for (const ZclDomain &dom : oldProfile.domains()) { names.push_back(dom.name().toLower()); }
+        for (const ZclDomain &dom : newProfile.domains()) { names.push_back(dom.name().toLower()); }
+        names.removeDuplicates();
+
+        for (const QString &name : names)
+        {
+            const ZclDomain *oldDom = &noDomain;
+            const ZclDomain *newDom = &noDomain;
+
+            for (const ZclDomain &dom : oldProfile.domains()) { if (dom.name().toLower() == name) { oldDom = &dom; } }
+            for (const ZclDomain &dom : newProfile.domains()) { if (dom.name().toLower() == name) { newDom = &dom; } }
+
+            if (domainDigest(*oldDom, oldLazyClusters, &oldClusters) == domainDigest(*newDom, m_lazyClusters, &newClusters))
+            {
+                continue;
+            }
+
+            DBG_Printf(DBG_ZCLDB, "ZCLDB profile 0x%04X domain %s changed\n", profileId, qPrintable(name));
+
+            for (auto i = oldClusters.cbegin(); i != oldClusters.cend(); ++i)
+            {
+                if (newClusters.value(i.key()) != i.value())
+                {
+                    changed.insert(quint64(profileId) << 32 | (i.key() & 0xFFFFFFFF));
+                }
+            }
+
+            for (auto i = newClusters.cbegin(); i != newClusters.cend(); ++i)
+            {
+                if (!oldClusters.contains(i.key()))
+                {
+                    changed.insert(quint64(profileId) << 32 | (i.key() & 0xFFFFFFFF));
+                }
+            }
+        }
+    }
+
+    QList<quint64> keys = changed.values();
+    std::sort(keys.begin(), keys.end());
+
+    changes.m_clusters.reserve(size_t(keys.size()));
+    for (const quint64 key : keys)
+    {
+        ZclClusterKey ck;
+        ck.profileId = uint16_t(key >> 32);
+        ck.clusterId = uint16_t(key & 0xFFFF);
+        ck.manufacturerCode = uint16_t((key >> 16) & 0xFFFF);
+        changes.m_clusters.push_back(ck);
+    }
+}
+
+/*! Reloads the ZCLDB files listed in \p zclFile if any of them changed.
+
+    In contrast to reloadAll() nothing is done when the files are unchanged,
+    otherwise only the changed files are parsed. The returned change set lists the clusters which differ from
+    the former definition, callers only need to refresh these.
+ */
+ZclChangeSet ZclDataBase::reloadChanged(const QString &zclFile)
+{
+    ZclChangeSet changes;
+    std::vector<QByteArray> hashes;
+    const QStringList files = dbFiles(zclFile);
+    const QByteArray key = cacheKey(files, &hashes);
+
+    if (!key.isEmpty() && key == m_sourceKey)
+    {
+        DBG_Printf(DBG_ZCLDB, "ZCLDB files unchanged, skip reload\n");
+        return changes;
+    }
+
+    // keep the former state for comparison, the lazy index is referenced by the profile domains
+    const QByteArray oldTypes = typesDigest();
+    const QHash<uint16_t, ZclProfile> oldProfiles = m_profiles;
+    const std::vector<ZclLazyCluster> oldLazyClusters = std::move(m_lazyClusters);
+    std::vector<ZclFilePart> parts = std::move(m_fileParts);
+
+    clear();
+    m_fileParts = std::move(parts); // only changed files are parsed
+    loadFiles(files, zclFile + QLatin1String(".cache"), key, hashes);
+
+    changes.m_full = typesDigest() != oldTypes;
+    diffProfiles(oldProfiles, oldLazyClusters, changes);
+    publishSnapshot();
+
+    DBG_Printf(DBG_ZCLDB, "ZCLDB reloaded, %d clusters changed%s\n", int(changes.m_clusters.size()), changes.m_full ? ", data types changed" : "");
+
+    return changes;
+}
+
+} // namespace deCONZ